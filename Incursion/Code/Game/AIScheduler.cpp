@@ -0,0 +1,87 @@
+#include "Game/AIScheduler.hpp"
+#include "Game/GameCommon.hpp"
+#include "Game/Map.hpp"
+#include "Game/JobSystem.hpp"
+#include <algorithm>
+#include <chrono>
+
+//////////////////////////////////////////////////////////////////////////
+AIScheduler::AIScheduler()
+{
+	SetThinkRate( ENTITY_TYPE_NPC_TANK, NPC_TANK_THINK_RATE );
+	SetThinkRate( ENTITY_TYPE_NPC_TURRET, NPC_TURRET_THINK_RATE );
+	SetMaxThinksPerTick( AI_MAX_THINKS_PER_TICK );
+}
+
+//////////////////////////////////////////////////////////////////////////
+void AIScheduler::SetThinkRate( EntityType type, float thinksPerSecond )
+{
+	if( thinksPerSecond <= 0.f )
+	{
+		m_thinkIntervals[type] = 0.f;
+		m_scheduledTypes &= ~GetEntityTypeMask( type );
+		return;
+	}
+	m_thinkIntervals[type] = 1.f / thinksPerSecond;
+	m_scheduledTypes |= GetEntityTypeMask( type );
+}
+
+//////////////////////////////////////////////////////////////////////////
+void AIScheduler::Update( Map* map, float deltaSeconds )
+{
+	m_requests.clear();
+	const Entity* player = map->GetPlayerAlive();
+	float nearPlayerDistSquared = AI_NEAR_PLAYER_DISTANCE * AI_NEAR_PLAYER_DISTANCE;
+	for( Entity* entity : map->GetAliveEntities( m_scheduledTypes ) )
+	{
+		entity->m_secondsSinceLastThink += deltaSeconds;
+		float thinkInterval = m_thinkIntervals[entity->m_type];
+		if( entity->m_hasThought && entity->m_secondsSinceLastThink < thinkInterval )
+			continue;
+
+		ThinkRequest request;
+		request.m_entity = entity;
+		request.m_urgency = entity->m_secondsSinceLastThink / thinkInterval;
+		if( !entity->m_hasThought )
+			request.m_urgency += AI_FIRST_THINK_URGENCY;
+		if( player != nullptr && (player->m_position - entity->m_position).GetLengthSquared() < nearPlayerDistSquared )
+			request.m_urgency *= AI_NEAR_PLAYER_URGENCY_SCALE;
+		m_requests.push_back( request );
+	}
+
+	//most urgent first, ties keep spawn order so the result does not depend on timing
+	std::sort( m_requests.begin(), m_requests.end(), []( const ThinkRequest& a, const ThinkRequest& b )
+	{
+		if( a.m_urgency != b.m_urgency )
+			return a.m_urgency > b.m_urgency;
+		return a.m_entity->m_id < b.m_entity->m_id;
+	} );
+
+	//pick the batch before running it so serial and parallel runs think for the same units
+	int numThinks = std::min( (int)m_requests.size(), std::max( m_maxThinksPerTick, 1 ) );
+	m_thinkBatch.clear();
+	for( int requestID = 0; requestID < numThinks; requestID++ )
+	{
+		m_thinkBatch.push_back( m_requests[requestID].m_entity );
+	}
+
+	auto startTime = std::chrono::steady_clock::now();
+	g_theJobSystem->ParallelFor( numThinks, AI_THINK_GRAIN_SIZE, [this]( int beginIndex, int endIndex )
+	{
+		for( int batchID = beginIndex; batchID < endIndex; batchID++ )
+		{
+			m_thinkBatch[batchID]->Think();
+		}
+	} );
+	int microsecondsUsed = (int)std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now() - startTime ).count();
+
+	for( Entity* entity : m_thinkBatch )
+	{
+		entity->m_secondsSinceLastThink = 0.f;
+		entity->m_hasThought = true;
+	}
+
+	m_numThinksLastFrame = numThinks;
+	m_numDeferredLastFrame = (int)m_requests.size() - numThinks;
+	m_microsecondsUsedLastFrame = microsecondsUsed;
+}
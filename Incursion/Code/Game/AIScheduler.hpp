@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vector>
+#include "Game/Entity.hpp"
+
+class Map;
+
+//////////////////////////////////////////////////////////////////////////
+//spreads AI perception and decisions over frames
+//every scheduled type thinks at its own rate, overdue units think first and units near the player count as more overdue
+//at most m_maxThinksPerTick units think in a tick, picked by urgency and id only, so the same units think on every machine
+//the chosen units then think in parallel: Think only reads the map and writes its own entity, so the result matches a serial run
+//the time the thinks took is measured for the stats overlay only and never feeds back into the choice
+//skipped units are first in line next frame
+class AIScheduler
+{
+public:
+	AIScheduler();
+	~AIScheduler() = default;
+
+	void SetThinkRate( EntityType type, float thinksPerSecond );
+	void SetMaxThinksPerTick( int maxThinksPerTick ) { m_maxThinksPerTick = maxThinksPerTick; }
+	void Update( Map* map, float deltaSeconds );
+
+	int GetNumThinksLastFrame() const			{ return m_numThinksLastFrame; }
+	int GetNumDeferredLastFrame() const			{ return m_numDeferredLastFrame; }
+	int GetMicrosecondsUsedLastFrame() const	{ return m_microsecondsUsedLastFrame; }
+
+private:
+	struct ThinkRequest
+	{
+		Entity* m_entity = nullptr;
+		float m_urgency = 0.f;
+	};
+
+	float m_thinkIntervals[NUM_ENTITY_TYPES] = {};
+	EntityTypeMask m_scheduledTypes = 0;
+	int m_maxThinksPerTick = 0;
+	std::vector<ThinkRequest> m_requests;
+	std::vector<Entity*> m_thinkBatch;
+
+	int m_numThinksLastFrame = 0;
+	int m_numDeferredLastFrame = 0;
+	int m_microsecondsUsedLastFrame = 0;
+};
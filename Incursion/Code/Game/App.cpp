@@ -1,6 +1,8 @@
 #include "Game/App.hpp"
 #include "Game/GameCommon.hpp"
 #include "Game/Game.hpp"
+#include "Game/FrameArena.hpp"
+#include "Game/JobSystem.hpp"
 #include "Engine/Renderer/RenderContext.hpp"
 #include "Engine/Renderer/Camera.hpp"
 #include "Engine/Core/Clock.hpp"
@@ -10,6 +12,7 @@
 #include "Engine/Audio/AudioSystem.hpp"
 #include "Engine/Core/NamedStrings.hpp"
 #include "Engine/Platform/Window.hpp"
+#include <algorithm>
 
 App::App()
 {
@@ -29,6 +32,8 @@ void App::Startup()
     std::string windowTitle = g_gameConfigBlackboard->GetValue("windowTitle", "SD2.A01");
 
     g_theApp = &(*this);						//initialize global App pointer
+	g_theFrameArena = new FrameArena( FRAME_ARENA_SIZE );
+	g_theJobSystem = new JobSystem( std::max( (int)std::thread::hardware_concurrency() - 1, 0 ) );
 	g_theEvents = new EventSystem();
     g_theRenderer = new RenderContext();		//initialize global RendererContext pointer
     g_theInput = new InputSystem();
@@ -86,6 +91,12 @@ void App::Shutdown()
 
 	delete g_theEvents;
 	g_theEvents = nullptr;
+
+	delete g_theFrameArena;
+	g_theFrameArena = nullptr;
+
+	delete g_theJobSystem;
+	g_theJobSystem = nullptr;
 }
 
 void App::RunFrame()
@@ -113,6 +124,7 @@ Vec2 App::GetWindowDimensions() const
 void App::BeginFrame()
 {
 	Clock::BeginFrame();
+	g_theFrameArena->Reset();
 	
 	m_theWindow->BeginFrame();
 	g_theConsole->BeginFrame();
@@ -133,9 +145,11 @@ void App::Update()
 	g_theConsole->Update();
 }
 
-void App::Render() const
+void App::Render()
 {	
+	size_t heapAllocationsBefore = g_heapAllocationCount;
 	g_theGame->Render();
+	m_lastFrameRenderHeapAllocations = (int)(g_heapAllocationCount - heapAllocationsBefore);
 }
 
 void App::EndFrame()
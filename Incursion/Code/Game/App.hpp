@@ -18,14 +18,16 @@ public:
 	bool HandleQuitRequisted();
 
 	Vec2 GetWindowDimensions() const;
+	int  GetLastFrameRenderHeapAllocations() const { return m_lastFrameRenderHeapAllocations; }
 
 private:
 	void BeginFrame();
 	void Update();
-	void Render() const;
+	void Render();
 	void EndFrame();
 
 	//Variables
 	bool  m_isQuiting = false;
+	int   m_lastFrameRenderHeapAllocations = 0;
 	Window* m_theWindow = nullptr;
 };
\ No newline at end of file
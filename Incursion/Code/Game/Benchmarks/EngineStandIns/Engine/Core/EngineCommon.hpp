@@ -0,0 +1,2 @@
+#pragma once
+//stand-in for the engine header, the game code built by the benchmarks only needs it to exist
@@ -0,0 +1,15 @@
+#pragma once
+//stand-in for the engine IntVec2, only what the game code built by the benchmarks uses
+
+struct IntVec2
+{
+public:
+	int x = 0;
+	int y = 0;
+
+public:
+	IntVec2() = default;
+	IntVec2( int initialX, int initialY ) :x(initialX), y(initialY) {}
+
+	IntVec2 operator+( const IntVec2& other ) const { return IntVec2( x + other.x, y + other.y ); }
+};
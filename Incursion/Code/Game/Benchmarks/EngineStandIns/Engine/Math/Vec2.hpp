@@ -0,0 +1,18 @@
+#pragma once
+//stand-in for the engine Vec2, only what the game code built by the benchmarks uses
+
+struct Vec2
+{
+public:
+	float x = 0.f;
+	float y = 0.f;
+
+public:
+	Vec2() = default;
+	Vec2( float initialX, float initialY ) :x(initialX), y(initialY) {}
+
+	Vec2 operator+( const Vec2& other ) const { return Vec2( x + other.x, y + other.y ); }
+	Vec2 operator-( const Vec2& other ) const { return Vec2( x - other.x, y - other.y ); }
+	Vec2 operator*( float scale ) const { return Vec2( x * scale, y * scale ); }
+	float GetLengthSquared() const { return x * x + y * y; }
+};
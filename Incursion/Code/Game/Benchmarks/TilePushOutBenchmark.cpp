@@ -0,0 +1,306 @@
+//the tile push-out of the game (TilePushOut.cpp, built into this benchmark) against the Tile and TileDefinition push-out
+//it replaced, timed on a level 1 style map
+#include "Game/TilePushOut.hpp"
+#include "Game/TileStorage.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+//TileStorage::NEIGHBOR_OFFSETS is defined with the map file code, which this benchmark does not build
+static const IntVec2 NEIGHBOR_OFFSETS[8] = {
+	IntVec2( 1,0 ),IntVec2( 0,1 ),IntVec2( -1,0 ),IntVec2( 0,-1 ),
+	IntVec2( 1,1 ),IntVec2( -1,1 ),IntVec2( -1,-1 ),IntVec2( 1,-1 )
+};
+
+//////////////////////////////////////////////////////////////////////////
+//the baseline: one Tile per tile and a TileDefinition lookup per neighbor, general disc out of box push
+namespace OldPushOut
+{
+	struct AABB2
+	{
+		Vec2 mins;
+		Vec2 maxs;
+	};
+
+	struct Tile
+	{
+		IntVec2  m_tileCoords;
+		TileType m_type = TILE_TYPE_GRASS;
+		AABB2 GetBounds() const
+		{
+			float x = (float)m_tileCoords.x;
+			float y = (float)m_tileCoords.y;
+			return AABB2{ Vec2( x, y ), Vec2( x + 1.f, y + 1.f ) };
+		}
+	};
+
+	//same size as the game's definition, so the lookups touch as many cache lines
+	struct TileDefinition
+	{
+		TileType m_type;
+		unsigned char m_tint[4];
+		bool m_isSolid;
+		float m_speedFactor;
+		bool m_isEnemySpawnable;
+		const void* m_texture;
+		Vec2 m_uvAtMins;
+		Vec2 m_uvAtMaxs;
+	};
+
+	std::vector<TileDefinition> s_definitions;
+	std::vector<Tile> s_tiles;
+	IntVec2 s_size;
+
+	int GetTileIndexForTileCoords( const IntVec2& tileCoords )
+	{
+		int index = s_size.x * tileCoords.y + tileCoords.x;
+		int totalNums = s_size.x * s_size.y - 1;
+		if( index > totalNums )
+			index = totalNums;
+		return index;
+	}
+
+	void PushDiscOutOfAABB2D( Vec2& center, float radius, const AABB2& box )
+	{
+		Vec2 nearest( fminf( fmaxf( center.x, box.mins.x ), box.maxs.x ), fminf( fmaxf( center.y, box.mins.y ), box.maxs.y ) );
+		Vec2 nearestToCenter = center - nearest;
+		float distSquared = nearestToCenter.GetLengthSquared();
+		if( distSquared >= radius * radius || distSquared == 0.f )
+			return;
+		center = nearest + nearestToCenter * (radius / sqrtf( distSquared ));
+	}
+
+	void PushDiscOutOfSolidNeighbors( Vec2& position, float radius )
+	{
+		IntVec2 posCoords( (int)floorf( position.x ), (int)floorf( position.y ) );
+		for( int searchID = 0; searchID < 8; searchID++ )
+		{
+			int tileID = GetTileIndexForTileCoords( posCoords + NEIGHBOR_OFFSETS[searchID] );
+			if( tileID >= s_size.x * s_size.y || tileID < 0 )
+				continue;
+			Tile& tile = s_tiles[tileID];
+			if( s_definitions[tile.m_type].m_isSolid )
+				PushDiscOutOfAABB2D( position, radius, tile.GetBounds() );
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+//the current tree: masks read from TileChunk records laid out as TileStorage does, pushed out by the game's TilePushOut
+namespace NewPushOut
+{
+	IntVec2 s_dimensions;
+	IntVec2 s_chunkDimensions;
+	std::vector<const TileChunk*> s_chunks;
+	std::vector<std::unique_ptr<TileChunk>> s_ownedChunks;
+
+	bool IsInBounds( const IntVec2& tileCoords )
+	{
+		return tileCoords.x >= 0 && tileCoords.y >= 0 && tileCoords.x < s_dimensions.x && tileCoords.y < s_dimensions.y;
+	}
+
+	size_t GetChunkIndex( const IntVec2& tileCoords )
+	{
+		return (size_t)(tileCoords.y >> TILE_CHUNK_SIZE_LOG2) * (size_t)s_chunkDimensions.x + (size_t)(tileCoords.x >> TILE_CHUNK_SIZE_LOG2);
+	}
+
+	int GetLocalIndex( const IntVec2& tileCoords )
+	{
+		return ((tileCoords.y & (TILE_CHUNK_SIZE - 1)) << TILE_CHUNK_SIZE_LOG2) | (tileCoords.x & (TILE_CHUNK_SIZE - 1));
+	}
+
+	//the lookup of TileStorage::GetSolidNeighborMask
+	uint8_t GetSolidNeighborMask( const IntVec2& tileCoords )
+	{
+		if( !IsInBounds( tileCoords ) )
+			return 0;
+		return s_chunks[GetChunkIndex( tileCoords )]->m_solidNeighborMasks[GetLocalIndex( tileCoords )];
+	}
+
+	//what Map::ResolveEntityTileCollision does
+	void PushDiscOutOfSolidNeighbors( Vec2& position, float radius )
+	{
+		IntVec2 posCoords( (int)floorf( position.x ), (int)floorf( position.y ) );
+		::PushDiscOutOfSolidNeighbors( position, radius, posCoords, GetSolidNeighborMask( posCoords ) );
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+//20 x 30 grass with a stone frame, 30 stone worms of 6 and 20 mud worms of 7, the start and exit corners cleared
+static std::vector<TileType> BuildLevelOneLayout( const IntVec2& size, uint32_t seed )
+{
+	std::mt19937 rng( seed );
+	std::vector<TileType> types( (size_t)size.x * size.y, TILE_TYPE_GRASS );
+	auto setType = [&]( const IntVec2& coords, TileType type ) { types[coords.x + coords.y * size.x] = type; };
+	auto isEdge = [&]( const IntVec2& coords ) { return coords.x <= 0 || coords.y <= 0 || coords.x >= size.x - 1 || coords.y >= size.y - 1; };
+	for( int tileX = 0; tileX < size.x; tileX++ )
+	{
+		setType( IntVec2( tileX, 0 ), TILE_TYPE_STONE );
+		setType( IntVec2( tileX, size.y - 1 ), TILE_TYPE_STONE );
+	}
+	for( int tileY = 0; tileY < size.y; tileY++ )
+	{
+		setType( IntVec2( 0, tileY ), TILE_TYPE_STONE );
+		setType( IntVec2( size.x - 1, tileY ), TILE_TYPE_STONE );
+	}
+	struct Worm { TileType m_type; int m_count; int m_length; };
+	const Worm worms[] = { { TILE_TYPE_STONE, 30, 6 }, { TILE_TYPE_MUD, 20, 7 } };
+	for( const Worm& worm : worms )
+	{
+		for( int wormID = 0; wormID < worm.m_count; wormID++ )
+		{
+			IntVec2 coords( 1 + (int)(rng() % (uint32_t)(size.x - 2)), 1 + (int)(rng() % (uint32_t)(size.y - 2)) );
+			for( int stepID = 0; stepID < worm.m_length; stepID++ )
+			{
+				setType( coords, worm.m_type );
+				IntVec2 next = coords + NEIGHBOR_OFFSETS[rng() % 4];
+				if( !isEdge( next ) )
+					coords = next;
+			}
+		}
+	}
+	for( int offsetX = 1; offsetX < 6; offsetX++ )
+	{
+		for( int offsetY = 1; offsetY < 6; offsetY++ )
+		{
+			bool isWall = (offsetX == 4 && offsetY > 1 && offsetY < 5) || (offsetY == 4 && offsetX > 1 && offsetX < 5);
+			setType( IntVec2( offsetX, offsetY ), isWall ? TILE_TYPE_STONE : TILE_TYPE_GROUND );
+			setType( IntVec2( size.x - 1 - offsetX, size.y - 1 - offsetY ), isWall ? TILE_TYPE_STONE : TILE_TYPE_GROUND );
+		}
+	}
+	return types;
+}
+
+//////////////////////////////////////////////////////////////////////////
+static void StartupBothVersions( const IntVec2& size, const std::vector<TileType>& types )
+{
+	OldPushOut::s_definitions.clear();
+	for( int typeID = 0; typeID < (int)NUM_TILE_TYPE; typeID++ )
+	{
+		OldPushOut::TileDefinition definition = {};
+		definition.m_type = (TileType)typeID;
+		definition.m_isSolid = typeID == TILE_TYPE_STONE;
+		OldPushOut::s_definitions.push_back( definition );
+	}
+	OldPushOut::s_size = size;
+	OldPushOut::s_tiles.clear();
+	for( int tileIndex = 0; tileIndex < size.x * size.y; tileIndex++ )
+	{
+		OldPushOut::Tile tile;
+		tile.m_tileCoords = IntVec2( tileIndex % size.x, tileIndex / size.x );
+		tile.m_type = types[tileIndex];
+		OldPushOut::s_tiles.push_back( tile );
+	}
+
+	using namespace NewPushOut;
+	s_dimensions = size;
+	s_chunkDimensions = IntVec2( (size.x + TILE_CHUNK_SIZE - 1) >> TILE_CHUNK_SIZE_LOG2, (size.y + TILE_CHUNK_SIZE - 1) >> TILE_CHUNK_SIZE_LOG2 );
+	s_ownedChunks.clear();
+	s_chunks.clear();
+	for( int chunkIndex = 0; chunkIndex < s_chunkDimensions.x * s_chunkDimensions.y; chunkIndex++ )
+	{
+		s_ownedChunks.push_back( std::make_unique<TileChunk>() );
+		s_chunks.push_back( s_ownedChunks.back().get() );
+	}
+	auto isSolid = [&]( const IntVec2& coords ) { return !IsInBounds( coords ) || types[coords.x + coords.y * size.x] == TILE_TYPE_STONE; };
+	for( int tileY = 0; tileY < size.y; tileY++ )
+	{
+		for( int tileX = 0; tileX < size.x; tileX++ )
+		{
+			IntVec2 coords( tileX, tileY );
+			uint8_t solidMask = 0;
+			for( int neighborID = 0; neighborID < 8; neighborID++ )
+			{
+				if( isSolid( coords + NEIGHBOR_OFFSETS[neighborID] ) )
+					solidMask |= (uint8_t)(1 << neighborID);
+			}
+			TileChunk& chunk = *s_ownedChunks[GetChunkIndex( coords )];
+			chunk.m_types[GetLocalIndex( coords )] = (uint8_t)types[tileX + tileY * size.x];
+			chunk.m_solidNeighborMasks[GetLocalIndex( coords )] = solidMask;
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+template<typename PushOutFunction>
+static double MeasureNanosecondsPerPush( const std::vector<Vec2>& positions, float radius, int numRepeats, PushOutFunction pushOut, std::vector<Vec2>& out_results )
+{
+	double bestNanoseconds = 1e30;
+	for( int repeat = 0; repeat < numRepeats; repeat++ )
+	{
+		out_results = positions;
+		auto startTime = std::chrono::steady_clock::now();
+		for( Vec2& position : out_results )
+		{
+			pushOut( position, radius );
+		}
+		std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - startTime;
+		bestNanoseconds = elapsed.count() < bestNanoseconds ? elapsed.count() : bestNanoseconds;
+	}
+	return bestNanoseconds / (double)positions.size();
+}
+
+//////////////////////////////////////////////////////////////////////////
+//TilePushOutBenchmark [numPositions] [numRepeats]
+int main( int argc, char** argv )
+{
+	//a few times the entities of a level, small enough to stay in cache like the entity lists of one tick
+	int numPositions = argc > 1 ? atoi( argv[1] ) : 1024;
+	int numRepeats = argc > 2 ? atoi( argv[2] ) : 5000;
+	const IntVec2 size( 20, 30 );
+	const float radius = .29f;
+	std::vector<TileType> types = BuildLevelOneLayout( size, 1 );
+	StartupBothVersions( size, types );
+
+	//disc centers anywhere on walkable tiles, where tanks and the player end up after moving
+	std::mt19937 rng( 7 );
+	std::uniform_real_distribution<float> unit( 0.f, 1.f );
+	std::vector<Vec2> allPositions;
+	std::vector<Vec2> wallPositions;
+	while( (int)allPositions.size() < numPositions )
+	{
+		Vec2 position( unit( rng ) * (float)size.x, unit( rng ) * (float)size.y );
+		IntVec2 coords( (int)position.x, (int)position.y );
+		if( types[coords.x + coords.y * size.x] == TILE_TYPE_STONE )
+			continue;
+		allPositions.push_back( position );
+		if( NewPushOut::GetSolidNeighborMask( coords ) != 0 )
+			wallPositions.push_back( position );
+	}
+
+	int numWalkable = 0;
+	int numNextToWall = 0;
+	for( int tileIndex = 0; tileIndex < size.x * size.y; tileIndex++ )
+	{
+		IntVec2 coords( tileIndex % size.x, tileIndex / size.x );
+		if( types[tileIndex] == TILE_TYPE_STONE )
+			continue;
+		numWalkable++;
+		numNextToWall += NewPushOut::GetSolidNeighborMask( coords ) != 0 ? 1 : 0;
+	}
+	printf( "%d x %d level 1 layout: %d walkable tiles, %d of them next to a wall\n", size.x, size.y, numWalkable, numNextToWall );
+
+	std::vector<Vec2> oldResults;
+	std::vector<Vec2> newResults;
+	const char* labels[2] = { "all walkable positions", "positions next to walls" };
+	const std::vector<Vec2>* positionSets[2] = { &allPositions, &wallPositions };
+	for( int setID = 0; setID < 2; setID++ )
+	{
+		const std::vector<Vec2>& positions = *positionSets[setID];
+		double oldNanoseconds = MeasureNanosecondsPerPush( positions, radius, numRepeats, OldPushOut::PushDiscOutOfSolidNeighbors, oldResults );
+		double newNanoseconds = MeasureNanosecondsPerPush( positions, radius, numRepeats, NewPushOut::PushDiscOutOfSolidNeighbors, newResults );
+		float maxDifference = 0.f;
+		for( size_t positionID = 0; positionID < positions.size(); positionID++ )
+		{
+			maxDifference = fmaxf( maxDifference, fmaxf( fabsf( oldResults[positionID].x - newResults[positionID].x ), fabsf( oldResults[positionID].y - newResults[positionID].y ) ) );
+		}
+		printf( "%-24s %8d pushes  old %6.2f ns  new %6.2f ns  speedup %5.2fx  max difference %g\n", labels[setID], (int)positions.size(),
+			oldNanoseconds, newNanoseconds, oldNanoseconds / newNanoseconds, maxDifference );
+	}
+	return 0;
+}
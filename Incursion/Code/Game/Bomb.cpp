@@ -1,9 +1,9 @@
 #include "Game/Bomb.hpp"
 #include "Game/Map.hpp"
+#include "Game/Game.hpp"
+#include "Engine/Renderer/RenderContext.hpp"
 #include "Engine/Core/Vertex_PCU.hpp"
-#include "Engine/Renderer/Texture.hpp"
 #include "Engine/Renderer/SpriteSheet.hpp"
-#include "Engine/Renderer/RenderContext.hpp"
 #include "Engine/Math/AABB2.hpp"
 
 //////////////////////////////////////////////////////////////////////////
@@ -15,10 +15,8 @@ Bomb::Bomb( Map* map, const Vec2& startPos, EntityFaction faction, EntityType ty
 	m_physicsRadius = PICKUP_RADIUS;
 	m_isHitByBullets = true;
 
-	Texture* texture = g_theRenderer->CreateOrGetTextureFromFile( "Data/Images/Extras_4x4.png" );
-	const SpriteSheet* sheet = new SpriteSheet( *texture, IntVec2( 4, 4 ) );
 	Vec2 uvAtMins, uvAtMaxs;
-	sheet->GetSpriteUVs( uvAtMins, uvAtMaxs, 13 );
+	g_theGame->GetExtrasSpriteSheet().GetSpriteUVs( uvAtMins, uvAtMaxs, 13 );
 	Rgba8 tint = GetFactionColor();
 	AppendVertsForAABB2D( m_verts, AABB2( -m_cosmeticRadius, -m_cosmeticRadius, m_cosmeticRadius, m_cosmeticRadius ),
 		uvAtMins, uvAtMaxs, tint );
@@ -27,23 +25,23 @@ Bomb::Bomb( Map* map, const Vec2& startPos, EntityFaction faction, EntityType ty
 //////////////////////////////////////////////////////////////////////////
 void Bomb::Update( float deltaSeconds )
 {
-	if( m_livingTime > BOMB_EXPLOSION_TIME&& m_theMap->IsPointInSolid( m_position ) )
-	{
-		Die();
-	}
-
 	if( !IsAlive() )
 		return;
 
 	Entity::Update( deltaSeconds );
-}
 
-//////////////////////////////////////////////////////////////////////////
-void Bomb::Render() const
-{
-	Texture* texture = g_theRenderer->CreateOrGetTextureFromFile( "Data/Images/Extras_4x4.png" );
-	g_theRenderer->BindDiffuseTexture( texture );
-	Entity::Render();
+	//armed bombs go off where their center enters a wall, like the old point in solid test but swept so they cannot skip thin walls
+	//the sweep is a point and not the physics disc, a bomb grazing a wall keeps flying
+	if( m_livingTime > BOMB_EXPLOSION_TIME )
+	{
+		Vec2 displacement = m_position - m_positionBeforeMove;
+		float impactFraction = 1.f;
+		if( m_theMap->SweepDiscAgainstTiles( m_positionBeforeMove, 0.f, displacement, impactFraction ) )
+		{
+			m_position = m_positionBeforeMove + displacement * impactFraction;
+			Die();
+		}
+	}
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -10,6 +10,5 @@ public:
 	~Bomb() = default;
 
 	virtual void Update( float deltaSeconds )override;
-	virtual void Render()const override;
 	virtual void Die() override;
 };
\ No newline at end of file
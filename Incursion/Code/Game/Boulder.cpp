@@ -1,5 +1,6 @@
 #include "Game/Boulder.hpp"
 #include "Game/GameCommon.hpp"
+#include "Game/Game.hpp"
 #include "Engine/Renderer/RenderContext.hpp"
 #include "Engine/Renderer/SpriteDefinition.hpp"
 #include "Engine/Renderer/SpriteSheet.hpp"
@@ -18,18 +19,8 @@ Boulder::Boulder( Map* map, const Vec2& startPos, EntityFaction faction, EntityT
 
 	float halfBaseSize = m_cosmeticRadius;
 	AABB2 bounds( Vec2( -halfBaseSize, -halfBaseSize ), Vec2( halfBaseSize, halfBaseSize ) );
-	Texture* extraTexture = g_theRenderer->CreateOrGetTextureFromFile( "Data/Images/Extras_4x4.png" );
-	SpriteSheet* extraSheet = new SpriteSheet( *extraTexture, IntVec2( 4, 4 ) );
 	Vec2 uvAtMins;
 	Vec2 uvAtMaxs;
-	extraSheet->GetSpriteUVs( uvAtMins, uvAtMaxs, 3 );
+	g_theGame->GetExtrasSpriteSheet().GetSpriteUVs( uvAtMins, uvAtMaxs, 3 );
 	AppendVertsForAABB2D( m_verts, bounds,uvAtMins,uvAtMaxs );
 }
-
-//////////////////////////////////////////////////////////////////////////
-void Boulder::Render() const
-{
-	Texture* extraTexture = g_theRenderer->CreateOrGetTextureFromFile( "Data/Images/Extras_4x4.png" );
-	g_theRenderer->BindDiffuseTexture( extraTexture );
-	Entity::Render();
-}
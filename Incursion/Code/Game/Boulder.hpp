@@ -7,5 +7,4 @@ class Boulder : public Entity
 public:
 	Boulder( Map* map, const Vec2& startPos, EntityFaction faction, EntityType type );
 
-	virtual void Render() const override;
 };
\ No newline at end of file
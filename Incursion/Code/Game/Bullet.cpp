@@ -22,30 +22,13 @@ Bullet::Bullet( Map* map, const Vec2& startPosition, EntityFaction faction,Entit
 //////////////////////////////////////////////////////////////////////////
 void Bullet::Update( float deltaSeconds )
 {
-	if( m_theMap->IsPointInSolid( m_position ) )
-	{
-		Die();
-	}
-
 	if( !IsAlive() )
 		return;
 
+	//walls and targets are found by the swept test in Map, never by sampling the end point
 	Entity::Update( deltaSeconds );
 }
 
-//////////////////////////////////////////////////////////////////////////
-void Bullet::Render() const
-{
-	Texture* bulletTexture = nullptr;
-	if(m_faction==FACTION_EVIL )
-		bulletTexture = g_theRenderer->CreateOrGetTextureFromFile( "Data/Images/EnemyBullet.png" );
-	else if(m_faction==FACTION_GOOD )
-		bulletTexture = g_theRenderer->CreateOrGetTextureFromFile( "Data/Images/FriendlyBullet.png" );
-	g_theRenderer->BindDiffuseTexture( bulletTexture );
-
-	Entity::Render();
-}
-
 //////////////////////////////////////////////////////////////////////////
 void Bullet::Die()
 {
@@ -9,6 +9,5 @@ public:
 	~Bullet() = default;
 
 	virtual void Update( float deltaSeconds ) override;
-	virtual void Render() const override;
 	virtual void Die() override;
 };
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include "Engine/Math/IntVec2.hpp"
+#include "Game/GameCommon.hpp"
+
+//////////////////////////////////////////////////////////////////////////
+//one value per tile in TILE_CHUNK_SIZE square chunks, same grid as TileStorage, a chunk is allocated on its first write
+//chunks never written read as the default value, so starting a layer costs one pointer per chunk on maps of any size
+//a chunk keeps its tiles row by row, TILE_CHUNK_SIZE values per row, callers check bounds first
+template<typename T>
+class ChunkedTileLayer
+{
+public:
+	ChunkedTileLayer() = default;
+	~ChunkedTileLayer() = default;
+
+	void Startup( const IntVec2& dimensions, const T& defaultValue );
+	void Shutdown();
+	//every chunk is dropped, all tiles read the default value again
+	void Reset();
+
+	bool IsStarted() const { return !m_chunks.empty(); }
+	bool IsChunkAllocated( const IntVec2& tileCoords ) const { return m_chunks[GetChunkIndex( tileCoords )] != nullptr; }
+	T    GetValue( const IntVec2& tileCoords ) const;
+	T&   GetWritableValue( const IntVec2& tileCoords ) { return GetWritableChunkRow( tileCoords )[0]; }
+	//the tile and the ones after it in its chunk row, TILE_CHUNK_SIZE - (tileCoords.x & (TILE_CHUNK_SIZE - 1)) values
+	T*   GetWritableChunkRow( const IntVec2& tileCoords );
+
+private:
+	IntVec2 m_chunkDimensions;
+	T m_defaultValue = T();
+	std::vector<std::unique_ptr<T[]>> m_chunks;
+
+	size_t GetChunkIndex( const IntVec2& tileCoords ) const;
+	static int GetLocalIndex( const IntVec2& tileCoords );
+};
+
+//////////////////////////////////////////////////////////////////////////
+template<typename T>
+void ChunkedTileLayer<T>::Startup( const IntVec2& dimensions, const T& defaultValue )
+{
+	m_chunkDimensions.x = (dimensions.x + TILE_CHUNK_SIZE - 1) >> TILE_CHUNK_SIZE_LOG2;
+	m_chunkDimensions.y = (dimensions.y + TILE_CHUNK_SIZE - 1) >> TILE_CHUNK_SIZE_LOG2;
+	m_defaultValue = defaultValue;
+	m_chunks.clear();
+	m_chunks.resize( (size_t)m_chunkDimensions.x * (size_t)m_chunkDimensions.y );
+}
+
+//////////////////////////////////////////////////////////////////////////
+template<typename T>
+void ChunkedTileLayer<T>::Shutdown()
+{
+	m_chunkDimensions = IntVec2( 0, 0 );
+	m_chunks.clear();
+	m_chunks.shrink_to_fit();
+}
+
+//////////////////////////////////////////////////////////////////////////
+template<typename T>
+void ChunkedTileLayer<T>::Reset()
+{
+	for( std::unique_ptr<T[]>& chunk : m_chunks )
+	{
+		chunk.reset();
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+template<typename T>
+T ChunkedTileLayer<T>::GetValue( const IntVec2& tileCoords ) const
+{
+	const std::unique_ptr<T[]>& chunk = m_chunks[GetChunkIndex( tileCoords )];
+	return chunk != nullptr ? chunk[GetLocalIndex( tileCoords )] : m_defaultValue;
+}
+
+//////////////////////////////////////////////////////////////////////////
+template<typename T>
+T* ChunkedTileLayer<T>::GetWritableChunkRow( const IntVec2& tileCoords )
+{
+	std::unique_ptr<T[]>& chunk = m_chunks[GetChunkIndex( tileCoords )];
+	if( chunk == nullptr )
+	{
+		chunk = std::make_unique<T[]>( TILE_CHUNK_NUM_TILES );
+		std::fill( chunk.get(), chunk.get() + TILE_CHUNK_NUM_TILES, m_defaultValue );
+	}
+	return chunk.get() + GetLocalIndex( tileCoords );
+}
+
+//////////////////////////////////////////////////////////////////////////
+template<typename T>
+size_t ChunkedTileLayer<T>::GetChunkIndex( const IntVec2& tileCoords ) const
+{
+	return (size_t)(tileCoords.y >> TILE_CHUNK_SIZE_LOG2) * (size_t)m_chunkDimensions.x + (size_t)(tileCoords.x >> TILE_CHUNK_SIZE_LOG2);
+}
+
+//////////////////////////////////////////////////////////////////////////
+template<typename T>
+int ChunkedTileLayer<T>::GetLocalIndex( const IntVec2& tileCoords )
+{
+	return ((tileCoords.y & (TILE_CHUNK_SIZE - 1)) << TILE_CHUNK_SIZE_LOG2) | (tileCoords.x & (TILE_CHUNK_SIZE - 1));
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "Game/Entity.hpp"
+#include "Game/GameCommon.hpp"
+
+//////////////////////////////////////////////////////////////////////////
+//what happens when two entities meet, Map keeps one handler per value
+enum CollisionPairHandler : unsigned char
+{
+	COLLISION_PAIR_NONE,
+	COLLISION_PAIR_PUSH,
+	COLLISION_PAIR_BULLET_HIT,
+	COLLISION_PAIR_BULLET_DEFLECT,
+	COLLISION_PAIR_BOMB_CONTACT,
+	COLLISION_PAIR_PICKUP_COLLECT,
+
+	NUM_COLLISION_PAIR_HANDLERS
+};
+
+struct CollisionPairRule
+{
+	EntityType m_typeA;
+	EntityType m_typeB;
+	CollisionPairHandler m_handler;
+	bool m_requiresDifferentFaction;
+	//the rule also applies with A and B swapped
+	bool m_isBothWays;
+	//dropped for the player while physics is disabled
+	bool m_isPhysical;
+};
+
+//types whose contacts come from sweeping their last move instead of overlapping at the end of it
+//their rules must require different factions, the sweep filters by faction before it sees the rule
+constexpr EntityTypeMask COLLISION_SWEPT_TYPE_MASK = GetEntityTypeMask( ENTITY_TYPE_GOOD_BULLET ) | GetEntityTypeMask( ENTITY_TYPE_EVIL_BULLET );
+//bombs are overlap tested, they hit bullets so they cannot be swept too, and they are slow enough not to need it:
+//closing on a bullet head on, one tick moves them less than their radii, so no pair can pass through each other unseen
+static_assert( 2.f * BULLET_SPEED * SIMULATION_TICK_SECONDS < PICKUP_RADIUS + BULLET_PHYSICS_RADIUS, "bombs fast enough to tunnel have to be swept" );
+
+//////////////////////////////////////////////////////////////////////////
+//the collision data, one row per interacting pair, a new entity type adds rows here and nothing to the collision loops
+constexpr CollisionPairRule COLLISION_PAIR_RULES[] =
+{
+	//A                          B                          Handler                        DiffFaction BothWays Physical
+	{ ENTITY_TYPE_PLAYER,        ENTITY_TYPE_PLAYER,        COLLISION_PAIR_PUSH,           false,      true,    true },
+	{ ENTITY_TYPE_PLAYER,        ENTITY_TYPE_NPC_TANK,      COLLISION_PAIR_PUSH,           false,      true,    true },
+	{ ENTITY_TYPE_PLAYER,        ENTITY_TYPE_NPC_TURRET,    COLLISION_PAIR_PUSH,           false,      true,    true },
+	{ ENTITY_TYPE_PLAYER,        ENTITY_TYPE_BOULDER,       COLLISION_PAIR_PUSH,           false,      true,    true },
+	{ ENTITY_TYPE_NPC_TANK,      ENTITY_TYPE_NPC_TANK,      COLLISION_PAIR_PUSH,           false,      true,    true },
+	{ ENTITY_TYPE_NPC_TANK,      ENTITY_TYPE_NPC_TURRET,    COLLISION_PAIR_PUSH,           false,      true,    true },
+	{ ENTITY_TYPE_NPC_TANK,      ENTITY_TYPE_BOULDER,       COLLISION_PAIR_PUSH,           false,      true,    true },
+	{ ENTITY_TYPE_NPC_TURRET,    ENTITY_TYPE_NPC_TURRET,    COLLISION_PAIR_PUSH,           false,      true,    true },
+	{ ENTITY_TYPE_NPC_TURRET,    ENTITY_TYPE_BOULDER,       COLLISION_PAIR_PUSH,           false,      true,    true },
+	{ ENTITY_TYPE_BOULDER,       ENTITY_TYPE_BOULDER,       COLLISION_PAIR_PUSH,           false,      true,    true },
+
+	{ ENTITY_TYPE_GOOD_BULLET,   ENTITY_TYPE_PLAYER,        COLLISION_PAIR_BULLET_HIT,     true,       false,   true },
+	{ ENTITY_TYPE_GOOD_BULLET,   ENTITY_TYPE_NPC_TANK,      COLLISION_PAIR_BULLET_HIT,     true,       false,   true },
+	{ ENTITY_TYPE_GOOD_BULLET,   ENTITY_TYPE_NPC_TURRET,    COLLISION_PAIR_BULLET_HIT,     true,       false,   true },
+	{ ENTITY_TYPE_GOOD_BULLET,   ENTITY_TYPE_BOULDER,       COLLISION_PAIR_BULLET_DEFLECT, true,       false,   true },
+	{ ENTITY_TYPE_GOOD_BULLET,   ENTITY_TYPE_BOMB,          COLLISION_PAIR_BULLET_HIT,     true,       false,   true },
+	{ ENTITY_TYPE_GOOD_BULLET,   ENTITY_TYPE_PICKUP,        COLLISION_PAIR_BULLET_HIT,     true,       false,   true },
+	{ ENTITY_TYPE_EVIL_BULLET,   ENTITY_TYPE_PLAYER,        COLLISION_PAIR_BULLET_HIT,     true,       false,   true },
+	{ ENTITY_TYPE_EVIL_BULLET,   ENTITY_TYPE_NPC_TANK,      COLLISION_PAIR_BULLET_HIT,     true,       false,   true },
+	{ ENTITY_TYPE_EVIL_BULLET,   ENTITY_TYPE_NPC_TURRET,    COLLISION_PAIR_BULLET_HIT,     true,       false,   true },
+	{ ENTITY_TYPE_EVIL_BULLET,   ENTITY_TYPE_BOULDER,       COLLISION_PAIR_BULLET_DEFLECT, true,       false,   true },
+	{ ENTITY_TYPE_EVIL_BULLET,   ENTITY_TYPE_BOMB,          COLLISION_PAIR_BULLET_HIT,     true,       false,   true },
+	{ ENTITY_TYPE_EVIL_BULLET,   ENTITY_TYPE_PICKUP,        COLLISION_PAIR_BULLET_HIT,     true,       false,   true },
+
+	{ ENTITY_TYPE_BOMB,          ENTITY_TYPE_PLAYER,        COLLISION_PAIR_BOMB_CONTACT,   true,       false,   true },
+	{ ENTITY_TYPE_BOMB,          ENTITY_TYPE_NPC_TANK,      COLLISION_PAIR_BOMB_CONTACT,   true,       false,   true },
+	{ ENTITY_TYPE_BOMB,          ENTITY_TYPE_NPC_TURRET,    COLLISION_PAIR_BOMB_CONTACT,   true,       false,   true },
+	{ ENTITY_TYPE_BOMB,          ENTITY_TYPE_BOULDER,       COLLISION_PAIR_BOMB_CONTACT,   true,       false,   true },
+	{ ENTITY_TYPE_BOMB,          ENTITY_TYPE_GOOD_BULLET,   COLLISION_PAIR_BOMB_CONTACT,   true,       false,   true },
+	{ ENTITY_TYPE_BOMB,          ENTITY_TYPE_EVIL_BULLET,   COLLISION_PAIR_BOMB_CONTACT,   true,       false,   true },
+	{ ENTITY_TYPE_BOMB,          ENTITY_TYPE_BOMB,          COLLISION_PAIR_BOMB_CONTACT,   true,       false,   true },
+
+	{ ENTITY_TYPE_PICKUP,        ENTITY_TYPE_PLAYER,        COLLISION_PAIR_PICKUP_COLLECT, false,      false,   false },
+	{ ENTITY_TYPE_PICKUP,        ENTITY_TYPE_NPC_TANK,      COLLISION_PAIR_PICKUP_COLLECT, false,      false,   false },
+};
+
+//////////////////////////////////////////////////////////////////////////
+//the rule table flattened per type pair, built by the compiler so the hot loops only read it
+struct CollisionMatrix
+{
+	//types each type collides with as entity A
+	EntityTypeMask m_masks[NUM_ENTITY_TYPES] = {};
+	//the same without physical pairs that involve the player, for the physics debug option
+	EntityTypeMask m_ghostPlayerMasks[NUM_ENTITY_TYPES] = {};
+	CollisionPairHandler m_handlers[NUM_ENTITY_TYPES][NUM_ENTITY_TYPES] = {};
+	bool m_requiresDifferentFaction[NUM_ENTITY_TYPES][NUM_ENTITY_TYPES] = {};
+
+	constexpr EntityTypeMask GetMask( EntityType type, bool isPhysicsEnabled ) const
+	{
+		return isPhysicsEnabled ? m_masks[type] : m_ghostPlayerMasks[type];
+	}
+
+	constexpr void AddPair( EntityType typeA, EntityType typeB, const CollisionPairRule& rule )
+	{
+		m_masks[typeA] |= GetEntityTypeMask( typeB );
+		if( !rule.m_isPhysical || (typeA != ENTITY_TYPE_PLAYER && typeB != ENTITY_TYPE_PLAYER) )
+			m_ghostPlayerMasks[typeA] |= GetEntityTypeMask( typeB );
+		m_handlers[typeA][typeB] = rule.m_handler;
+		m_requiresDifferentFaction[typeA][typeB] = rule.m_requiresDifferentFaction;
+	}
+};
+
+//////////////////////////////////////////////////////////////////////////
+constexpr CollisionMatrix BuildCollisionMatrix()
+{
+	CollisionMatrix matrix;
+	for( const CollisionPairRule& rule : COLLISION_PAIR_RULES )
+	{
+		matrix.AddPair( rule.m_typeA, rule.m_typeB, rule );
+		if( rule.m_isBothWays )
+			matrix.AddPair( rule.m_typeB, rule.m_typeA, rule );
+	}
+	return matrix;
+}
+
+//////////////////////////////////////////////////////////////////////////
+constexpr bool AreSweptRulesValid()
+{
+	for( const CollisionPairRule& rule : COLLISION_PAIR_RULES )
+	{
+		bool isSweptA = (COLLISION_SWEPT_TYPE_MASK & GetEntityTypeMask( rule.m_typeA )) != 0;
+		bool isSweptB = (COLLISION_SWEPT_TYPE_MASK & GetEntityTypeMask( rule.m_typeB )) != 0;
+		if( isSweptA && (!rule.m_requiresDifferentFaction || rule.m_isBothWays) )
+			return false;
+		if( isSweptA && isSweptB )
+			return false;
+	}
+	return true;
+}
+
+constexpr CollisionMatrix COLLISION_MATRIX = BuildCollisionMatrix();
+static_assert( AreSweptRulesValid(), "swept types only hit other factions, one way, and never each other" );
@@ -0,0 +1,204 @@
+#include "Game/CrowdAvoidance.hpp"
+#include "Engine/Math/MathUtils.hpp"
+#include <cmath>
+
+static const float AVOIDANCE_EPSILON = .00001f;
+//agents heading straight at each other stall in perfect symmetry, so crowded agents all lean slightly to the right
+static const float AVOIDANCE_SIDE_BIAS_DEGREES = -3.f;
+
+//velocities on the left of m_direction, seen from m_point, are allowed
+struct AvoidanceLine
+{
+	Vec2 m_point;
+	Vec2 m_direction;
+};
+
+//////////////////////////////////////////////////////////////////////////
+static float GetDeterminant2D( const Vec2& a, const Vec2& b )
+{
+	return a.x * b.y - a.y * b.x;
+}
+
+//////////////////////////////////////////////////////////////////////////
+static bool SolveOnLine( const std::vector<AvoidanceLine>& lines, int lineID, float maxSpeed, const Vec2& optimalVelocity, bool isDirectionOptimal, Vec2& out_result )
+{
+	//the part of line lineID inside the speed circle, cut down by every line before it
+	const AvoidanceLine& line = lines[lineID];
+	float dotProduct = DotProduct2D( line.m_point, line.m_direction );
+	float discriminant = dotProduct * dotProduct + maxSpeed * maxSpeed - line.m_point.GetLengthSquared();
+	if( discriminant < 0.f )
+		return false;
+	float sqrtDiscriminant = sqrtf( discriminant );
+	float tLeft = -dotProduct - sqrtDiscriminant;
+	float tRight = -dotProduct + sqrtDiscriminant;
+	for( int otherID = 0; otherID < lineID; otherID++ )
+	{
+		const AvoidanceLine& otherLine = lines[otherID];
+		float denominator = GetDeterminant2D( line.m_direction, otherLine.m_direction );
+		float numerator = GetDeterminant2D( otherLine.m_direction, line.m_point - otherLine.m_point );
+		if( fabsf( denominator ) <= AVOIDANCE_EPSILON )
+		{
+			//parallel lines, either all of this one is allowed by the other or none of it
+			if( numerator < 0.f )
+				return false;
+			continue;
+		}
+		float t = numerator / denominator;
+		if( denominator >= 0.f )
+			tRight = fminf( tRight, t );
+		else tLeft = fmaxf( tLeft, t );
+		if( tLeft > tRight )
+			return false;
+	}
+
+	if( isDirectionOptimal )
+	{
+		out_result = DotProduct2D( optimalVelocity, line.m_direction ) > 0.f ? line.m_point + tRight * line.m_direction : line.m_point + tLeft * line.m_direction;
+		return true;
+	}
+	float t = DotProduct2D( line.m_direction, optimalVelocity - line.m_point );
+	t = fmaxf( tLeft, fminf( t, tRight ) );
+	out_result = line.m_point + t * line.m_direction;
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+static int SolveInLines( const std::vector<AvoidanceLine>& lines, float maxSpeed, const Vec2& optimalVelocity, bool isDirectionOptimal, Vec2& out_result )
+{
+	//incremental 2D linear program, returns the first line it could not satisfy or the line count on success
+	if( isDirectionOptimal )
+		out_result = optimalVelocity * maxSpeed;
+	else if( optimalVelocity.GetLengthSquared() > maxSpeed * maxSpeed )
+		out_result = optimalVelocity.GetNormalized() * maxSpeed;
+	else out_result = optimalVelocity;
+
+	for( int lineID = 0; lineID < (int)lines.size(); lineID++ )
+	{
+		if( GetDeterminant2D( lines[lineID].m_direction, lines[lineID].m_point - out_result ) <= 0.f )
+			continue;
+		Vec2 previousResult = out_result;
+		if( !SolveOnLine( lines, lineID, maxSpeed, optimalVelocity, isDirectionOptimal, out_result ) )
+		{
+			out_result = previousResult;
+			return lineID;
+		}
+	}
+	return (int)lines.size();
+}
+
+//////////////////////////////////////////////////////////////////////////
+static void SolveLeastViolation( const std::vector<AvoidanceLine>& lines, int firstFailedLine, float maxSpeed, Vec2& inout_result )
+{
+	//no velocity satisfies every line: minimize the largest distance by which a line is violated
+	thread_local std::vector<AvoidanceLine> projectedLines;
+	float distance = 0.f;
+	for( int lineID = firstFailedLine; lineID < (int)lines.size(); lineID++ )
+	{
+		const AvoidanceLine& line = lines[lineID];
+		if( GetDeterminant2D( line.m_direction, line.m_point - inout_result ) <= distance )
+			continue;
+		projectedLines.clear();
+		for( int otherID = 0; otherID < lineID; otherID++ )
+		{
+			const AvoidanceLine& otherLine = lines[otherID];
+			AvoidanceLine projectedLine;
+			float determinant = GetDeterminant2D( line.m_direction, otherLine.m_direction );
+			if( fabsf( determinant ) <= AVOIDANCE_EPSILON )
+			{
+				//same direction adds nothing, opposite directions meet halfway
+				if( DotProduct2D( line.m_direction, otherLine.m_direction ) > 0.f )
+					continue;
+				projectedLine.m_point = .5f * (line.m_point + otherLine.m_point);
+			}
+			else projectedLine.m_point = line.m_point + (GetDeterminant2D( otherLine.m_direction, line.m_point - otherLine.m_point ) / determinant) * line.m_direction;
+			projectedLine.m_direction = (otherLine.m_direction - line.m_direction).GetNormalized();
+			projectedLines.push_back( projectedLine );
+		}
+		Vec2 previousResult = inout_result;
+		if( SolveInLines( projectedLines, maxSpeed, Vec2( -line.m_direction.y, line.m_direction.x ), true, inout_result ) < (int)projectedLines.size() )
+		{
+			//only float error gets here, the previous result is the better answer
+			inout_result = previousResult;
+		}
+		distance = GetDeterminant2D( line.m_direction, line.m_point - inout_result );
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+Vec2 ComputeAvoidanceVelocity( const Vec2& position, const Vec2& velocity, float radius, const Vec2& desiredVelocity, float maxSpeed,
+	const std::vector<AvoidanceNeighbor>& neighbors, float timeHorizon, float deltaSeconds )
+{
+	thread_local std::vector<AvoidanceLine> lines;
+	lines.clear();
+	float inverseTimeHorizon = 1.f / timeHorizon;
+	for( const AvoidanceNeighbor& neighbor : neighbors )
+	{
+		Vec2 relativePosition = neighbor.m_position - position;
+		Vec2 relativeVelocity = velocity - neighbor.m_velocity;
+		float distanceSquared = relativePosition.GetLengthSquared();
+		float combinedRadius = radius + neighbor.m_radius;
+		float combinedRadiusSquared = combinedRadius * combinedRadius;
+		AvoidanceLine line;
+		//smallest change of relative velocity that leaves the velocity obstacle
+		Vec2 exitChange;
+		if( distanceSquared > combinedRadiusSquared )
+		{
+			//the velocity obstacle is a cone truncated by a circle around relativePosition / timeHorizon
+			Vec2 w = relativeVelocity - inverseTimeHorizon * relativePosition;
+			float wLengthSquared = w.GetLengthSquared();
+			float wDotPosition = DotProduct2D( w, relativePosition );
+			if( wDotPosition < 0.f && wDotPosition * wDotPosition > combinedRadiusSquared * wLengthSquared )
+			{
+				//closest to the truncating circle
+				float wLength = sqrtf( wLengthSquared );
+				Vec2 unitW = w / wLength;
+				line.m_direction = Vec2( unitW.y, -unitW.x );
+				exitChange = (combinedRadius * inverseTimeHorizon - wLength) * unitW;
+			}
+			else
+			{
+				//closest to one of the cone legs
+				float legLength = sqrtf( distanceSquared - combinedRadiusSquared );
+				if( GetDeterminant2D( relativePosition, w ) > 0.f )
+				{
+					line.m_direction = Vec2( relativePosition.x * legLength - relativePosition.y * combinedRadius,
+						relativePosition.x * combinedRadius + relativePosition.y * legLength ) / distanceSquared;
+				}
+				else
+				{
+					line.m_direction = -Vec2( relativePosition.x * legLength + relativePosition.y * combinedRadius,
+						-relativePosition.x * combinedRadius + relativePosition.y * legLength ) / distanceSquared;
+				}
+				exitChange = DotProduct2D( relativeVelocity, line.m_direction ) * line.m_direction - relativeVelocity;
+			}
+		}
+		else
+		{
+			//already overlapping, get apart within this tick
+			float inverseDeltaSeconds = 1.f / deltaSeconds;
+			Vec2 w = relativeVelocity - inverseDeltaSeconds * relativePosition;
+			float wLength = w.GetLength();
+			if( wLength <= AVOIDANCE_EPSILON )
+				continue;
+			Vec2 unitW = w / wLength;
+			line.m_direction = Vec2( unitW.y, -unitW.x );
+			exitChange = (combinedRadius * inverseDeltaSeconds - wLength) * unitW;
+		}
+		float responsibility = neighbor.m_isAvoiding ? .5f : 1.f;
+		line.m_point = velocity + responsibility * exitChange;
+		lines.push_back( line );
+	}
+
+	Vec2 preferredVelocity = desiredVelocity;
+	if( !lines.empty() )
+	{
+		float biasCos = CosDegrees( AVOIDANCE_SIDE_BIAS_DEGREES );
+		float biasSin = SinDegrees( AVOIDANCE_SIDE_BIAS_DEGREES );
+		preferredVelocity = Vec2( desiredVelocity.x * biasCos - desiredVelocity.y * biasSin, desiredVelocity.x * biasSin + desiredVelocity.y * biasCos );
+	}
+	Vec2 result;
+	int failedLine = SolveInLines( lines, maxSpeed, preferredVelocity, false, result );
+	if( failedLine < (int)lines.size() )
+		SolveLeastViolation( lines, failedLine, maxSpeed, result );
+	return result;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <vector>
+#include "Engine/Math/Vec2.hpp"
+
+//////////////////////////////////////////////////////////////////////////
+//one entity near an avoiding agent, as the agent sees it at the start of the tick
+struct AvoidanceNeighbor
+{
+	Vec2  m_position;
+	Vec2  m_velocity;
+	float m_radius = 0.f;
+	//an avoiding neighbor takes half of the avoidance, anything else is avoided fully by the agent
+	bool  m_isAvoiding = false;
+};
+
+//////////////////////////////////////////////////////////////////////////
+//ORCA (optimal reciprocal collision avoidance): every neighbor turns into a half plane of velocities that stay clear of it
+//for timeHorizon seconds, the result is the velocity closest to desiredVelocity inside all half planes and maxSpeed
+//when the half planes leave no room, the velocity that least violates the nearest of them is taken instead
+Vec2 ComputeAvoidanceVelocity( const Vec2& position, const Vec2& velocity, float radius, const Vec2& desiredVelocity, float maxSpeed,
+	const std::vector<AvoidanceNeighbor>& neighbors, float timeHorizon, float deltaSeconds );
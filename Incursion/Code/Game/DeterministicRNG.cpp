@@ -0,0 +1,44 @@
+#include "Game/DeterministicRNG.hpp"
+
+//////////////////////////////////////////////////////////////////////////
+DeterministicRNG::DeterministicRNG( uint64_t seed )
+	:m_state(seed)
+{
+}
+
+//////////////////////////////////////////////////////////////////////////
+uint32_t DeterministicRNG::RollRandomUInt32()
+{
+	//splitmix64, one add and a fixed mix per roll, good enough for level layouts
+	m_state += 0x9E3779B97F4A7C15ull;
+	uint64_t mixed = m_state;
+	mixed = (mixed ^ (mixed >> 30)) * 0xBF58476D1CE4E5B9ull;
+	mixed = (mixed ^ (mixed >> 27)) * 0x94D049BB133111EBull;
+	mixed = mixed ^ (mixed >> 31);
+	return (uint32_t)(mixed >> 32);
+}
+
+//////////////////////////////////////////////////////////////////////////
+int DeterministicRNG::RollRandomIntLessThan( int maxNotInclusive )
+{
+	//scaled instead of taken modulo, so the result does not depend on the low bits only
+	return (int)(((uint64_t)RollRandomUInt32() * (uint64_t)maxNotInclusive) >> 32);
+}
+
+//////////////////////////////////////////////////////////////////////////
+int DeterministicRNG::RollRandomIntInRange( int minInclusive, int maxInclusive )
+{
+	return minInclusive + RollRandomIntLessThan( maxInclusive - minInclusive + 1 );
+}
+
+//////////////////////////////////////////////////////////////////////////
+float DeterministicRNG::RollRandomFloatZeroToOneInclusive()
+{
+	return (float)RollRandomUInt32() / (float)0xFFFFFFFFu;
+}
+
+//////////////////////////////////////////////////////////////////////////
+float DeterministicRNG::RollRandomFloatInRange( float minInclusive, float maxInclusive )
+{
+	return minInclusive + (maxInclusive - minInclusive) * RollRandomFloatZeroToOneInclusive();
+}
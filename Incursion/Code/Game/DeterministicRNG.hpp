@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+
+//////////////////////////////////////////////////////////////////////////
+//small seeded generator whose sequence only depends on its seed, on every platform and build
+//same roll functions as the engine RandomNumberGenerator, for code that has to be reproducible
+class DeterministicRNG
+{
+public:
+	explicit DeterministicRNG( uint64_t seed );
+
+	uint32_t RollRandomUInt32();
+	int   RollRandomIntLessThan( int maxNotInclusive );
+	int   RollRandomIntInRange( int minInclusive, int maxInclusive );
+	float RollRandomFloatZeroToOneInclusive();
+	float RollRandomFloatInRange( float minInclusive, float maxInclusive );
+
+private:
+	uint64_t m_state = 0;
+};
@@ -3,17 +3,85 @@
 #include "Game/Game.hpp"
 #include "Game/Map.hpp"
 #include "Game/Pickup.hpp"
+#include "Game/RenderSnapshot.hpp"
 #include "Engine/Core/Vertex_PCU.hpp"
-#include "Engine/Renderer/RenderContext.hpp"
 #include "Engine/Math/MathUtils.hpp"
 
+EntityID Entity::s_nextEntityID = INVALID_ENTITY_ID + 1;
+
+constexpr size_t ENTITY_POOL_GRANULARITY = 16;
+constexpr size_t MAX_POOLED_ENTITY_SIZE = 1024;
+constexpr int    NUM_ENTITY_POOLS = (int)(MAX_POOLED_ENTITY_SIZE / ENTITY_POOL_GRANULARITY);
+
+//a free block stores the next free block of the same size in its first bytes
+struct PooledEntityBlock
+{
+	PooledEntityBlock* m_next = nullptr;
+};
+
+static PooledEntityBlock* s_entityPools[NUM_ENTITY_POOLS] = {};
+
+static int GetEntityPoolIndex( size_t numBytes )
+{
+	return (int)((numBytes + ENTITY_POOL_GRANULARITY - 1) / ENTITY_POOL_GRANULARITY) - 1;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void* Entity::operator new( size_t numBytes )
+{
+	if( numBytes > MAX_POOLED_ENTITY_SIZE )
+		return ::operator new( numBytes );
+
+	int poolIndex = GetEntityPoolIndex( numBytes );
+	PooledEntityBlock* block = s_entityPools[poolIndex];
+	if( block == nullptr )
+		return ::operator new( (size_t)(poolIndex + 1) * ENTITY_POOL_GRANULARITY );
+	s_entityPools[poolIndex] = block->m_next;
+	return block;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void Entity::operator delete( void* pointer, size_t numBytes )
+{
+	if( pointer == nullptr )
+		return;
+	if( numBytes > MAX_POOLED_ENTITY_SIZE )
+	{
+		::operator delete( pointer );
+		return;
+	}
+
+	int poolIndex = GetEntityPoolIndex( numBytes );
+	PooledEntityBlock* block = static_cast<PooledEntityBlock*>( pointer );
+	block->m_next = s_entityPools[poolIndex];
+	s_entityPools[poolIndex] = block;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void Entity::ReleasePooledMemory()
+{
+	for( int poolIndex = 0; poolIndex < NUM_ENTITY_POOLS; poolIndex++ )
+	{
+		PooledEntityBlock* block = s_entityPools[poolIndex];
+		while( block != nullptr )
+		{
+			PooledEntityBlock* next = block->m_next;
+			::operator delete( block );
+			block = next;
+		}
+		s_entityPools[poolIndex] = nullptr;
+	}
+}
+
 //////////////////////////////////////////////////////////////////////////
 Entity::Entity( Map* map, const Vec2& startPosition, EntityFaction faction, EntityType type )
 	:m_position(startPosition)
+	,m_positionBeforeMove(startPosition)
 	, m_faction(faction)
 	, m_theMap(map)
 	,m_type(type)
 {
+	m_id = s_nextEntityID++;
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -34,7 +102,9 @@ void Entity::PickupStuff(PickupType type )
 //////////////////////////////////////////////////////////////////////////
 void Entity::SwitchFaction()
 {
+	EntityFaction oldFaction = m_faction;
 	m_faction = GetOppositeFaction();
+	m_theMap->NotifyEntityFactionSwitched( this, oldFaction );
 	m_theMap->SpawnExplosion( m_position, m_cosmeticRadius, .5f * EXPLOSION_MAX_DURATION, GetFactionColor() );
 }
 
@@ -42,6 +112,7 @@ void Entity::SwitchFaction()
 void Entity::Update( float deltaSeconds ) 
 {
 	m_livingTime += deltaSeconds;
+	m_positionBeforeMove = m_position;
 
 	m_orientationDegrees += m_angularVelocity * deltaSeconds;
 
@@ -52,30 +123,27 @@ void Entity::Update( float deltaSeconds )
 }
 
 //////////////////////////////////////////////////////////////////////////
-void Entity::Render() const
-{
-	std::vector<Vertex_PCU> drawVerts = m_verts;
-	TransformVertexArray( (int)drawVerts.size(), &drawVerts[0], 1.f, m_orientationDegrees, m_position );
-	g_theRenderer->DrawVertexArray( drawVerts );
-}
-
-//////////////////////////////////////////////////////////////////////////
-void Entity::DebugRender() const
+void Entity::FillRenderState( EntityRenderState& out_state ) const
 {
-	Rgba8 cyan = Rgba8( 0, 255, 255 );	
-	g_theRenderer->DrawRing2D( m_position, m_physicsRadius, LINE_THICKNESS, cyan);
-
-	Rgba8 magenta = Rgba8( 255, 0, 255 );
-	g_theRenderer->DrawRing2D( m_position, m_cosmeticRadius, LINE_THICKNESS, magenta );	
-
-	Rgba8 yello = Rgba8( 255, 255, 0 );
-	g_theRenderer->DrawLine2D( m_position, m_position + m_velocity, LINE_THICKNESS, yello);
+	out_state.m_type = m_type;
+	out_state.m_faction = m_faction;
+	out_state.m_position = m_position;
+	out_state.m_velocity = m_velocity;
+	out_state.m_orientationDegrees = m_orientationDegrees;
+	out_state.m_physicsRadius = m_physicsRadius;
+	out_state.m_cosmeticRadius = m_cosmeticRadius;
+	out_state.m_healthFraction = (float)m_health / (float)m_healthLimit;
+	out_state.SetVerts( m_verts );
 }
 
 //////////////////////////////////////////////////////////////////////////
 void Entity::Die()
 {
+	//die could be called several times in one frame, only count the first one
+	if( !IsAlive() )
+		return;
 	m_isDead = true;
+	m_theMap->NotifyEntityDied( this );
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -1,12 +1,15 @@
 #pragma once
 #include "Engine/Math/Vec2.hpp"
+#include "Engine/Math/IntVec2.hpp"
 #include "Engine/Core/Rgba8.hpp"
 #include <vector>
+#include <cstddef>
 
 struct Vec2;
 struct Vertex_PCU;
 class Entity;
 class Map;
+struct EntityRenderState;
 enum PickupType:int;
 
 enum EntityType
@@ -34,6 +37,12 @@ enum EntityFaction
 };
 
 typedef std::vector<Entity*> EntityList;
+typedef unsigned int EntityID;
+typedef unsigned int EntityTypeMask;
+
+constexpr EntityID INVALID_ENTITY_ID = 0;
+constexpr EntityTypeMask ENTITY_TYPE_MASK_ALL = (1u << (unsigned int)NUM_ENTITY_TYPES) - 1u;
+constexpr EntityTypeMask GetEntityTypeMask( EntityType type ) { return 1u << (unsigned int)type; }
 
 class Entity
 {
@@ -41,14 +50,23 @@ class Entity
 
 public:
 	Entity(Map* map, const Vec2& startPosition, EntityFaction faction, EntityType type);
-	~Entity() = default;
+	virtual ~Entity() = default;
+
+	//entities are recycled through per-size free lists instead of going back to the heap
+	static void* operator new( size_t numBytes );
+	static void  operator delete( void* pointer, size_t numBytes );
+	static void  ReleasePooledMemory();
 
 	virtual void PickupStuff( PickupType type );
 	virtual void SwitchFaction();
 
+	//may run on a worker thread: read the map, write only this entity, spawn nothing
+	virtual void Think() {}
+	//runs on the simulation thread before crowd avoidance, sets m_desiredVelocity for entities that avoid others
+	virtual void UpdateSteering( float ) {}
 	virtual void Update( float deltaSeconds );
-	virtual void Render() const;
-	virtual void DebugRender() const;
+	//runs on the simulation thread at the end of a tick, the renderer only ever sees this copy
+	virtual void FillRenderState( EntityRenderState& out_state ) const;
 	virtual void Die();
 	virtual void TakeDamage( int );
 
@@ -63,6 +81,8 @@ public:
 	Vec2  m_position;
 	Vec2  m_velocity;
 	Vec2  m_acceleration;
+	//start of this tick's move, swept collision runs from here to m_position
+	Vec2  m_positionBeforeMove;
 	std::vector<Vertex_PCU> m_verts;
 	float m_orientationDegrees	= 0.f;
 	float m_angularVelocity		= 0.f;
@@ -70,18 +90,33 @@ public:
 	float m_cosmeticRadius		= 0.f;
 	float m_livingTime          = 0.f;
 	float m_speedLimit          = 0.f;
+	//velocity chosen by steering, replaced by crowd avoidance for entities that avoid others
+	Vec2  m_desiredVelocity;
 	int   m_health				= 1;
 	int   m_healthLimit         = 1;
 	int   m_factionBombNum      = 0;
 	bool  m_isDead				= false;
 	bool  m_isGarbage			= false;
 	Map*  m_theMap              = nullptr;
+	EntityID m_id               = INVALID_ENTITY_ID;
+	float m_secondsSinceLastThink = 0.f;
+	bool  m_hasThought          = false;
 	EntityType m_type = NUM_ENTITY_TYPES;
 	EntityFaction m_faction = NUM_FACTIONS;
 
 protected:
+	static EntityID s_nextEntityID;
+
+	//slot in the map's entity list, kept by Map so a dead entity can be removed without a scan
+	int m_listIndex = -1;
+
 	bool m_pushesEntities = false;
 	bool m_isPushedByEntities = false;
 	bool m_isPushedByWalls = false;
 	bool m_isHitByBullets = false;
+	bool m_avoidsEntities = false;
+	//where this entity last stamped the map's influence layers, kept by Map so the stamp can be taken out again
+	bool m_hasInfluenceStamp = false;
+	IntVec2 m_influenceTileCoords;
+	EntityFaction m_influenceFaction = NUM_FACTIONS;
 };
@@ -0,0 +1,100 @@
+#include "Game/EntitySpatialGrid.hpp"
+#include "Engine/Math/MathUtils.hpp"
+#include <algorithm>
+
+//////////////////////////////////////////////////////////////////////////
+void EntitySpatialGrid::Startup( const IntVec2& mapSize, float cellSize )
+{
+	m_cellSize = cellSize;
+	m_dimensions.x = (int)((float)mapSize.x / cellSize) + 1;
+	m_dimensions.y = (int)((float)mapSize.y / cellSize) + 1;
+	Clear();
+}
+
+//////////////////////////////////////////////////////////////////////////
+void EntitySpatialGrid::Clear()
+{
+	m_cellStarts.clear();
+	m_cellEntities.clear();
+	m_insertedEntities.clear();
+	m_maxRadius = 0.f;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void EntitySpatialGrid::Rebuild( const EntityList* entityListsByType )
+{
+	//counting sort by cell, two passes over the alive entities and no per-cell allocations
+	int numCells = m_dimensions.x * m_dimensions.y;
+	m_cellStarts.assign( numCells + 1, 0 );
+	m_unsortedEntities.clear();
+	m_entityCells.clear();
+	m_insertedEntities.clear();
+	m_maxRadius = 0.f;
+	for( int entityTypeID = 0; entityTypeID < (int)NUM_ENTITY_TYPES; entityTypeID++ )
+	{
+		for( Entity* entity : entityListsByType[entityTypeID] )
+		{
+			if( entity == nullptr || !entity->IsAlive() )
+				continue;
+			int cellIndex = GetCellIndex( entity->m_position );
+			m_unsortedEntities.push_back( entity );
+			m_entityCells.push_back( cellIndex );
+			m_cellStarts[cellIndex + 1]++;
+			m_maxRadius = std::max( m_maxRadius, entity->m_physicsRadius );
+		}
+	}
+	for( int cellIndex = 0; cellIndex < numCells; cellIndex++ )
+	{
+		m_cellStarts[cellIndex + 1] += m_cellStarts[cellIndex];
+	}
+
+	//scatter in list order, so candidates inside one cell keep the update order
+	m_cellEntities.resize( m_unsortedEntities.size() );
+	m_nextSlots.assign( m_cellStarts.begin(), m_cellStarts.end() - 1 );
+	for( int entityIndex = 0; entityIndex < (int)m_unsortedEntities.size(); entityIndex++ )
+	{
+		m_cellEntities[m_nextSlots[m_entityCells[entityIndex]]++] = m_unsortedEntities[entityIndex];
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+void EntitySpatialGrid::Insert( Entity* entity )
+{
+	//spawned since the last rebuild, every query checks these until the next one
+	m_insertedEntities.push_back( entity );
+	m_maxRadius = std::max( m_maxRadius, entity->m_physicsRadius );
+}
+
+//////////////////////////////////////////////////////////////////////////
+void EntitySpatialGrid::Remove( const Entity* entity )
+{
+	//only for entities deleted or moved to another map between rebuilds, which is rare enough for a scan
+	for( Entity*& cellEntity : m_cellEntities )
+	{
+		if( cellEntity == entity )
+			cellEntity = nullptr;
+	}
+	for( Entity*& insertedEntity : m_insertedEntities )
+	{
+		if( insertedEntity == entity )
+			insertedEntity = nullptr;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+int EntitySpatialGrid::GetCellIndex( const Vec2& position ) const
+{
+	return GetClampedCellX( position.x ) + GetClampedCellY( position.y ) * m_dimensions.x;
+}
+
+//////////////////////////////////////////////////////////////////////////
+int EntitySpatialGrid::GetClampedCellX( float x ) const
+{
+	return std::max( 0, std::min( RoundDownToInt( x / m_cellSize ), m_dimensions.x - 1 ) );
+}
+
+//////////////////////////////////////////////////////////////////////////
+int EntitySpatialGrid::GetClampedCellY( float y ) const
+{
+	return std::max( 0, std::min( RoundDownToInt( y / m_cellSize ), m_dimensions.y - 1 ) );
+}
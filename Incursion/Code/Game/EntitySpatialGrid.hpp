@@ -0,0 +1,108 @@
+#pragma once
+
+#include <vector>
+#include "Game/Entity.hpp"
+#include "Engine/Math/IntVec2.hpp"
+#include "Engine/Math/Vec2.hpp"
+#include "Engine/Math/AABB2.hpp"
+
+//////////////////////////////////////////////////////////////////////////
+//which alive entities a spatial query returns, same faction rules as EntityView
+struct EntityFilter
+{
+	EntityTypeMask m_typeMask = ENTITY_TYPE_MASK_ALL;
+	EntityFaction  m_faction = NUM_FACTIONS;
+	bool           m_excludeFaction = false;
+
+	EntityFilter() = default;
+	explicit EntityFilter( EntityTypeMask typeMask, EntityFaction faction = NUM_FACTIONS, bool excludeFaction = false )
+		:m_typeMask(typeMask)
+		,m_faction(faction)
+		,m_excludeFaction(excludeFaction)
+	{
+	}
+
+	bool IsMatching( const Entity* entity ) const
+	{
+		if( entity == nullptr || !entity->IsAlive() )
+			return false;
+		if( (m_typeMask & GetEntityTypeMask( entity->m_type )) == 0 )
+			return false;
+		if( m_faction == NUM_FACTIONS )
+			return true;
+		return (entity->m_faction == m_faction) != m_excludeFaction;
+	}
+};
+
+//////////////////////////////////////////////////////////////////////////
+//uniform grid over the map, entities are bucketed by center in one flat array sorted by cell
+//rebuilt by Map at the start of each query phase, entities spawned in between go to a short list every query checks
+class EntitySpatialGrid
+{
+public:
+	EntitySpatialGrid() = default;
+	~EntitySpatialGrid() = default;
+
+	void Startup( const IntVec2& mapSize, float cellSize );
+	void Clear();
+	void Rebuild( const EntityList* entityListsByType );
+	void Insert( Entity* entity );
+	void Remove( const Entity* entity );
+
+	//calls visitor( Entity* ) for every entity whose center may lie within margin of bounds, callers do the exact test
+	template<typename Visitor>
+	void VisitCandidates( const AABB2& bounds, float margin, Visitor&& visitor ) const;
+
+	float GetCellSize() const { return m_cellSize; }
+	//largest physics radius seen since the last rebuild, queries widen their bounds by it
+	float GetMaxRadius() const { return m_maxRadius; }
+	int   GetNumEntities() const { return (int)m_cellEntities.size() + (int)m_insertedEntities.size(); }
+
+private:
+	IntVec2 m_dimensions;
+	float m_cellSize = 1.f;
+	float m_maxRadius = 0.f;
+	//entities of cell c are m_cellEntities[m_cellStarts[c]] up to m_cellEntities[m_cellStarts[c+1]]
+	std::vector<int> m_cellStarts;
+	std::vector<Entity*> m_cellEntities;
+	std::vector<Entity*> m_insertedEntities;
+	//rebuild scratch, kept so steady state rebuilds do not allocate
+	std::vector<Entity*> m_unsortedEntities;
+	std::vector<int> m_entityCells;
+	std::vector<int> m_nextSlots;
+
+	int GetCellIndex( const Vec2& position ) const;
+	int GetClampedCellX( float x ) const;
+	int GetClampedCellY( float y ) const;
+};
+
+//////////////////////////////////////////////////////////////////////////
+template<typename Visitor>
+void EntitySpatialGrid::VisitCandidates( const AABB2& bounds, float margin, Visitor&& visitor ) const
+{
+	if( !m_cellStarts.empty() )
+	{
+		//entities are bucketed by center, so the bounds grow by the largest radius plus what moved since the rebuild
+		float grow = margin + m_maxRadius;
+		int minX = GetClampedCellX( bounds.mins.x - grow );
+		int maxX = GetClampedCellX( bounds.maxs.x + grow );
+		int minY = GetClampedCellY( bounds.mins.y - grow );
+		int maxY = GetClampedCellY( bounds.maxs.y + grow );
+		for( int cellY = minY; cellY <= maxY; cellY++ )
+		{
+			int rowStart = cellY * m_dimensions.x;
+			int endIndex = m_cellStarts[rowStart + maxX + 1];
+			for( int entityIndex = m_cellStarts[rowStart + minX]; entityIndex < endIndex; entityIndex++ )
+			{
+				Entity* entity = m_cellEntities[entityIndex];
+				if( entity != nullptr )
+					visitor( entity );
+			}
+		}
+	}
+	for( Entity* entity : m_insertedEntities )
+	{
+		if( entity != nullptr )
+			visitor( entity );
+	}
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "Game/Entity.hpp"
+
+//////////////////////////////////////////////////////////////////////////
+//non-owning view over the alive entities of the map's entity lists
+//filters by type mask and faction, nullptr and dead slots are skipped while iterating
+//iteration is index based, so entities spawned during the loop are still visited like a plain index loop would
+class EntityView
+{
+public:
+	struct Sentinel {};
+
+	class Iterator
+	{
+	public:
+		Iterator( const EntityView& view, int typeID, int slotID )
+			:m_view(view)
+			,m_typeID(typeID)
+			,m_slotID(slotID)
+		{
+			SkipToAlive();
+		}
+
+		Entity* operator*() const { return m_view.m_lists[m_typeID][m_slotID]; }
+		Iterator& operator++()
+		{
+			m_slotID++;
+			SkipToAlive();
+			return *this;
+		}
+		bool operator!=( const Sentinel& ) const { return m_typeID < (int)NUM_ENTITY_TYPES; }
+		bool operator==( const Sentinel& ) const { return m_typeID >= (int)NUM_ENTITY_TYPES; }
+
+	private:
+		const EntityView& m_view;
+		int m_typeID = 0;
+		int m_slotID = 0;
+
+		void SkipToAlive()
+		{
+			while( m_typeID < (int)NUM_ENTITY_TYPES )
+			{
+				if( (m_view.m_typeMask & GetEntityTypeMask( (EntityType)m_typeID )) != 0 )
+				{
+					const EntityList& entityList = m_view.m_lists[m_typeID];
+					for( ; m_slotID < (int)entityList.size(); m_slotID++ )
+					{
+						if( m_view.IsMatching( entityList[m_slotID] ) )
+							return;
+					}
+				}
+				m_typeID++;
+				m_slotID = 0;
+			}
+		}
+	};
+
+public:
+	EntityView( const EntityList* lists, EntityTypeMask typeMask, EntityFaction faction = NUM_FACTIONS, bool excludeFaction = false )
+		:m_lists(lists)
+		,m_typeMask(typeMask)
+		,m_faction(faction)
+		,m_excludeFaction(excludeFaction)
+	{
+	}
+
+	Iterator begin() const { return Iterator( *this, 0, 0 ); }
+	Sentinel end() const { return Sentinel(); }
+
+	bool IsEmpty() const { return begin() == end(); }
+	int  GetCount() const;
+
+	//faction filter: NUM_FACTIONS matches every faction, excludeFaction matches every faction but m_faction
+	bool IsMatching( const Entity* entity ) const
+	{
+		if( entity == nullptr || !entity->IsAlive() )
+			return false;
+		if( m_faction == NUM_FACTIONS )
+			return true;
+		return (entity->m_faction == m_faction) != m_excludeFaction;
+	}
+
+private:
+	const EntityList* m_lists = nullptr;
+	EntityTypeMask m_typeMask = 0;
+	EntityFaction m_faction = NUM_FACTIONS;
+	bool m_excludeFaction = false;
+};
+
+//////////////////////////////////////////////////////////////////////////
+inline int EntityView::GetCount() const
+{
+	int count = 0;
+	for( Iterator it = begin(); it != end(); ++it )
+	{
+		count++;
+	}
+	return count;
+}
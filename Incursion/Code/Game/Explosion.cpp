@@ -1,12 +1,11 @@
 #include "Game/Explosion.hpp"
 #include "Game/GameCommon.hpp"
 #include "Game/Game.hpp"
+#include "Engine/Renderer/RenderContext.hpp"
 #include "Engine/Math/AABB2.hpp"
 #include "Engine/Math/RandomNumberGenerator.hpp"
 #include "Engine/Renderer/SpriteAnimDefinition.hpp"
-#include "Engine/Renderer/Texture.hpp"
 #include "Engine/Renderer/SpriteSheet.hpp"
-#include "Engine/Renderer/RenderContext.hpp"
 
 //////////////////////////////////////////////////////////////////////////
 Explosion::Explosion( Map* map, const Vec2& position, EntityFaction faction, EntityType type )
@@ -16,6 +15,13 @@ Explosion::Explosion( Map* map, const Vec2& position, EntityFaction faction, Ent
 	m_orientationDegrees = g_theGame->m_RNG->RollRandomFloatInRange( 0.f, 360.f );
 }
 
+//////////////////////////////////////////////////////////////////////////
+Explosion::~Explosion()
+{
+	delete m_anim;
+	m_anim = nullptr;
+}
+
 //////////////////////////////////////////////////////////////////////////
 void Explosion::Update( float deltaSeconds )
 {
@@ -38,14 +44,6 @@ void Explosion::Update( float deltaSeconds )
 	Entity::Update( deltaSeconds );
 }
 
-//////////////////////////////////////////////////////////////////////////
-void Explosion::Render() const
-{
-	Texture* animTexture = g_theRenderer->CreateOrGetTextureFromFile( "Data/Images/Explosion_5x5.png" );
-	g_theRenderer->BindDiffuseTexture( animTexture );
-	Entity::Render();
-}
-
 //////////////////////////////////////////////////////////////////////////
 void Explosion::Startup( float radius, float durationSeconds, const Rgba8& tint )
 {
@@ -53,9 +51,7 @@ void Explosion::Startup( float radius, float durationSeconds, const Rgba8& tint
 	m_cosmeticRadius = radius;
 	m_duration = durationSeconds;
 
-	Texture* animTexture = g_theRenderer->CreateOrGetTextureFromFile( "Data/Images/Explosion_5x5.png" );
-	SpriteSheet* animSheet = new SpriteSheet( *animTexture, IntVec2( 5, 5 ) );
-	m_anim = new SpriteAnimDefinition( *animSheet, 0, 24, m_duration, eSpriteAnimPlaybackType::ONCE );
+	m_anim = new SpriteAnimDefinition( g_theGame->GetExplosionSpriteSheet(), 0, 24, m_duration, eSpriteAnimPlaybackType::ONCE );
 
 	AppendVertsForAABB2D( m_verts, AABB2( 0, 0, 0, 0 ) );
 }
@@ -9,9 +9,9 @@ class Explosion:public Entity
 {
 public:
 	explicit Explosion( Map* map, const Vec2& position, EntityFaction faction, EntityType type);
+	~Explosion();
 
 	virtual void Update( float deltaSeconds ) override;
-	virtual void Render() const override;
 
 	void Startup( float radius, float durationSeconds, const Rgba8& tint = Rgba8::WHITE );
 
@@ -0,0 +1,149 @@
+#include "Game/FrameArena.hpp"
+#include "Game/GameCommon.hpp"
+#include "Engine/Core/Vertex_PCU.hpp"
+#include "Engine/Math/AABB2.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+thread_local size_t g_heapAllocationCount = 0;
+
+#if defined(TRACK_HEAP_ALLOCATIONS)
+void* operator new( size_t numBytes )
+{
+	g_heapAllocationCount++;
+	void* memory = malloc( numBytes == 0 ? 1 : numBytes );
+	if( memory == nullptr )
+		throw std::bad_alloc();
+	return memory;
+}
+
+void* operator new[]( size_t numBytes )
+{
+	return operator new( numBytes );
+}
+
+void operator delete( void* memory ) noexcept
+{
+	free( memory );
+}
+
+void operator delete[]( void* memory ) noexcept
+{
+	free( memory );
+}
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+FrameArena::FrameArena( size_t capacityBytes )
+	:m_capacity(capacityBytes)
+{
+	m_buffer = static_cast<unsigned char*>( malloc( m_capacity ) );
+}
+
+//////////////////////////////////////////////////////////////////////////
+FrameArena::~FrameArena()
+{
+	Reset();
+	free( m_buffer );
+	m_buffer = nullptr;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void FrameArena::Reset()
+{
+	for( int blockID = 0; blockID < (int)m_overflowBlocks.size(); blockID++ )
+	{
+		free( m_overflowBlocks[blockID] );
+	}
+	m_overflowBlocks.clear();
+
+	//last frame did not fit, grow once so following frames stay inside the buffer
+	if( m_overflowBytes > 0 )
+	{
+		free( m_buffer );
+		m_capacity = 2 * (m_used + m_overflowBytes);
+		m_buffer = static_cast<unsigned char*>( malloc( m_capacity ) );
+	}
+
+	m_used = 0;
+	m_overflowBytes = 0;
+	m_numAllocations = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void* FrameArena::Allocate( size_t numBytes, size_t alignment )
+{
+	m_numAllocations++;
+	size_t alignedStart = (m_used + alignment - 1) & ~(alignment - 1);
+	if( m_buffer != nullptr && alignedStart + numBytes <= m_capacity )
+	{
+		m_used = alignedStart + numBytes;
+		if( m_used > m_highWaterMark )
+			m_highWaterMark = m_used;
+		return m_buffer + alignedStart;
+	}
+
+	void* overflowBlock = malloc( numBytes + alignment );
+	m_overflowBlocks.push_back( overflowBlock );
+	m_overflowBytes += numBytes + alignment;
+	size_t alignedAddress = ((size_t)overflowBlock + alignment - 1) & ~(alignment - 1);
+	return reinterpret_cast<void*>( alignedAddress );
+}
+
+//////////////////////////////////////////////////////////////////////////
+VertexSpan AllocateFrameVerts( int capacity )
+{
+	VertexSpan span;
+	span.m_verts = g_theFrameArena->AllocateArray<Vertex_PCU>( capacity );
+	span.m_capacity = capacity;
+	return span;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void VertexSpan::Reserve( int capacity )
+{
+	if( capacity <= m_capacity )
+		return;
+
+	Vertex_PCU* newVerts = g_theFrameArena->AllocateArray<Vertex_PCU>( capacity );
+	if( m_size > 0 )
+		memcpy( newVerts, m_verts, sizeof( Vertex_PCU ) * (size_t)m_size );
+	m_verts = newVerts;
+	m_capacity = capacity;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void VertexSpan::PushBack( const Vertex_PCU& vert )
+{
+	if( m_size == m_capacity )
+		Reserve( m_capacity > 0 ? 2 * m_capacity : 6 );
+	m_verts[m_size] = vert;
+	m_size++;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void VertexSpan::AppendVerts( const std::vector<Vertex_PCU>& verts )
+{
+	int numVerts = (int)verts.size();
+	Reserve( m_size + numVerts );
+	if( numVerts > 0 )
+		memcpy( m_verts + m_size, verts.data(), sizeof( Vertex_PCU ) * (size_t)numVerts );
+	m_size += numVerts;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void VertexSpan::AppendVertsForAABB2D( const AABB2& bounds, const Vec2& uvAtMins, const Vec2& uvAtMaxs, const Rgba8& tint )
+{
+	Reserve( m_size + 6 );
+	Vertex_PCU bottomLeft( Vec3( bounds.mins.x, bounds.mins.y, 0.f ), tint, uvAtMins );
+	Vertex_PCU bottomRight( Vec3( bounds.maxs.x, bounds.mins.y, 0.f ), tint, Vec2( uvAtMaxs.x, uvAtMins.y ) );
+	Vertex_PCU topRight( Vec3( bounds.maxs.x, bounds.maxs.y, 0.f ), tint, uvAtMaxs );
+	Vertex_PCU topLeft( Vec3( bounds.mins.x, bounds.maxs.y, 0.f ), tint, Vec2( uvAtMins.x, uvAtMaxs.y ) );
+	PushBack( bottomLeft );
+	PushBack( bottomRight );
+	PushBack( topRight );
+	PushBack( bottomLeft );
+	PushBack( topRight );
+	PushBack( topLeft );
+}
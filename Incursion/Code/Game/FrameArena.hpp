@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include "Engine/Math/Vec2.hpp"
+#include "Engine/Core/Rgba8.hpp"
+
+struct Vertex_PCU;
+struct AABB2;
+
+//counts every global operator new while enabled, used to prove that frame rendering never touches the heap
+#if defined(_DEBUG)
+#define TRACK_HEAP_ALLOCATIONS
+#endif
+
+//per thread, so allocations of the simulation thread do not show up in the render thread's count
+extern thread_local size_t g_heapAllocationCount;
+
+//////////////////////////////////////////////////////////////////////////
+//linear allocator for transient per-frame memory, everything is released at once by Reset()
+class FrameArena
+{
+public:
+	explicit FrameArena( size_t capacityBytes );
+	~FrameArena();
+
+	void  Reset();
+	void* Allocate( size_t numBytes, size_t alignment = alignof(std::max_align_t) );
+
+	template<typename T>
+	T* AllocateArray( int count ) { return static_cast<T*>( Allocate( sizeof( T ) * (size_t)count, alignof(T) ) ); }
+
+	size_t GetCapacity() const						{ return m_capacity; }
+	size_t GetBytesUsed() const						{ return m_used; }
+	size_t GetHighWaterMark() const					{ return m_highWaterMark; }
+	int    GetNumAllocationsThisFrame() const		{ return m_numAllocations; }
+	int    GetNumOverflowAllocationsThisFrame() const	{ return (int)m_overflowBlocks.size(); }
+
+private:
+	unsigned char* m_buffer = nullptr;
+	size_t m_capacity = 0;
+	size_t m_used = 0;
+	size_t m_highWaterMark = 0;
+	size_t m_overflowBytes = 0;
+	int    m_numAllocations = 0;
+	//only used when one frame outgrows the buffer, the buffer grows at the next Reset()
+	std::vector<void*> m_overflowBlocks;
+};
+
+//////////////////////////////////////////////////////////////////////////
+//non-owning vertex array living in the frame arena, valid until the next FrameArena::Reset()
+struct VertexSpan
+{
+public:
+	Vertex_PCU* m_verts = nullptr;
+	int m_size = 0;
+	int m_capacity = 0;
+
+	bool IsEmpty() const { return m_size == 0; }
+
+	void PushBack( const Vertex_PCU& vert );
+	void AppendVerts( const std::vector<Vertex_PCU>& verts );
+	void AppendVertsForAABB2D( const AABB2& bounds, const Vec2& uvAtMins, const Vec2& uvAtMaxs, const Rgba8& tint );
+	void Reserve( int capacity );
+};
+
+VertexSpan AllocateFrameVerts( int capacity );
@@ -1,9 +1,11 @@
 #include "Game/Game.hpp"
 #include "Game/World.hpp"
 #include "Game/App.hpp"
-#include "Game/Map.hpp"
 #include "Game/Entity.hpp"
 #include "Game/TileDefinition.hpp"
+#include "Game/FrameArena.hpp"
+#include "Game/RenderSnapshot.hpp"
+#include "Game/WorldRenderer.hpp"
 #include "Engine/Math/MathUtils.hpp"
 #include "Engine/Math/RandomNumberGenerator.hpp"
 #include "Engine/Math/AABB2.hpp"
@@ -16,6 +18,16 @@
 #include "Engine/Core/Clock.hpp"
 #include "Engine/Audio/AudioSystem.hpp"
 
+static const std::string TEXT_TITLE = "Incursion";
+static const std::string TEXT_LOADING = "Loading...";
+static const std::string TEXT_START = "Press Start/Spacebar to start";
+static const std::string TEXT_WIN = "You Win!";
+static const std::string TEXT_WIN_TO_TITLE = "Press Start/Back/P/ESC to title";
+static const std::string TEXT_LOSE = "You Lose!";
+static const std::string TEXT_DIE = "You Die!";
+static const std::string TEXT_PAUSE = "Pause";
+static const std::string TEXT_RESUME_OR_QUIT = "Press Start/P to resume\nPress Back/ESC to quit";
+
 void Game::Startup()
 {
 	m_gameClock = new Clock();
@@ -33,22 +45,42 @@ void Game::Startup()
     m_uiCamera = new Camera();
 	m_uiCamera->SetOrthoView( -halfSize,halfSize );
 	m_uiCamera->SetProjectionOrthographic(CAMERA_VIEW_SIZE_Y);
+
+	m_worldRenderer = new WorldRenderer();
+	m_cameraRNG = new RandomNumberGenerator();
 }
 
 void Game::Shutdown()
 {
 	g_theInput->PopMouseOptions();
 
+	//joins the simulation thread before the world goes away
+	delete g_theSimulation;
+	g_theSimulation = nullptr;
+	m_snapshot = nullptr;
+
 	delete m_theWorld;
 	m_theWorld = nullptr;
+	Entity::ReleasePooledMemory();
+
+	delete m_worldRenderer;
+	m_worldRenderer = nullptr;
+	delete m_cameraRNG;
+	m_cameraRNG = nullptr;
 
 	delete m_worldCamera;
 	delete  m_uiCamera;
+
+	delete m_extrasSheet;
+	m_extrasSheet = nullptr;
+	delete m_explosionSheet;
+	m_explosionSheet = nullptr;
 }
 
 void Game::Update()
 {	
 	float deltaSeconds = (float)m_gameClock->GetLastDeltaSeconds();
+	UpdateSimulation();
 	if( m_gameState == GAME_STATE_LOADING )
 	{
 		if( !m_loadingStarted )
@@ -60,6 +92,7 @@ void Game::Update()
 			m_RNG = new RandomNumberGenerator();
 			TileDefinition::InitializeDefinitions();
 			m_theWorld = new World( this );
+			g_theSimulation = new SimulationThread( m_theWorld );
 			//to title stage
 			m_gameState = GAME_STATE_TITLE;
 		}
@@ -67,10 +100,11 @@ void Game::Update()
 	else if( m_gameState==GAME_STATE_PLAYING)
 	{
 		deltaSeconds *= m_timeScale;
-		m_theWorld->Update( deltaSeconds );
 		UpdateCamera(deltaSeconds);
 		UpdateForPlayerDeath(deltaSeconds);
 		UpdateEventStates();
+		SendInputCommand();
+		UpdateFrameStatsText();
 	}
 	else if( m_gameState == GAME_STATE_PAUSE )
 	{
@@ -107,9 +141,9 @@ void Game::Render() const
 {	
 		//world camera
     g_theRenderer->BeginCamera(m_worldCamera); 
-    if (m_gameState != GAME_STATE_TITLE && m_gameState != GAME_STATE_LOADING)
+    if (m_gameState != GAME_STATE_TITLE && m_gameState != GAME_STATE_LOADING && m_snapshot != nullptr)
     {
-        m_theWorld->Render();
+        m_worldRenderer->Render( *m_snapshot );
     }
 	g_theRenderer->EndCamera( m_worldCamera );
 		//ui camera
@@ -185,6 +219,97 @@ void Game::LoadAssets()
 	g_theAudio->CreateOrGetSound( "Data/Audio/EnemyHit.wav" );
 	g_theAudio->CreateOrGetSound( "Data/Audio/Pause.mp3" );
 	g_theAudio->CreateOrGetSound( "Data/Audio/Unpause.mp3" );
+
+	Texture* extrasTexture = g_theRenderer->CreateOrGetTextureFromFile( "Data/Images/Extras_4x4.png" );
+	m_extrasSheet = new SpriteSheet( *extrasTexture, IntVec2( 4, 4 ) );
+	Texture* explosionTexture = g_theRenderer->CreateOrGetTextureFromFile( "Data/Images/Explosion_5x5.png" );
+	m_explosionSheet = new SpriteSheet( *explosionTexture, IntVec2( 5, 5 ) );
+}
+
+void Game::StartNewGame()
+{
+	//the simulation thread is stopped outside of play, so the world can be reset from here
+	m_gameState = GAME_STATE_PLAYING;
+	m_inputCommand = InputCommand();
+	m_theWorld->StartLevel();
+	g_theSimulation->PublishSnapshot();
+	m_snapshot = &g_theSimulation->AcquireLatestSnapshot();
+}
+
+void Game::UpdateSimulation()
+{
+	if( g_theSimulation == nullptr )
+		return;
+
+	//starting and leaving a game are the only points where the main thread waits for the simulation thread
+	bool isSimulating = m_gameState == GAME_STATE_PLAYING || m_gameState == GAME_STATE_PAUSE;
+	if( isSimulating && !g_theSimulation->IsRunning() )
+		g_theSimulation->Start();
+	else if( !isSimulating && g_theSimulation->IsRunning() )
+		g_theSimulation->Stop();
+	g_theSimulation->SetPaused( m_gameState == GAME_STATE_PAUSE );
+
+	PlaySimulationEvents();
+	if( g_theSimulation->HasSnapshot() )
+		m_snapshot = &g_theSimulation->AcquireLatestSnapshot();
+
+	if( m_snapshot == nullptr || m_gameState != GAME_STATE_PLAYING )
+		return;
+	if( m_snapshot->m_hasPlayerWon )
+		ProgressToState( GAME_STATE_WIN );
+	else if( m_snapshot->m_hasPlayerLost )
+		ProgressToState( GAME_STATE_LOSE );
+}
+
+void Game::PlaySimulationEvents()
+{
+	SimulationEvent event;
+	while( g_theSimulation->PopEvent( event ) )
+	{
+		if( event.m_type == SIMULATION_EVENT_PLAY_SOUND )
+		{
+			SoundID sound = g_theAudio->CreateOrGetSound( event.m_soundFilePath );
+			g_theAudio->PlaySound( sound );
+		}
+		else if( event.m_type == SIMULATION_EVENT_SET_VIBRATION )
+		{
+			g_theInput->SetVibrationValue( event.m_controllerID, event.m_vibration, event.m_vibration );
+		}
+	}
+}
+
+void Game::SendInputCommand()
+{
+	const XboxController& controller = g_theInput->GetXboxController( 0 );
+	m_inputCommand.m_isControllerConnected = controller.IsConnected();
+	m_inputCommand.m_timeScale = m_timeScale;
+	if( controller.IsConnected() )
+	{
+		const AnalogJoystick& leftJoystick = controller.GetLeftJoystick();
+		m_inputCommand.m_moveMagnitude = leftJoystick.GetMagnitude();
+		m_inputCommand.m_moveDegrees = leftJoystick.GetAngleDegrees();
+		const AnalogJoystick& rightJoystick = controller.GetRightJoystick();
+		m_inputCommand.m_aimMagnitude = rightJoystick.GetMagnitude();
+		m_inputCommand.m_aimDegrees = rightJoystick.GetAngleDegrees();
+		if( controller.GetButtonState( XBOX_BUTTON_ID_RSHOULDER ).WasJustPressed() )
+			m_inputCommand.m_wasShootPressed = true;
+		if( controller.GetButtonState( XBOX_BUTTON_ID_LSHOULDER ).WasJustPressed() )
+			m_inputCommand.m_wasBombPressed = true;
+	}
+	else
+	{
+		m_inputCommand.m_moveMagnitude = 0.f;
+		m_inputCommand.m_aimMagnitude = 0.f;
+	}
+
+	//a full queue keeps the presses for the next frame instead of waiting
+	if( g_theSimulation->PushInputCommand( m_inputCommand ) )
+	{
+		m_inputCommand.m_wasShootPressed = false;
+		m_inputCommand.m_wasBombPressed = false;
+		m_inputCommand.m_wasRespawnRequested = false;
+		m_inputCommand.m_wasSpawnAlliesRequested = false;
+	}
 }
 
 void Game::SetPauseState()
@@ -236,9 +361,7 @@ void Game::UpdateEventStates()
 	//trial: spawn friendly allay
 	if( g_theInput->WasKeyJustPressed( 'N' ) )
 	{
-		Map* curMap = m_theWorld->GetCurrentMap();
-		curMap->SpawnNPC( ENTITY_TYPE_NPC_TANK, FACTION_GOOD );
-		curMap->SpawnNPC( ENTITY_TYPE_NPC_TURRET, FACTION_GOOD );
+		m_inputCommand.m_wasSpawnAlliesRequested = true;
 	}
 }
 
@@ -246,9 +369,10 @@ void Game::UpdateCamera(float deltaTime)
 {
 	float numTilesInViewVertically = static_cast<float>(m_numTilesInViewVertically);
 	Vec2 halfDim( numTilesInViewVertically * CLIENT_ASPECT*.5f, numTilesInViewVertically*.5f );
+	if( m_snapshot == nullptr )
+		return;
 	AABB2 camBounds = m_worldCamera->GetBounds();
-	const Map* currentMap = m_theWorld->GetCurrentMap();
-	AABB2 mapBounds( Vec2( 0.f, 0.f ), Vec2( (float)currentMap->m_size.x, (float)currentMap->m_size.y ) );
+	AABB2 mapBounds( Vec2( 0.f, 0.f ), Vec2( (float)m_snapshot->m_mapSize.x, (float)m_snapshot->m_mapSize.y ) );
 	if( g_isFullScreenMap )
 	{
 		camBounds.FitInBoundsAndResize( mapBounds );
@@ -256,19 +380,18 @@ void Game::UpdateCamera(float deltaTime)
 	}
 	else
 	{
-		Entity* player = currentMap->GetPlayerAlive();
-		if( player != nullptr ) //just show the local map around the player
+		if( m_snapshot->m_isPlayerAlive ) //just show the local map around the player
 		{
 			//camBounds.SetDimensions( Vec2( numTilesInViewVertically * CLIENT_ASPECT, numTilesInViewVertically ) );
-			camBounds.SetCenter( player->m_position );
+			camBounds.SetCenter( m_snapshot->m_playerPosition );
 			camBounds.FitWithinBounds( mapBounds );
 			m_worldCamPos = camBounds.GetCenter();
 		}
 	}
 	if( m_cameraShakeFraction>0.f )
 	{
-		float cameraShiftX = m_RNG->RollRandomFloatInRange( -CAMERA_SHAKE_RANGE * m_cameraShakeFraction, CAMERA_SHAKE_RANGE * m_cameraShakeFraction );
-		float cameraShiftY = m_RNG->RollRandomFloatInRange( -CAMERA_SHAKE_RANGE * m_cameraShakeFraction, CAMERA_SHAKE_RANGE * m_cameraShakeFraction );
+		float cameraShiftX = m_cameraRNG->RollRandomFloatInRange( -CAMERA_SHAKE_RANGE * m_cameraShakeFraction, CAMERA_SHAKE_RANGE * m_cameraShakeFraction );
+		float cameraShiftY = m_cameraRNG->RollRandomFloatInRange( -CAMERA_SHAKE_RANGE * m_cameraShakeFraction, CAMERA_SHAKE_RANGE * m_cameraShakeFraction );
 		camBounds.Translate( Vec2( cameraShiftX * cameraShiftX, cameraShiftY * cameraShiftY ) );
 		m_cameraShakeFraction -= deltaTime / CAMERA_SHAKE_RANGE;
 	}
@@ -288,15 +411,13 @@ void Game::UpdateForTitle()
 	g_theInput->SetVibrationValue( 0, 0, 0 );
 	if( g_theInput->WasKeyJustPressed( KEY_SPACEBAR ) )
 	{
-		m_gameState = GAME_STATE_PLAYING;
-		m_theWorld->StartLevel();
+		StartNewGame();
 	}
 		
 	const XboxController& controller = g_theInput->GetXboxController( 0 );
 	if( controller.IsConnected()){
         if (controller.GetButtonState(XBOX_BUTTON_ID_START).WasJustPressed()) {
-            m_gameState = GAME_STATE_PLAYING;
-            m_theWorld->StartLevel();
+            StartNewGame();
         }
 
 		if (controller.GetButtonState(XBOX_BUTTON_ID_BACK).WasJustPressed()) {
@@ -326,11 +447,9 @@ void Game::UpdateForPlayerDeath(float deltaSeconds)
 	{		
 		if( !m_isPlayerDead )
 		{
-			Map* curMap = m_theWorld->GetCurrentMap();
-			if( curMap == nullptr )
+			if( m_snapshot == nullptr )
 				return;
-			Entity* player = curMap->GetPlayerAlive();
-			if( player == nullptr )
+			if( !m_snapshot->m_isPlayerAlive )
 			{
 				m_sceneCountdown = PLAYER_DEATH_TRANSITION;				
 				m_alphaCountup = 0.f;
@@ -341,7 +460,7 @@ void Game::UpdateForPlayerDeath(float deltaSeconds)
 		else//fade finished
 		{
 			g_theInput->SetVibrationValue( 0, 0.f, 0.f );
-			if( m_playerRespawnChances <= 0 )//already use all chances, lose
+			if( m_snapshot->m_playerRespawnChances <= 0 )//already use all chances, lose
 			{
 				m_gameState = GAME_STATE_LOSE;
 				m_sceneCountdown = PLAYER_DEATH_TRANSITION;
@@ -352,7 +471,8 @@ void Game::UpdateForPlayerDeath(float deltaSeconds)
 			if( g_theInput->WasKeyJustPressed( 'P' ) || 
 				(controller.IsConnected() && controller.GetButtonState( XBOX_BUTTON_ID_START ).WasJustPressed()))
 			{
-				m_theWorld->GetCurrentMap()->SpawnPlayer( FACTION_GOOD, Vec2( 1.5f, 1.5f ) );
+				//the transition below covers the ticks until a snapshot with the new player arrives
+				m_inputCommand.m_wasRespawnRequested = true;
 				m_alphaCountup = 0.f;
 				m_sceneCountdown = QUICK_SCENE_TRANSITION;
 				m_isPlayerDead = false;
@@ -373,48 +493,63 @@ void Game::UpdateForPlayerDeath(float deltaSeconds)
 	}
 }
 
+void Game::UpdateFrameStatsText()
+{
+	if( !g_isDebugDrawing )
+		return;
+	//built during update so that render stays allocation free
+	m_frameStatsText = Stringf( "Render heap allocs: %d  Frame arena: %d/%d KB", g_theApp->GetLastFrameRenderHeapAllocations(),
+		(int)(g_theFrameArena->GetHighWaterMark() / 1024), (int)(g_theFrameArena->GetCapacity() / 1024) );
+	if( m_snapshot != nullptr )
+	{
+		m_frameStatsText += Stringf( "  AI thinks: %d deferred: %d (%d us)  Sim tick: %d", m_snapshot->m_numAIThinks,
+			m_snapshot->m_numAIDeferred, m_snapshot->m_aiMicroseconds, m_snapshot->m_tickIndex );
+	}
+}
+
 void Game::RenderUITitle() const
 {
-	std::vector<Vertex_PCU> textVerts;
+	std::vector<Vertex_PCU>& textVerts = m_textVerts;
+	textVerts.clear();
 	switch( m_gameState )
 	{
 		case GAME_STATE_WIN:
 		{
-			AppendVertsForTexts( textVerts, Stringf("You Win!"), Vec2( .5f, .5f ), 1.f, Rgba8( 255, 255, 0 ) );
+			AppendVertsForTexts( textVerts, TEXT_WIN, Vec2( .5f, .5f ), 1.f, Rgba8( 255, 255, 0 ) );
 			if(m_sceneCountdown<=0.f )
-				AppendVertsForTexts( textVerts, Stringf( "Press Start/Back/P/ESC to title" ), Vec2( .5f, .3f ), .3f, Rgba8::WHITE );
+				AppendVertsForTexts( textVerts, TEXT_WIN_TO_TITLE, Vec2( .5f, .3f ), .3f, Rgba8::WHITE );
 			break;
 		}
 		case GAME_STATE_LOSE: 
 		{
-			AppendVertsForTexts( textVerts, Stringf( "You Lose!" ), Vec2( .5f, .5f ), 1.f, Rgba8( 255, 0, 0 ) );
+			AppendVertsForTexts( textVerts, TEXT_LOSE, Vec2( .5f, .5f ), 1.f, Rgba8( 255, 0, 0 ) );
 			break;
 		}
 		case GAME_STATE_PAUSE:
 		{
-			AppendVertsForTexts( textVerts, Stringf( "Pause" ), Vec2( .5f, .5f ), .75f, Rgba8::WHITE );
-			AppendVertsForTexts( textVerts, Stringf( "Press Start/P to resume\nPress Back/ESC to quit" ), Vec2( .5f, .3f ), .3f, Rgba8::WHITE );
+			AppendVertsForTexts( textVerts, TEXT_PAUSE, Vec2( .5f, .5f ), .75f, Rgba8::WHITE );
+			AppendVertsForTexts( textVerts, TEXT_RESUME_OR_QUIT, Vec2( .5f, .3f ), .3f, Rgba8::WHITE );
 			break;
 		}
 		case GAME_STATE_PLAYING:
 		{
 			if( m_isPlayerDead && m_sceneCountdown <= 0.f )
 			{
-				AppendVertsForTexts( textVerts, Stringf( "You Die!" ), Vec2( .5f, .5f ), 1.f, Rgba8( 255, 0, 0 ) );
-				AppendVertsForTexts( textVerts, Stringf( "Press Start/P to resume\nPress Back/ESC to quit" ), Vec2( .5f, .3f ), .3f, Rgba8::WHITE );
+				AppendVertsForTexts( textVerts, TEXT_DIE, Vec2( .5f, .5f ), 1.f, Rgba8( 255, 0, 0 ) );
+				AppendVertsForTexts( textVerts, TEXT_RESUME_OR_QUIT, Vec2( .5f, .3f ), .3f, Rgba8::WHITE );
 			}
 			break;
 		}
 		case GAME_STATE_TITLE:
 		{
-			AppendVertsForTexts( textVerts, Stringf( "Incursion" ), Vec2( .5f, .5f ), 1.f, Rgba8::WHITE );
-			AppendVertsForTexts( textVerts, Stringf( "Press Start/Spacebar to start" ), Vec2( .5f, .3f ), .3f, Rgba8::WHITE );
+			AppendVertsForTexts( textVerts, TEXT_TITLE, Vec2( .5f, .5f ), 1.f, Rgba8::WHITE );
+			AppendVertsForTexts( textVerts, TEXT_START, Vec2( .5f, .3f ), .3f, Rgba8::WHITE );
 			break;
 		}
 		case GAME_STATE_LOADING:
 		{
-			AppendVertsForTexts( textVerts, Stringf( "Incursion" ), Vec2( .5f, .5f ), 1.f, Rgba8::WHITE );
-			AppendVertsForTexts( textVerts, Stringf( "Loading..." ), Vec2( .5f, .3f ), .75f, Rgba8::WHITE );
+			AppendVertsForTexts( textVerts, TEXT_TITLE, Vec2( .5f, .5f ), 1.f, Rgba8::WHITE );
+			AppendVertsForTexts( textVerts, TEXT_LOADING, Vec2( .5f, .3f ), .75f, Rgba8::WHITE );
 			break;
 		}
 	}
@@ -425,7 +560,7 @@ void Game::RenderUITitle() const
 	}
 }
 
-void Game::AppendVertsForTexts( std::vector<Vertex_PCU>& verts, std::string text, const Vec2& relativeCenterPos, float size, const Rgba8& tint ) const
+void Game::AppendVertsForTexts( std::vector<Vertex_PCU>& verts, const std::string& text, const Vec2& relativeCenterPos, float size, const Rgba8& tint ) const
 {
 	AABB2 bound = m_uiCamera->GetBounds();
 	Vec2 bottomLeftUI = bound.mins;
@@ -446,27 +581,36 @@ void Game::AppendVertsForTexts( std::vector<Vertex_PCU>& verts, std::string text
 
 void Game::RenderUIForPlay() const
 {
+	if( m_snapshot == nullptr )
+		return;
 	AABB2 bound = m_uiCamera->GetBounds();
 	Vec2 bottomLeftUI = bound.mins;
 	Vec2 upperRightUI = bound.maxs;
 	//render player icon
 	Vec2 currentIconPosition = Vec2( bottomLeftUI.x + 2 * ICON_INTERVAL, upperRightUI.y - 2 * ICON_INTERVAL );
 	float iconScale = ICON_INTERVAL / PLAYER_COSMETIC_RADIUS;
-	for( int playerIconIndex = 0; playerIconIndex < m_playerRespawnChances; playerIconIndex++ )
+	for( int playerIconIndex = 0; playerIconIndex < m_snapshot->m_playerRespawnChances; playerIconIndex++ )
 	{
 		RenderPlayerIconUI( currentIconPosition, iconScale );
 		currentIconPosition.x += 3 * ICON_INTERVAL;
 	}
 	//render faction bomb icon
-	Entity* player = m_theWorld->GetCurrentMap()->GetPlayerAlive();
-	if( player != nullptr && player->m_factionBombNum > 0 )
+	if( m_snapshot->m_isPlayerAlive && m_snapshot->m_playerFactionBombNum > 0 )
 	{
-		for( int bID = 0; bID < player->m_factionBombNum; bID++ )
+		for( int bID = 0; bID < m_snapshot->m_playerFactionBombNum; bID++ )
 		{
 			RenderBombIconUI( currentIconPosition, iconScale );
 			currentIconPosition.x += 3 * ICON_INTERVAL;
 		}
 	}
+	//debug frame stats
+	if( g_isDebugDrawing && !m_frameStatsText.empty() )
+	{
+		m_textVerts.clear();
+		AppendVertsForTexts( m_textVerts, m_frameStatsText, Vec2( .5f, .03f ), .15f, Rgba8( 255, 255, 0 ) );
+		g_theRenderer->BindDiffuseTexture( g_theFont->GetTexture() );
+		g_theRenderer->DrawVertexArray( m_textVerts );
+	}
 	//overlay screens
 	if( m_gameState == GAME_STATE_PAUSE || (m_gameState==GAME_STATE_WIN&& m_sceneCountdown <= 0.f) )
 	{
@@ -492,28 +636,27 @@ void Game::RenderUIForPlay() const
 
 void Game::RenderPlayerIconUI(const Vec2& position, float scale) const
 {
-	std::vector<Vertex_PCU> iconVerts;
-	AppendVertsForAABB2D(iconVerts,AABB2(-.5f,-.5f, .5f,.5f));
-	TransformVertexArray( 6, &iconVerts[0], scale, 0.f, position, Rgba8(255,255,255,200) );
+	VertexSpan iconVerts = AllocateFrameVerts( 6 );
+	iconVerts.AppendVertsForAABB2D( AABB2( -.5f, -.5f, .5f, .5f ), Vec2( 0.f, 0.f ), Vec2( 1.f, 1.f ), Rgba8::WHITE );
+	TransformVertexArray( iconVerts.m_size, iconVerts.m_verts, scale, 0.f, position, Rgba8(255,255,255,200) );
 	Texture* baseTank = g_theRenderer->CreateOrGetTextureFromFile( "Data/Images/PlayerTankBase.png" );
 	g_theRenderer->BindDiffuseTexture( baseTank );
-	g_theRenderer->DrawVertexArray( iconVerts );
+	g_theRenderer->DrawVertexArray( iconVerts.m_size, iconVerts.m_verts );
 
 	Texture* turretTank = g_theRenderer->CreateOrGetTextureFromFile( "Data/Images/PlayerTankTop.png" );
 	g_theRenderer->BindDiffuseTexture( turretTank );
-	g_theRenderer->DrawVertexArray( iconVerts );
+	g_theRenderer->DrawVertexArray( iconVerts.m_size, iconVerts.m_verts );
 }
 
 void Game::RenderBombIconUI( const Vec2& position, float scale ) const
 {
 	Texture* pickupTexture = g_theRenderer->CreateOrGetTextureFromFile( "Data/Images/Extras_4x4.png" );
-	const SpriteSheet* sheet = new SpriteSheet( *pickupTexture, IntVec2( 4, 4 ) );
 	Vec2 uvAtMins, uvAtMaxs;
-	sheet->GetSpriteUVs( uvAtMins, uvAtMaxs, 13 );
-	std::vector<Vertex_PCU> iconVerts;
-	AppendVertsForAABB2D( iconVerts, AABB2( -.5f, -.5f, .5f, .5f ), uvAtMins, uvAtMaxs, Rgba8( 0, 0, 255 ) );
-	TransformVertexArray( 6, &iconVerts[0], scale, 0.f, position, Rgba8( 255, 255, 255, 200 ) );
+	m_extrasSheet->GetSpriteUVs( uvAtMins, uvAtMaxs, 13 );
+	VertexSpan iconVerts = AllocateFrameVerts( 6 );
+	iconVerts.AppendVertsForAABB2D( AABB2( -.5f, -.5f, .5f, .5f ), uvAtMins, uvAtMaxs, Rgba8( 0, 0, 255 ) );
+	TransformVertexArray( iconVerts.m_size, iconVerts.m_verts, scale, 0.f, position, Rgba8( 255, 255, 255, 200 ) );
 	
 	g_theRenderer->BindDiffuseTexture( pickupTexture );
-	g_theRenderer->DrawVertexArray( iconVerts );
+	g_theRenderer->DrawVertexArray( iconVerts.m_size, iconVerts.m_verts );
 }
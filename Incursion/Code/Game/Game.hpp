@@ -1,6 +1,8 @@
 #pragma once
 #include "Game/GameCommon.hpp"
+#include "Game/SimulationThread.hpp"
 #include "Engine/Renderer/Camera.hpp"
+#include "Engine/Core/Vertex_PCU.hpp"
 #include <string>
 #include <vector>
 
@@ -9,7 +11,9 @@ class Entity;
 struct Vec2;
 class World;
 class Clock;
-struct Vertex_PCU;
+class SpriteSheet;
+class WorldRenderer;
+struct RenderSnapshot;
 struct Rgba8;
 
 enum GameState
@@ -37,14 +41,24 @@ public:
 	const GameState& GetCurrentGameState()const { return m_gameState; }
 	void ProgressToState(GameState nextState);
 
+	//created at load time on the main thread, read only afterwards so the simulation can share them
+	const SpriteSheet& GetExtrasSpriteSheet() const { return *m_extrasSheet; }
+	const SpriteSheet& GetExplosionSpriteSheet() const { return *m_explosionSheet; }
+
 	const int m_numTilesInViewVertically = CAMERA_VIEW_SIZE_Y;
 	Camera* m_worldCamera = nullptr;
-	int m_playerRespawnChances = PLAYER_RESPAWN_TIMES;
+	//simulation only, the main thread uses m_cameraRNG
 	RandomNumberGenerator* m_RNG = nullptr;
 
 private:
 	Clock* m_gameClock = nullptr;
 	World* m_theWorld = nullptr;
+	WorldRenderer* m_worldRenderer = nullptr;
+	RandomNumberGenerator* m_cameraRNG = nullptr;
+	//latest snapshot of the simulation, everything on the main thread reads the world through it
+	const RenderSnapshot* m_snapshot = nullptr;
+	//presses are kept until the command reaches the simulation
+	InputCommand m_inputCommand;
 	float m_timeScale = 1.f;
 	float m_sceneCountdown = 0.f;
 	float m_alphaCountup = 0.f;
@@ -56,8 +70,17 @@ private:
 	GameState m_gameState = GAME_STATE_LOADING;
 	bool m_loadingStarted = false;
 	GameState m_lastGameState = m_gameState;
+	SpriteSheet* m_extrasSheet = nullptr;
+	SpriteSheet* m_explosionSheet = nullptr;
+	std::string m_frameStatsText;
+	//UI text verts, kept across frames so render does not allocate, only touched by the render thread
+	mutable std::vector<Vertex_PCU> m_textVerts;
 
 	void LoadAssets();
+	void StartNewGame();
+	void UpdateSimulation();
+	void PlaySimulationEvents();
+	void SendInputCommand();
 	void TogglePauseState();
 	void SetPauseState();
 	
@@ -66,9 +89,10 @@ private:
 	void UpdateForTitle();
 	void UpdateForWin();
 	void UpdateForPlayerDeath(float deltaSeconds);
+	void UpdateFrameStatsText();
 
 	void RenderUITitle() const;
-	void AppendVertsForTexts(std::vector<Vertex_PCU>& verts,std::string text, const Vec2& relativeCenterPos, float size, const Rgba8& tint) const;
+	void AppendVertsForTexts(std::vector<Vertex_PCU>& verts, const std::string& text, const Vec2& relativeCenterPos, float size, const Rgba8& tint) const;
 	void RenderUIForPlay()const;
 	void RenderPlayerIconUI(const Vec2& position, float scale)const;
 	void RenderBombIconUI(const Vec2& position, float scale )const;
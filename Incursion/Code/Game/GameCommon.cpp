@@ -6,7 +6,10 @@ InputSystem* g_theInput = nullptr;
 Game* g_theGame = nullptr;
 AudioSystem* g_theAudio = nullptr;
 BitmapFont* g_theFont = nullptr;
+FrameArena* g_theFrameArena = nullptr;
+JobSystem* g_theJobSystem = nullptr;
+SimulationThread* g_theSimulation = nullptr;
 
-bool g_isDebugDrawing = false;
-bool g_isFullScreenMap = false;
-bool g_isPhysicsEnabled = false;
+std::atomic<bool> g_isDebugDrawing( false );
+std::atomic<bool> g_isFullScreenMap( false );
+std::atomic<bool> g_isPhysicsEnabled( false );
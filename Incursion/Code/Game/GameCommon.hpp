@@ -1,5 +1,6 @@
 #pragma once
 #include "Engine/Core/EngineCommon.hpp"
+#include <atomic>
 
 class App;
 class RenderContext;
@@ -7,6 +8,9 @@ class InputSystem;
 class Game;
 class AudioSystem;
 class BitmapFont;
+class FrameArena;
+class JobSystem;
+class SimulationThread;
 
 constexpr int   CAMERA_VIEW_SIZE_Y = 9;
 constexpr float CLIENT_ASPECT = 16.f/9.f; // We are requesting a 2:1 aspect (square) window area
@@ -23,6 +27,7 @@ constexpr float NPC_TURRET_SHOOT_DEGREES = 5.f;
 constexpr float NPC_TURRET_TURN_SPEED = 100.f;
 constexpr float NPC_TURRET_SCAN_RANGE = 45.f;
 constexpr int   NPC_TURRET_HEALTH = 5;
+constexpr float NPC_TURRET_THINK_RATE = 15.f;
 
 constexpr float NPC_TANK_PHYSICS_RADIUS = .29f;
 constexpr float NPC_TANK_COSMETIC_RADIUS = .4f;
@@ -35,6 +40,14 @@ constexpr float NPC_TANK_DETECT_LENGTH = 10.f;
 constexpr float NPC_TANK_TURN_SPEED = 100.f;
 constexpr int   NPC_TANK_NUM = 10;
 constexpr int   NPC_TANK_HEALTH = 3;
+constexpr float NPC_TANK_THINK_RATE = 10.f;
+constexpr int   NPC_TANK_PATH_LOOKAHEAD = 4;
+constexpr float NPC_TANK_HUNT_THREAT_WEIGHT = 1.f;
+constexpr float NPC_TANK_HURT_THREAT_WEIGHT = -2.f;
+constexpr int   CROWD_AVOIDANCE_MAX_NEIGHBORS = 8;
+constexpr float CROWD_AVOIDANCE_NEIGHBOR_DIST = 2.f;
+constexpr float CROWD_AVOIDANCE_TIME_HORIZON = 1.f;
+constexpr int   CROWD_AVOIDANCE_GRAIN_SIZE = 16;
 
 constexpr float PLAYER_SPEED = 1.f;
 constexpr float PLAYER_TURN_SPEED = 180.f;
@@ -65,6 +78,56 @@ constexpr float ICON_INTERVAL = .2f;
 constexpr float LINE_THICKNESS = .03f;
 constexpr int   RAYCAST_SAMPLE_RATE = 50;
 constexpr float HEALTH_BAR_LENGTH = 1.f;
+constexpr size_t FRAME_ARENA_SIZE = 4 * 1024 * 1024;
+constexpr int   VISIBILITY_FIELD_RADIUS = 15;
+constexpr unsigned char FOG_EXPLORED_ALPHA = 140;
+constexpr unsigned char FOG_UNEXPLORED_ALPHA = 230;
+//thinks per simulation tick, a count and not a time so the units that think never depend on how fast the machine is
+constexpr int   AI_MAX_THINKS_PER_TICK = 32;
+constexpr float AI_NEAR_PLAYER_DISTANCE = 8.f;
+constexpr float AI_NEAR_PLAYER_URGENCY_SCALE = 2.f;
+constexpr float AI_FIRST_THINK_URGENCY = 1000.f;
+constexpr int   AI_THINK_GRAIN_SIZE = 4;
+constexpr int   QUAD_BATCH_GRAIN_SIZE = 256;
+constexpr int   MAX_QUAD_BATCH_VERTS = 8;
+constexpr bool  LINE_OF_SIGHT_CACHE_ENABLED = true;
+constexpr int   LINE_OF_SIGHT_CACHE_RADIUS = 15;
+constexpr int   LINE_OF_SIGHT_REBUILDS_PER_TICK = 32;
+constexpr int   ENTITY_LIST_COMPACT_MIN_HOLES = 64;
+constexpr float ENTITY_LIST_COMPACT_HOLE_RATIO = .5f;
+constexpr float SIMULATION_TICK_SECONDS = 1.f / 60.f;
+constexpr int   SIMULATION_MAX_TICKS_PER_STEP = 4;
+constexpr int   SIMULATION_INPUT_QUEUE_SIZE = 64;
+constexpr int   SIMULATION_EVENT_QUEUE_SIZE = 256;
+constexpr int   MAX_ENTITY_RENDER_VERTS = 6;
+static_assert( MAX_ENTITY_RENDER_VERTS <= MAX_QUAD_BATCH_VERTS, "every entity snapshot mesh has to fit a quad batch" );
+constexpr int   MAX_ENTITY_DEBUG_LINES = 3;
+constexpr float SPATIAL_GRID_CELL_SIZE = 2.f;
+constexpr float SPATIAL_GRID_QUERY_MARGIN = .5f;
+constexpr int   TILE_CHUNK_SIZE_LOG2 = 5;
+constexpr int   TILE_CHUNK_SIZE = 1 << TILE_CHUNK_SIZE_LOG2;
+constexpr int   TILE_CHUNK_NUM_TILES = TILE_CHUNK_SIZE * TILE_CHUNK_SIZE;
+constexpr int   RENDER_TILE_WINDOW_CHUNK_RADIUS = 2;
+constexpr int   TILE_CLEARANCE_RANGE = 4;
+constexpr int   TILE_CLEARANCE_STEPS_PER_TILE = 32;
+constexpr int   PATH_CLUSTER_SIZE_LOG2 = 4;
+constexpr int   PATH_CLUSTER_SIZE = 1 << PATH_CLUSTER_SIZE_LOG2;
+constexpr int   PATH_CLUSTER_NUM_TILES = PATH_CLUSTER_SIZE * PATH_CLUSTER_SIZE;
+constexpr int   PATH_ENTRANCE_SPLIT_LENGTH = 6;
+constexpr int   PATH_CLUSTER_REBUILDS_PER_TICK = 4;
+constexpr int   PATH_CLUSTER_FILL_REBUILDS_PER_TICK = 32;
+constexpr int   PATHFINDING_MAX_TILES = 2048 * 2048;
+constexpr int   INFLUENCE_MAP_RADIUS = 16;
+constexpr int   INFLUENCE_WEIGHT_UNIT = 2;
+constexpr int   INFLUENCE_WEIGHT_PICKUP = 2;
+constexpr int   INFLUENCE_WEIGHT_FRIENDLY_TURRET = 1;
+constexpr float NAV_AGENT_RADIUS = PLAYER_PHYSICS_RADIUS > NPC_TANK_PHYSICS_RADIUS ? PLAYER_PHYSICS_RADIUS : NPC_TANK_PHYSICS_RADIUS;
+//walkability and paths only check that tiles are not solid, which is enough while agents fit a one tile corridor
+static_assert( NAV_AGENT_RADIUS <= .5f, "agents wider than a tile need a clearance check in IsMapWalkable and the pathfinder" );
+constexpr int   SPAWN_POINT_MAX_ATTEMPTS = 8;
+constexpr float PLAYER_START_SPAWN_EXCLUSION_RADIUS = 3.5f;
+constexpr int   NPC_SPAWN_MAX_ATTEMPTS = 30;
+constexpr float NPC_SPAWN_MIN_SPACING = .1f;
 
 extern App* g_theApp;
 extern RenderContext* g_theRenderer;
@@ -72,7 +135,11 @@ extern InputSystem* g_theInput;
 extern AudioSystem* g_theAudio;
 extern Game* g_theGame;
 extern BitmapFont* g_theFont;
+extern FrameArena* g_theFrameArena;
+extern JobSystem* g_theJobSystem;
+extern SimulationThread* g_theSimulation;
 
-extern bool g_isDebugDrawing;
-extern bool g_isFullScreenMap;
-extern bool g_isPhysicsEnabled;
+//toggled on the main thread, read by the simulation thread
+extern std::atomic<bool> g_isDebugDrawing;
+extern std::atomic<bool> g_isFullScreenMap;
+extern std::atomic<bool> g_isPhysicsEnabled;
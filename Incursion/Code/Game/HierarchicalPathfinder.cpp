@@ -0,0 +1,618 @@
+#include "Game/HierarchicalPathfinder.hpp"
+#include "Game/Map.hpp"
+#include "Game/TileStorage.hpp"
+#include "Game/TileDefinition.hpp"
+#include "Game/JobSystem.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+
+static const float PATH_COST_UNREACHABLE = std::numeric_limits<float>::max();
+static const float DIAGONAL_STEP_LENGTH = 1.41421356f;
+
+struct PathOpenEntry
+{
+	float m_priority = 0.f;
+	float m_cost = 0.f;
+	int   m_index = 0;
+
+	//std heaps keep the largest entry on top, the open lists want the smallest priority
+	bool operator<( const PathOpenEntry& other ) const { return m_priority > other.m_priority; }
+};
+
+//////////////////////////////////////////////////////////////////////////
+static float GetOctileDistance( const IntVec2& fromCoords, const IntVec2& toCoords )
+{
+	int deltaX = abs( toCoords.x - fromCoords.x );
+	int deltaY = abs( toCoords.y - fromCoords.y );
+	int minDelta = std::min( deltaX, deltaY );
+	return (float)(std::max( deltaX, deltaY ) - minDelta) + DIAGONAL_STEP_LENGTH * (float)minDelta;
+}
+
+//////////////////////////////////////////////////////////////////////////
+static void BuildEntrancesForBorder( const bool* isOpen, int borderLength, std::vector<uint8_t>& out_entrances )
+{
+	//every run of open tile pairs is one entrance in its middle, long runs get one at each end as in the HPA* paper
+	out_entrances.clear();
+	int runStart = -1;
+	for( int offset = 0; offset <= borderLength; offset++ )
+	{
+		bool isOffsetOpen = offset < borderLength && isOpen[offset];
+		if( isOffsetOpen && runStart < 0 )
+		{
+			runStart = offset;
+		}
+		else if( !isOffsetOpen && runStart >= 0 )
+		{
+			int runEnd = offset - 1;
+			if( runEnd - runStart + 1 >= PATH_ENTRANCE_SPLIT_LENGTH )
+			{
+				out_entrances.push_back( (uint8_t)runStart );
+				out_entrances.push_back( (uint8_t)runEnd );
+			}
+			else out_entrances.push_back( (uint8_t)((runStart + runEnd) / 2) );
+			runStart = -1;
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+void HierarchicalPathfinder::Startup( const Map* map, const IntVec2& dimensions, bool isBuiltUpFront )
+{
+	m_map = map;
+	m_dimensions = dimensions;
+	m_clusterDimensions.x = (dimensions.x + PATH_CLUSTER_SIZE - 1) >> PATH_CLUSTER_SIZE_LOG2;
+	m_clusterDimensions.y = (dimensions.y + PATH_CLUSTER_SIZE - 1) >> PATH_CLUSTER_SIZE_LOG2;
+	int numClusters = m_clusterDimensions.x * m_clusterDimensions.y;
+	m_clusters.assign( numClusters, Cluster() );
+	m_eastEntrances.assign( numClusters, std::vector<uint8_t>() );
+	m_northEntrances.assign( numClusters, std::vector<uint8_t>() );
+	m_isClusterDirty.assign( numClusters, false );
+	m_dirtyClusters.clear();
+	for( int clusterIndex = 0; clusterIndex < numClusters; clusterIndex++ )
+	{
+		Cluster& cluster = m_clusters[clusterIndex];
+		cluster.m_origin = IntVec2( (clusterIndex % m_clusterDimensions.x) << PATH_CLUSTER_SIZE_LOG2, (clusterIndex / m_clusterDimensions.x) << PATH_CLUSTER_SIZE_LOG2 );
+		cluster.m_dimensions = IntVec2( std::min( PATH_CLUSTER_SIZE, dimensions.x - cluster.m_origin.x ), std::min( PATH_CLUSTER_SIZE, dimensions.y - cluster.m_origin.y ) );
+	}
+	float maxSpeedFactor = 0.f;
+	for( int typeID = 0; typeID < (int)NUM_TILE_TYPE; typeID++ )
+	{
+		const TileDefinition& definition = TileDefinition::s_definitions[typeID];
+		if( !definition.m_isSolid )
+			maxSpeedFactor = std::max( maxSpeedFactor, definition.m_speedFactor );
+	}
+	m_minTileCost = maxSpeedFactor > 0.f ? 1.f / maxSpeedFactor : 1.f;
+	m_numUnbuiltClusters = 0;
+	if( !isBuiltUpFront )
+	{
+		//unbuilt clusters have no walkable tiles and no nodes, queued last to first so the rebuild starts at the bottom row
+		m_numUnbuiltClusters = numClusters;
+		m_isClusterDirty.assign( numClusters, true );
+		for( int clusterIndex = numClusters - 1; clusterIndex >= 0; clusterIndex-- )
+		{
+			m_dirtyClusters.push_back( clusterIndex );
+		}
+		RebuildNodeIndices();
+		return;
+	}
+
+	//each step only writes its own cluster and reads what the step before wrote
+	g_theJobSystem->ParallelFor( numClusters, 1, [this]( int beginIndex, int endIndex )
+	{
+		for( int clusterIndex = beginIndex; clusterIndex < endIndex; clusterIndex++ )
+		{
+			BuildTileCosts( clusterIndex );
+		}
+	} );
+	g_theJobSystem->ParallelFor( numClusters, 1, [this]( int beginIndex, int endIndex )
+	{
+		for( int clusterIndex = beginIndex; clusterIndex < endIndex; clusterIndex++ )
+		{
+			BuildBorderEntrances( clusterIndex );
+		}
+	} );
+	g_theJobSystem->ParallelFor( numClusters, 1, [this]( int beginIndex, int endIndex )
+	{
+		for( int clusterIndex = beginIndex; clusterIndex < endIndex; clusterIndex++ )
+		{
+			BuildClusterNodesAndEdges( clusterIndex );
+		}
+	} );
+	RebuildNodeIndices();
+}
+
+//////////////////////////////////////////////////////////////////////////
+void HierarchicalPathfinder::Shutdown()
+{
+	m_map = nullptr;
+	m_clusters.clear();
+	m_eastEntrances.clear();
+	m_northEntrances.clear();
+	m_firstNodes.clear();
+	m_nodeClusters.clear();
+	m_nodeTileCoords.clear();
+	m_isClusterDirty.clear();
+	m_dirtyClusters.clear();
+	m_numUnbuiltClusters = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool HierarchicalPathfinder::FindPath( const Vec2& startPos, const Vec2& goalPos, std::vector<Vec2>& out_waypoints ) const
+{
+	out_waypoints.clear();
+	if( !IsBuilt() )
+		return false;
+	IntVec2 startCoords = m_map->GetTileCoordsForPosition( startPos );
+	IntVec2 goalCoords = m_map->GetTileCoordsForPosition( goalPos );
+	if( startCoords.x < 0 || startCoords.y < 0 || startCoords.x >= m_dimensions.x || startCoords.y >= m_dimensions.y )
+		return false;
+	if( goalCoords.x < 0 || goalCoords.y < 0 || goalCoords.x >= m_dimensions.x || goalCoords.y >= m_dimensions.y )
+		return false;
+	int startClusterIndex = GetClusterIndexForTile( startCoords );
+	int goalClusterIndex = GetClusterIndexForTile( goalCoords );
+	const Cluster& startCluster = m_clusters[startClusterIndex];
+	const Cluster& goalCluster = m_clusters[goalClusterIndex];
+	int startLocalIndex = GetLocalIndex( startCluster, startCoords );
+	int goalLocalIndex = GetLocalIndex( goalCluster, goalCoords );
+	if( startCluster.m_tileCosts[startLocalIndex] <= 0.f || goalCluster.m_tileCosts[goalLocalIndex] <= 0.f )
+		return false;
+
+	thread_local ClusterSearch startSearch;
+	thread_local ClusterSearch goalSearch;
+	thread_local std::vector<int> nodePath;
+	thread_local std::vector<IntVec2> pathTiles;
+	pathTiles.clear();
+	pathTiles.push_back( startCoords );
+	SearchCluster( startCluster, startLocalIndex, startSearch );
+	if( startClusterIndex == goalClusterIndex && startSearch.m_costs[goalLocalIndex] < PATH_COST_UNREACHABLE )
+	{
+		AppendSearchPath( startCluster, startSearch, goalLocalIndex, pathTiles );
+	}
+	else
+	{
+		SearchCluster( goalCluster, goalLocalIndex, goalSearch );
+		if( !SearchNodePath( startClusterIndex, startSearch, goalClusterIndex, goalSearch, goalCoords, nodePath ) )
+			return false;
+
+		//start tile to the first node, node to node, then the last node to the goal tile
+		AppendSearchPath( startCluster, startSearch, startCluster.m_nodeTiles[nodePath.front() - m_firstNodes[startClusterIndex]], pathTiles );
+		for( size_t pathID = 1; pathID < nodePath.size(); pathID++ )
+		{
+			int fromNode = nodePath[pathID - 1];
+			int toNode = nodePath[pathID];
+			int clusterIndex = m_nodeClusters[fromNode];
+			if( m_nodeClusters[toNode] != clusterIndex )
+			{
+				pathTiles.push_back( GetNodeTileCoords( toNode ) );
+				continue;
+			}
+			const Cluster& cluster = m_clusters[clusterIndex];
+			int numNodes = (int)cluster.m_nodeTiles.size();
+			int edgeIndex = (fromNode - m_firstNodes[clusterIndex]) * numNodes + (toNode - m_firstNodes[clusterIndex]);
+			for( uint32_t tileID = cluster.m_edgePathStarts[edgeIndex]; tileID < cluster.m_edgePathStarts[edgeIndex + 1]; tileID++ )
+			{
+				pathTiles.push_back( GetTileCoordsForLocalIndex( cluster, cluster.m_edgePathTiles[tileID] ) );
+			}
+		}
+		//the goal search started at the goal, so its parents lead from the last node to it
+		int localIndex = goalSearch.m_parents[goalCluster.m_nodeTiles[nodePath.back() - m_firstNodes[goalClusterIndex]]];
+		while( localIndex >= 0 )
+		{
+			pathTiles.push_back( GetTileCoordsForLocalIndex( goalCluster, localIndex ) );
+			localIndex = goalSearch.m_parents[localIndex];
+		}
+	}
+
+	//keep the tiles where the step direction changes, straight runs between them stay on the path
+	for( size_t tileID = 1; tileID < pathTiles.size(); tileID++ )
+	{
+		bool isLast = tileID + 1 == pathTiles.size();
+		if( isLast || pathTiles[tileID] - pathTiles[tileID - 1] != pathTiles[tileID + 1] - pathTiles[tileID] )
+			out_waypoints.push_back( Vec2( (float)pathTiles[tileID].x + .5f, (float)pathTiles[tileID].y + .5f ) );
+	}
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void HierarchicalPathfinder::InvalidateRegion( const IntVec2& changedCoords )
+{
+	if( !IsBuilt() )
+		return;
+	//only the cluster of the tile changes its costs, the rebuild redoes the borders and nodes around it
+	int clusterIndex = GetClusterIndexForTile( changedCoords );
+	if( m_isClusterDirty[clusterIndex] )
+		return;
+	m_isClusterDirty[clusterIndex] = true;
+	m_dirtyClusters.push_back( clusterIndex );
+}
+
+//////////////////////////////////////////////////////////////////////////
+void HierarchicalPathfinder::RebuildDirtyClusters( int maxClustersToRebuild )
+{
+	if( !IsBuilt() || m_dirtyClusters.empty() )
+		return;
+	int numToRebuild = std::min( maxClustersToRebuild, (int)m_dirtyClusters.size() );
+	std::vector<int> rebuiltClusters( m_dirtyClusters.end() - numToRebuild, m_dirtyClusters.end() );
+	m_dirtyClusters.resize( m_dirtyClusters.size() - numToRebuild );
+
+	//new tile costs first, then the borders on all four sides, then the nodes of every cluster touching those borders
+	std::vector<int> touchedClusters;
+	for( int clusterIndex : rebuiltClusters )
+	{
+		m_isClusterDirty[clusterIndex] = false;
+		if( !m_clusters[clusterIndex].m_isBuilt )
+			m_numUnbuiltClusters--;
+		BuildTileCosts( clusterIndex );
+	}
+	for( int clusterIndex : rebuiltClusters )
+	{
+		int clusterX = clusterIndex % m_clusterDimensions.x;
+		int clusterY = clusterIndex / m_clusterDimensions.x;
+		BuildBorderEntrances( clusterIndex );
+		touchedClusters.push_back( clusterIndex );
+		if( clusterX > 0 )
+		{
+			BuildBorderEntrances( clusterIndex - 1 );
+			touchedClusters.push_back( clusterIndex - 1 );
+		}
+		if( clusterY > 0 )
+		{
+			BuildBorderEntrances( clusterIndex - m_clusterDimensions.x );
+			touchedClusters.push_back( clusterIndex - m_clusterDimensions.x );
+		}
+		if( clusterX + 1 < m_clusterDimensions.x )
+			touchedClusters.push_back( clusterIndex + 1 );
+		if( clusterY + 1 < m_clusterDimensions.y )
+			touchedClusters.push_back( clusterIndex + m_clusterDimensions.x );
+	}
+	std::sort( touchedClusters.begin(), touchedClusters.end() );
+	touchedClusters.erase( std::unique( touchedClusters.begin(), touchedClusters.end() ), touchedClusters.end() );
+	for( int clusterIndex : touchedClusters )
+	{
+		BuildClusterNodesAndEdges( clusterIndex );
+	}
+	RebuildNodeIndices();
+}
+
+//////////////////////////////////////////////////////////////////////////
+int HierarchicalPathfinder::GetClusterIndexForTile( const IntVec2& tileCoords ) const
+{
+	return (tileCoords.y >> PATH_CLUSTER_SIZE_LOG2) * m_clusterDimensions.x + (tileCoords.x >> PATH_CLUSTER_SIZE_LOG2);
+}
+
+//////////////////////////////////////////////////////////////////////////
+int HierarchicalPathfinder::GetLocalIndex( const Cluster& cluster, const IntVec2& tileCoords ) const
+{
+	return ((tileCoords.y - cluster.m_origin.y) << PATH_CLUSTER_SIZE_LOG2) | (tileCoords.x - cluster.m_origin.x);
+}
+
+//////////////////////////////////////////////////////////////////////////
+IntVec2 HierarchicalPathfinder::GetTileCoordsForLocalIndex( const Cluster& cluster, int localIndex ) const
+{
+	return IntVec2( cluster.m_origin.x + (localIndex & (PATH_CLUSTER_SIZE - 1)), cluster.m_origin.y + (localIndex >> PATH_CLUSTER_SIZE_LOG2) );
+}
+
+//////////////////////////////////////////////////////////////////////////
+int HierarchicalPathfinder::GetPartnerNode( int nodeIndex ) const
+{
+	//the node on the other side of a border has the same entrance index in the opposite border group
+	int clusterIndex = m_nodeClusters[nodeIndex];
+	const int* numNodes = m_clusters[clusterIndex].m_numNodesPerBorder;
+	int entranceIndex = nodeIndex - m_firstNodes[clusterIndex];
+	if( entranceIndex < numNodes[BORDER_EAST] )
+	{
+		int eastIndex = clusterIndex + 1;
+		const int* eastNumNodes = m_clusters[eastIndex].m_numNodesPerBorder;
+		return m_firstNodes[eastIndex] + eastNumNodes[BORDER_EAST] + eastNumNodes[BORDER_NORTH] + entranceIndex;
+	}
+	entranceIndex -= numNodes[BORDER_EAST];
+	if( entranceIndex < numNodes[BORDER_NORTH] )
+	{
+		int northIndex = clusterIndex + m_clusterDimensions.x;
+		const int* northNumNodes = m_clusters[northIndex].m_numNodesPerBorder;
+		return m_firstNodes[northIndex] + northNumNodes[BORDER_EAST] + northNumNodes[BORDER_NORTH] + northNumNodes[BORDER_WEST] + entranceIndex;
+	}
+	entranceIndex -= numNodes[BORDER_NORTH];
+	if( entranceIndex < numNodes[BORDER_WEST] )
+		return m_firstNodes[clusterIndex - 1] + entranceIndex;
+	entranceIndex -= numNodes[BORDER_WEST];
+	int southIndex = clusterIndex - m_clusterDimensions.x;
+	return m_firstNodes[southIndex] + m_clusters[southIndex].m_numNodesPerBorder[BORDER_EAST] + entranceIndex;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void HierarchicalPathfinder::BuildTileCosts( int clusterIndex )
+{
+	Cluster& cluster = m_clusters[clusterIndex];
+	cluster.m_isBuilt = true;
+	for( int localIndex = 0; localIndex < PATH_CLUSTER_NUM_TILES; localIndex++ )
+	{
+		cluster.m_tileCosts[localIndex] = 0.f;
+		int localX = localIndex & (PATH_CLUSTER_SIZE - 1);
+		int localY = localIndex >> PATH_CLUSTER_SIZE_LOG2;
+		if( localX >= cluster.m_dimensions.x || localY >= cluster.m_dimensions.y )
+			continue;
+		IntVec2 tileCoords = GetTileCoordsForLocalIndex( cluster, localIndex );
+		if( m_map->IsTileSolid( tileCoords ) )
+			continue;
+		TileType tileType = m_map->GetTileTypeForPosition( Vec2( (float)tileCoords.x + .5f, (float)tileCoords.y + .5f ) );
+		float speedFactor = TileDefinition::s_definitions[tileType].m_speedFactor;
+		if( speedFactor > 0.f )
+			cluster.m_tileCosts[localIndex] = 1.f / speedFactor;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+void HierarchicalPathfinder::BuildBorderEntrances( int clusterIndex )
+{
+	//a pair across the border is open when both of its tiles are walkable
+	const Cluster& cluster = m_clusters[clusterIndex];
+	bool isOpen[PATH_CLUSTER_SIZE] = {};
+	m_eastEntrances[clusterIndex].clear();
+	if( clusterIndex % m_clusterDimensions.x + 1 < m_clusterDimensions.x )
+	{
+		const Cluster& eastCluster = m_clusters[clusterIndex + 1];
+		int lastX = cluster.m_dimensions.x - 1;
+		for( int offset = 0; offset < cluster.m_dimensions.y; offset++ )
+		{
+			isOpen[offset] = cluster.m_tileCosts[(offset << PATH_CLUSTER_SIZE_LOG2) | lastX] > 0.f && eastCluster.m_tileCosts[offset << PATH_CLUSTER_SIZE_LOG2] > 0.f;
+		}
+		BuildEntrancesForBorder( isOpen, cluster.m_dimensions.y, m_eastEntrances[clusterIndex] );
+	}
+	m_northEntrances[clusterIndex].clear();
+	if( clusterIndex / m_clusterDimensions.x + 1 < m_clusterDimensions.y )
+	{
+		const Cluster& northCluster = m_clusters[clusterIndex + m_clusterDimensions.x];
+		int lastY = cluster.m_dimensions.y - 1;
+		for( int offset = 0; offset < cluster.m_dimensions.x; offset++ )
+		{
+			isOpen[offset] = cluster.m_tileCosts[(lastY << PATH_CLUSTER_SIZE_LOG2) | offset] > 0.f && northCluster.m_tileCosts[offset] > 0.f;
+		}
+		BuildEntrancesForBorder( isOpen, cluster.m_dimensions.x, m_northEntrances[clusterIndex] );
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+void HierarchicalPathfinder::BuildClusterNodesAndEdges( int clusterIndex )
+{
+	Cluster& cluster = m_clusters[clusterIndex];
+	int clusterX = clusterIndex % m_clusterDimensions.x;
+	int clusterY = clusterIndex / m_clusterDimensions.x;
+	int lastX = cluster.m_dimensions.x - 1;
+	int lastY = cluster.m_dimensions.y - 1;
+	cluster.m_nodeTiles.clear();
+	for( uint8_t offset : m_eastEntrances[clusterIndex] )
+	{
+		cluster.m_nodeTiles.push_back( (uint8_t)((offset << PATH_CLUSTER_SIZE_LOG2) | lastX) );
+	}
+	cluster.m_numNodesPerBorder[BORDER_EAST] = (int)m_eastEntrances[clusterIndex].size();
+	for( uint8_t offset : m_northEntrances[clusterIndex] )
+	{
+		cluster.m_nodeTiles.push_back( (uint8_t)((lastY << PATH_CLUSTER_SIZE_LOG2) | offset) );
+	}
+	cluster.m_numNodesPerBorder[BORDER_NORTH] = (int)m_northEntrances[clusterIndex].size();
+	cluster.m_numNodesPerBorder[BORDER_WEST] = 0;
+	if( clusterX > 0 )
+	{
+		for( uint8_t offset : m_eastEntrances[clusterIndex - 1] )
+		{
+			cluster.m_nodeTiles.push_back( (uint8_t)(offset << PATH_CLUSTER_SIZE_LOG2) );
+		}
+		cluster.m_numNodesPerBorder[BORDER_WEST] = (int)m_eastEntrances[clusterIndex - 1].size();
+	}
+	cluster.m_numNodesPerBorder[BORDER_SOUTH] = 0;
+	if( clusterY > 0 )
+	{
+		for( uint8_t offset : m_northEntrances[clusterIndex - m_clusterDimensions.x] )
+		{
+			cluster.m_nodeTiles.push_back( offset );
+		}
+		cluster.m_numNodesPerBorder[BORDER_SOUTH] = (int)m_northEntrances[clusterIndex - m_clusterDimensions.x].size();
+	}
+
+	//one bounded Dijkstra per node gives its costs and paths to all the others
+	int numNodes = (int)cluster.m_nodeTiles.size();
+	cluster.m_edgeCosts.assign( (size_t)numNodes * numNodes, PATH_COST_UNREACHABLE );
+	cluster.m_edgePathStarts.assign( (size_t)numNodes * numNodes + 1, 0 );
+	cluster.m_edgePathTiles.clear();
+	thread_local ClusterSearch search;
+	thread_local std::vector<IntVec2> pathTiles;
+	for( int fromID = 0; fromID < numNodes; fromID++ )
+	{
+		SearchCluster( cluster, cluster.m_nodeTiles[fromID], search );
+		for( int toID = 0; toID < numNodes; toID++ )
+		{
+			int edgeIndex = fromID * numNodes + toID;
+			cluster.m_edgePathStarts[edgeIndex] = (uint32_t)cluster.m_edgePathTiles.size();
+			cluster.m_edgeCosts[edgeIndex] = search.m_costs[cluster.m_nodeTiles[toID]];
+			if( toID == fromID || cluster.m_edgeCosts[edgeIndex] == PATH_COST_UNREACHABLE )
+				continue;
+			pathTiles.clear();
+			AppendSearchPath( cluster, search, cluster.m_nodeTiles[toID], pathTiles );
+			for( const IntVec2& tileCoords : pathTiles )
+			{
+				cluster.m_edgePathTiles.push_back( (uint8_t)GetLocalIndex( cluster, tileCoords ) );
+			}
+		}
+	}
+	cluster.m_edgePathStarts[(size_t)numNodes * numNodes] = (uint32_t)cluster.m_edgePathTiles.size();
+}
+
+//////////////////////////////////////////////////////////////////////////
+void HierarchicalPathfinder::RebuildNodeIndices()
+{
+	m_firstNodes.resize( m_clusters.size() + 1 );
+	m_nodeClusters.clear();
+	m_nodeTileCoords.clear();
+	for( int clusterIndex = 0; clusterIndex < (int)m_clusters.size(); clusterIndex++ )
+	{
+		const Cluster& cluster = m_clusters[clusterIndex];
+		m_firstNodes[clusterIndex] = (int)m_nodeClusters.size();
+		m_nodeClusters.insert( m_nodeClusters.end(), cluster.m_nodeTiles.size(), clusterIndex );
+		for( uint8_t localIndex : cluster.m_nodeTiles )
+		{
+			m_nodeTileCoords.push_back( GetTileCoordsForLocalIndex( cluster, localIndex ) );
+		}
+	}
+	m_firstNodes[m_clusters.size()] = (int)m_nodeClusters.size();
+}
+
+//////////////////////////////////////////////////////////////////////////
+void HierarchicalPathfinder::SearchCluster( const Cluster& cluster, int startLocalIndex, ClusterSearch& out_search ) const
+{
+	//stepping costs the step length times the mean cost of both tiles, so paths cost the same both ways
+	std::fill( out_search.m_costs, out_search.m_costs + PATH_CLUSTER_NUM_TILES, PATH_COST_UNREACHABLE );
+	std::fill( out_search.m_parents, out_search.m_parents + PATH_CLUSTER_NUM_TILES, (int16_t)-1 );
+	thread_local std::vector<PathOpenEntry> openList;
+	openList.clear();
+	out_search.m_costs[startLocalIndex] = 0.f;
+	openList.push_back( PathOpenEntry{ 0.f, 0.f, startLocalIndex } );
+	while( !openList.empty() )
+	{
+		std::pop_heap( openList.begin(), openList.end() );
+		PathOpenEntry entry = openList.back();
+		openList.pop_back();
+		if( entry.m_cost > out_search.m_costs[entry.m_index] )
+			continue;
+		int localX = entry.m_index & (PATH_CLUSTER_SIZE - 1);
+		int localY = entry.m_index >> PATH_CLUSTER_SIZE_LOG2;
+		for( int neighborID = 0; neighborID < 8; neighborID++ )
+		{
+			const IntVec2& offset = TileStorage::NEIGHBOR_OFFSETS[neighborID];
+			int neighborX = localX + offset.x;
+			int neighborY = localY + offset.y;
+			if( neighborX < 0 || neighborY < 0 || neighborX >= cluster.m_dimensions.x || neighborY >= cluster.m_dimensions.y )
+				continue;
+			int neighborIndex = (neighborY << PATH_CLUSTER_SIZE_LOG2) | neighborX;
+			if( cluster.m_tileCosts[neighborIndex] <= 0.f )
+				continue;
+			bool isDiagonal = offset.x != 0 && offset.y != 0;
+			//no cutting corners, a diagonal step needs both tiles beside it
+			if( isDiagonal && (cluster.m_tileCosts[(localY << PATH_CLUSTER_SIZE_LOG2) | neighborX] <= 0.f || cluster.m_tileCosts[(neighborY << PATH_CLUSTER_SIZE_LOG2) | localX] <= 0.f) )
+				continue;
+			float stepLength = isDiagonal ? DIAGONAL_STEP_LENGTH : 1.f;
+			float cost = entry.m_cost + stepLength * .5f * (cluster.m_tileCosts[entry.m_index] + cluster.m_tileCosts[neighborIndex]);
+			if( cost >= out_search.m_costs[neighborIndex] )
+				continue;
+			out_search.m_costs[neighborIndex] = cost;
+			out_search.m_parents[neighborIndex] = (int16_t)entry.m_index;
+			openList.push_back( PathOpenEntry{ cost, cost, neighborIndex } );
+			std::push_heap( openList.begin(), openList.end() );
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+void HierarchicalPathfinder::AppendSearchPath( const Cluster& cluster, const ClusterSearch& search, int targetLocalIndex, std::vector<IntVec2>& out_pathTiles ) const
+{
+	//parents run from the target back to the search start, which is left out
+	size_t firstAppended = out_pathTiles.size();
+	for( int localIndex = targetLocalIndex; search.m_parents[localIndex] >= 0; localIndex = search.m_parents[localIndex] )
+	{
+		out_pathTiles.push_back( GetTileCoordsForLocalIndex( cluster, localIndex ) );
+	}
+	std::reverse( out_pathTiles.begin() + firstAppended, out_pathTiles.end() );
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool HierarchicalPathfinder::SearchNodePath( int startClusterIndex, const ClusterSearch& startSearch, int goalClusterIndex, const ClusterSearch& goalSearch,
+	const IntVec2& goalCoords, std::vector<int>& out_nodePath ) const
+{
+	//A* over the entrance nodes, seeded with the start cluster nodes and finished by a virtual node behind the goal cluster nodes
+	//scratch entries only count when stamped by this search, so nothing is cleared per query
+	struct NodeSearchScratch
+	{
+		std::vector<float> m_costs;
+		std::vector<int> m_parents;
+		std::vector<uint32_t> m_stamps;
+		std::vector<PathOpenEntry> m_openList;
+		uint32_t m_stamp = 0;
+	};
+	thread_local NodeSearchScratch scratch;
+	int goalNode = m_firstNodes.back();
+	size_t numEntries = (size_t)goalNode + 1;
+	if( scratch.m_stamps.size() < numEntries )
+	{
+		scratch.m_costs.resize( numEntries );
+		scratch.m_parents.resize( numEntries );
+		scratch.m_stamps.resize( numEntries, 0 );
+	}
+	scratch.m_stamp++;
+	if( scratch.m_stamp == 0 )
+	{
+		std::fill( scratch.m_stamps.begin(), scratch.m_stamps.end(), 0 );
+		scratch.m_stamp = 1;
+	}
+	scratch.m_openList.clear();
+	auto relaxNode = [&]( int node, int parent, float cost, float heuristic )
+	{
+		if( scratch.m_stamps[node] == scratch.m_stamp && cost >= scratch.m_costs[node] )
+			return;
+		scratch.m_stamps[node] = scratch.m_stamp;
+		scratch.m_costs[node] = cost;
+		scratch.m_parents[node] = parent;
+		scratch.m_openList.push_back( PathOpenEntry{ cost + heuristic, cost, node } );
+		std::push_heap( scratch.m_openList.begin(), scratch.m_openList.end() );
+	};
+	auto getHeuristic = [&]( int node )
+	{
+		return GetOctileDistance( GetNodeTileCoords( node ), goalCoords ) * m_minTileCost;
+	};
+
+	const Cluster& startCluster = m_clusters[startClusterIndex];
+	for( int nodeID = 0; nodeID < (int)startCluster.m_nodeTiles.size(); nodeID++ )
+	{
+		float cost = startSearch.m_costs[startCluster.m_nodeTiles[nodeID]];
+		int node = m_firstNodes[startClusterIndex] + nodeID;
+		if( cost < PATH_COST_UNREACHABLE )
+			relaxNode( node, -1, cost, getHeuristic( node ) );
+	}
+	bool isGoalReached = false;
+	while( !scratch.m_openList.empty() )
+	{
+		std::pop_heap( scratch.m_openList.begin(), scratch.m_openList.end() );
+		PathOpenEntry entry = scratch.m_openList.back();
+		scratch.m_openList.pop_back();
+		if( entry.m_cost > scratch.m_costs[entry.m_index] )
+			continue;
+		if( entry.m_index == goalNode )
+		{
+			isGoalReached = true;
+			break;
+		}
+		int clusterIndex = m_nodeClusters[entry.m_index];
+		const Cluster& cluster = m_clusters[clusterIndex];
+		int nodeID = entry.m_index - m_firstNodes[clusterIndex];
+		int numNodes = (int)cluster.m_nodeTiles.size();
+		if( clusterIndex == goalClusterIndex )
+		{
+			float goalCost = goalSearch.m_costs[cluster.m_nodeTiles[nodeID]];
+			if( goalCost < PATH_COST_UNREACHABLE )
+				relaxNode( goalNode, entry.m_index, entry.m_cost + goalCost, 0.f );
+		}
+		for( int otherID = 0; otherID < numNodes; otherID++ )
+		{
+			float edgeCost = cluster.m_edgeCosts[nodeID * numNodes + otherID];
+			int otherNode = m_firstNodes[clusterIndex] + otherID;
+			if( otherID != nodeID && edgeCost < PATH_COST_UNREACHABLE )
+				relaxNode( otherNode, entry.m_index, entry.m_cost + edgeCost, getHeuristic( otherNode ) );
+		}
+		//one straight step over the border
+		int partnerNode = GetPartnerNode( entry.m_index );
+		const Cluster& partnerCluster = m_clusters[m_nodeClusters[partnerNode]];
+		int partnerTile = partnerCluster.m_nodeTiles[partnerNode - m_firstNodes[m_nodeClusters[partnerNode]]];
+		float crossCost = .5f * (cluster.m_tileCosts[cluster.m_nodeTiles[nodeID]] + partnerCluster.m_tileCosts[partnerTile]);
+		relaxNode( partnerNode, entry.m_index, entry.m_cost + crossCost, getHeuristic( partnerNode ) );
+	}
+	if( !isGoalReached )
+		return false;
+
+	out_nodePath.clear();
+	for( int node = scratch.m_parents[goalNode]; node >= 0; node = scratch.m_parents[node] )
+	{
+		out_nodePath.push_back( node );
+	}
+	std::reverse( out_nodePath.begin(), out_nodePath.end() );
+	return true;
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include "Engine/Math/IntVec2.hpp"
+#include "Engine/Math/Vec2.hpp"
+#include "Game/GameCommon.hpp"
+
+class Map;
+
+//////////////////////////////////////////////////////////////////////////
+//hierarchical A* (HPA*): the map is cut into PATH_CLUSTER_SIZE square clusters, walkable runs across a cluster border
+//become entrance nodes, and the nodes of one cluster are linked by in-cluster paths found when the cluster is built
+//a query searches that node graph and only walks tiles inside the start and goal clusters
+//a tile costs 1 / TileDefinition::m_speedFactor to cross, solid tiles are blocked
+//steps go between tile centers and never cut corners, so every step stays half a tile from the walls
+class HierarchicalPathfinder
+{
+public:
+	HierarchicalPathfinder() = default;
+	~HierarchicalPathfinder() = default;
+
+	//isBuiltUpFront false queues every cluster instead, the graph then fills over the next ticks through the rebuild
+	//and paths through a cluster not built yet fail, for maps loaded from a file that should not scan their tiles on load
+	void Startup( const Map* map, const IntVec2& dimensions, bool isBuiltUpFront );
+	void Shutdown();
+
+	bool IsBuilt() const { return m_map != nullptr; }
+	bool IsFilling() const { return m_numUnbuiltClusters > 0; }
+	//tile centers from the start tile to the goal tile where the path turns, the goal tile center last
+	//only thread local scratch is written, so parallel thinks may call it
+	bool FindPath( const Vec2& startPos, const Vec2& goalPos, std::vector<Vec2>& out_waypoints ) const;
+
+	//a changed tile dirties its cluster, dirty clusters are rebuilt a few per tick
+	void InvalidateRegion( const IntVec2& changedCoords );
+	void RebuildDirtyClusters( int maxClustersToRebuild );
+	int  GetNumDirtyClusters() const { return (int)m_dirtyClusters.size(); }
+
+private:
+	//node order inside a cluster, borders to the east and north are stored by the cluster itself
+	enum ClusterBorder
+	{
+		BORDER_EAST,
+		BORDER_NORTH,
+		BORDER_WEST,
+		BORDER_SOUTH,
+
+		NUM_CLUSTER_BORDERS
+	};
+
+	struct Cluster
+	{
+		IntVec2 m_origin;
+		IntVec2 m_dimensions;
+		bool m_isBuilt = false;
+		//1 / speed factor per local tile, 0 where an agent cannot stand
+		float m_tileCosts[PATH_CLUSTER_NUM_TILES] = {};
+		//local tile index of every entrance node, grouped by ClusterBorder
+		std::vector<uint8_t> m_nodeTiles;
+		int m_numNodesPerBorder[NUM_CLUSTER_BORDERS] = {};
+		//numNodes x numNodes, each path holds the tiles after its first node up to its last one
+		std::vector<float> m_edgeCosts;
+		std::vector<uint32_t> m_edgePathStarts;
+		std::vector<uint8_t> m_edgePathTiles;
+	};
+
+	//one Dijkstra bounded by a cluster, parents lead back to the tile it started from
+	struct ClusterSearch
+	{
+		float   m_costs[PATH_CLUSTER_NUM_TILES] = {};
+		int16_t m_parents[PATH_CLUSTER_NUM_TILES] = {};
+	};
+
+	const Map* m_map = nullptr;
+	IntVec2 m_dimensions;
+	IntVec2 m_clusterDimensions;
+	std::vector<Cluster> m_clusters;
+	//entrance offsets along the border shared with the cluster to the east and to the north
+	std::vector<std::vector<uint8_t>> m_eastEntrances;
+	std::vector<std::vector<uint8_t>> m_northEntrances;
+	//global node index = first node of its cluster + node index in the cluster
+	std::vector<int> m_firstNodes;
+	std::vector<int> m_nodeClusters;
+	std::vector<IntVec2> m_nodeTileCoords;
+	//cheapest tile cost of any definition, keeps the node search heuristic admissible
+	float m_minTileCost = 1.f;
+	std::vector<bool> m_isClusterDirty;
+	std::vector<int>  m_dirtyClusters;
+	int m_numUnbuiltClusters = 0;
+
+	int     GetClusterIndexForTile( const IntVec2& tileCoords ) const;
+	int     GetLocalIndex( const Cluster& cluster, const IntVec2& tileCoords ) const;
+	IntVec2 GetTileCoordsForLocalIndex( const Cluster& cluster, int localIndex ) const;
+	const IntVec2& GetNodeTileCoords( int nodeIndex ) const { return m_nodeTileCoords[nodeIndex]; }
+	int     GetPartnerNode( int nodeIndex ) const;
+
+	void BuildTileCosts( int clusterIndex );
+	void BuildBorderEntrances( int clusterIndex );
+	void BuildClusterNodesAndEdges( int clusterIndex );
+	void RebuildNodeIndices();
+
+	void SearchCluster( const Cluster& cluster, int startLocalIndex, ClusterSearch& out_search ) const;
+	void AppendSearchPath( const Cluster& cluster, const ClusterSearch& search, int targetLocalIndex, std::vector<IntVec2>& out_pathTiles ) const;
+	bool SearchNodePath( int startClusterIndex, const ClusterSearch& startSearch, int goalClusterIndex, const ClusterSearch& goalSearch,
+		const IntVec2& goalCoords, std::vector<int>& out_nodePath ) const;
+};
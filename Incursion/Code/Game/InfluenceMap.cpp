@@ -0,0 +1,180 @@
+#include "Game/InfluenceMap.hpp"
+#include "Game/GameCommon.hpp"
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define INFLUENCE_MAP_USE_SSE
+#include <emmintrin.h>
+#endif
+
+//the SIMD stamp multiplies the low 16 bits of each kernel value, the high 16 bits have to be zero
+static_assert( INFLUENCE_MAP_RADIUS < 32768, "influence kernel values have to fit 16 bits" );
+
+//////////////////////////////////////////////////////////////////////////
+void InfluenceMap::Startup( const IntVec2& dimensions, int radius )
+{
+	m_dimensions = dimensions;
+	m_radius = radius;
+	m_kernelSize = 2 * radius + 1;
+	m_kernel.assign( (size_t)m_kernelSize * (size_t)m_kernelSize, 0 );
+	for( int kernelY = 0; kernelY < m_kernelSize; kernelY++ )
+	{
+		for( int kernelX = 0; kernelX < m_kernelSize; kernelX++ )
+		{
+			float distance = sqrtf( (float)((kernelX - radius) * (kernelX - radius) + (kernelY - radius) * (kernelY - radius)) );
+			int value = radius - (int)(distance + .5f);
+			m_kernel[kernelX + kernelY * m_kernelSize] = value > 0 ? value : 0;
+		}
+	}
+	for( int factionID = 0; factionID < (int)NUM_FACTIONS; factionID++ )
+	{
+		m_threat[factionID].Startup( dimensions, 0 );
+		m_opportunity[factionID].Startup( dimensions, 0 );
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+void InfluenceMap::Shutdown()
+{
+	m_dimensions = IntVec2();
+	m_radius = 0;
+	m_kernelSize = 0;
+	m_kernel.clear();
+	m_kernel.shrink_to_fit();
+	for( int factionID = 0; factionID < (int)NUM_FACTIONS; factionID++ )
+	{
+		m_threat[factionID].Shutdown();
+		m_opportunity[factionID].Shutdown();
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+void InfluenceMap::Reset()
+{
+	for( int factionID = 0; factionID < (int)NUM_FACTIONS; factionID++ )
+	{
+		m_threat[factionID].Reset();
+		m_opportunity[factionID].Reset();
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool InfluenceMap::IsInBounds( const IntVec2& tileCoords ) const
+{
+	return tileCoords.x >= 0 && tileCoords.y >= 0 && tileCoords.x < m_dimensions.x && tileCoords.y < m_dimensions.y;
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool InfluenceMap::IsSourceType( EntityType type )
+{
+	return type == ENTITY_TYPE_PLAYER || type == ENTITY_TYPE_NPC_TANK || type == ENTITY_TYPE_NPC_TURRET || type == ENTITY_TYPE_PICKUP;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void InfluenceMap::AddSource( const IntVec2& tileCoords, EntityType type, EntityFaction faction )
+{
+	StampSource( tileCoords, type, faction, 1 );
+}
+
+//////////////////////////////////////////////////////////////////////////
+void InfluenceMap::RemoveSource( const IntVec2& tileCoords, EntityType type, EntityFaction faction )
+{
+	StampSource( tileCoords, type, faction, -1 );
+}
+
+//////////////////////////////////////////////////////////////////////////
+int InfluenceMap::GetThreat( const IntVec2& tileCoords, EntityFaction faction ) const
+{
+	if( !IsBuilt() || !IsInBounds( tileCoords ) )
+		return 0;
+	return m_threat[faction].GetValue( tileCoords );
+}
+
+//////////////////////////////////////////////////////////////////////////
+int InfluenceMap::GetOpportunity( const IntVec2& tileCoords, EntityFaction faction ) const
+{
+	if( !IsBuilt() || !IsInBounds( tileCoords ) )
+		return 0;
+	return m_opportunity[faction].GetValue( tileCoords );
+}
+
+//////////////////////////////////////////////////////////////////////////
+Vec2 InfluenceMap::GetGradient( const IntVec2& tileCoords, EntityFaction faction, float threatWeight, float opportunityWeight ) const
+{
+	if( !IsBuilt() || !IsInBounds( tileCoords ) )
+		return Vec2();
+	//one sided on the map edges
+	IntVec2 westCoords( tileCoords.x > 0 ? tileCoords.x - 1 : tileCoords.x, tileCoords.y );
+	IntVec2 eastCoords( tileCoords.x < m_dimensions.x - 1 ? tileCoords.x + 1 : tileCoords.x, tileCoords.y );
+	IntVec2 southCoords( tileCoords.x, tileCoords.y > 0 ? tileCoords.y - 1 : tileCoords.y );
+	IntVec2 northCoords( tileCoords.x, tileCoords.y < m_dimensions.y - 1 ? tileCoords.y + 1 : tileCoords.y );
+	float gradientX = GetWeightedValue( eastCoords, faction, threatWeight, opportunityWeight ) - GetWeightedValue( westCoords, faction, threatWeight, opportunityWeight );
+	float gradientY = GetWeightedValue( northCoords, faction, threatWeight, opportunityWeight ) - GetWeightedValue( southCoords, faction, threatWeight, opportunityWeight );
+	return Vec2( gradientX, gradientY );
+}
+
+//////////////////////////////////////////////////////////////////////////
+float InfluenceMap::GetWeightedValue( const IntVec2& tileCoords, EntityFaction faction, float threatWeight, float opportunityWeight ) const
+{
+	return threatWeight * (float)m_threat[faction].GetValue( tileCoords ) + opportunityWeight * (float)m_opportunity[faction].GetValue( tileCoords );
+}
+
+//////////////////////////////////////////////////////////////////////////
+void InfluenceMap::StampSource( const IntVec2& tileCoords, EntityType type, EntityFaction faction, int sign )
+{
+	if( !IsBuilt() || !IsInBounds( tileCoords ) )
+		return;
+	for( int factionID = 0; factionID < (int)NUM_FACTIONS; factionID++ )
+	{
+		if( type == ENTITY_TYPE_PICKUP )
+		{
+			if( factionID != faction )
+				StampLayer( m_opportunity[factionID], tileCoords, sign * INFLUENCE_WEIGHT_PICKUP );
+			continue;
+		}
+		if( factionID != faction )
+			StampLayer( m_threat[factionID], tileCoords, sign * INFLUENCE_WEIGHT_UNIT );
+		else if( type == ENTITY_TYPE_NPC_TURRET )
+			StampLayer( m_opportunity[factionID], tileCoords, sign * INFLUENCE_WEIGHT_FRIENDLY_TURRET );
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+void InfluenceMap::StampLayer( ChunkedTileLayer<int32_t>& layer, const IntVec2& tileCoords, int weight )
+{
+	//the kernel clipped to the map, every row is split where it crosses a chunk and each piece is one contiguous multiply add
+	int minX = tileCoords.x - m_radius > 0 ? tileCoords.x - m_radius : 0;
+	int maxX = tileCoords.x + m_radius < m_dimensions.x - 1 ? tileCoords.x + m_radius : m_dimensions.x - 1;
+	int minY = tileCoords.y - m_radius > 0 ? tileCoords.y - m_radius : 0;
+	int maxY = tileCoords.y + m_radius < m_dimensions.y - 1 ? tileCoords.y + m_radius : m_dimensions.y - 1;
+#if defined(INFLUENCE_MAP_USE_SSE)
+	//weight in the low half of each 32 bit lane and 0 in the high half, so madd gives kernel * weight per lane
+	__m128i weights = _mm_set1_epi32( (int32_t)(uint16_t)(int16_t)weight );
+#endif
+	for( int tileY = minY; tileY <= maxY; tileY++ )
+	{
+		int kernelRowOffset = (tileY - tileCoords.y + m_radius) * m_kernelSize - tileCoords.x + m_radius;
+		for( int segmentX = minX; segmentX <= maxX; )
+		{
+			int segmentEndX = (segmentX | (TILE_CHUNK_SIZE - 1)) + 1 < maxX + 1 ? (segmentX | (TILE_CHUNK_SIZE - 1)) + 1 : maxX + 1;
+			int segmentLength = segmentEndX - segmentX;
+			int32_t* layerRow = layer.GetWritableChunkRow( IntVec2( segmentX, tileY ) );
+			const int32_t* kernelSegment = m_kernel.data() + kernelRowOffset + segmentX;
+			int offsetX = 0;
+#if defined(INFLUENCE_MAP_USE_SSE)
+			for( ; offsetX + 4 <= segmentLength; offsetX += 4 )
+			{
+				__m128i values = _mm_loadu_si128( reinterpret_cast<const __m128i*>(layerRow + offsetX) );
+				__m128i kernelValues = _mm_loadu_si128( reinterpret_cast<const __m128i*>(kernelSegment + offsetX) );
+				values = _mm_add_epi32( values, _mm_madd_epi16( kernelValues, weights ) );
+				_mm_storeu_si128( reinterpret_cast<__m128i*>(layerRow + offsetX), values );
+			}
+#endif
+			for( ; offsetX < segmentLength; offsetX++ )
+			{
+				layerRow[offsetX] += kernelSegment[offsetX] * weight;
+			}
+			segmentX = segmentEndX;
+		}
+	}
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include "Engine/Math/IntVec2.hpp"
+#include "Engine/Math/Vec2.hpp"
+#include "Game/Entity.hpp"
+#include "Game/ChunkedTileLayer.hpp"
+
+//////////////////////////////////////////////////////////////////////////
+//threat and opportunity per faction over the tile grid, each source stamps a linear falloff of INFLUENCE_MAP_RADIUS tiles
+//threat: units of any other faction, opportunity: pickups of any other faction and turrets of the faction itself
+//stamps are exact integer sums, so a source that moves or dies is taken out by subtracting the stamp it added
+//layers are 32 bit, a source adds at most radius * weight to a tile, so 16 bit layers wrapped with about a thousand sources on one spot
+//layers are chunked, only chunks a source has reached take memory, so the map size does not matter
+//influence ignores walls, it only tells which way things are, steering still goes around them
+class InfluenceMap
+{
+public:
+	InfluenceMap() = default;
+	~InfluenceMap() = default;
+
+	void Startup( const IntVec2& dimensions, int radius );
+	void Shutdown();
+	//zero influence everywhere, for when every source is gone at once
+	void Reset();
+
+	bool IsBuilt() const { return !m_kernel.empty(); }
+	bool IsInBounds( const IntVec2& tileCoords ) const;
+	static bool IsSourceType( EntityType type );
+
+	//sources have to be removed with the same coords, type and faction they were added with
+	void AddSource( const IntVec2& tileCoords, EntityType type, EntityFaction faction );
+	void RemoveSource( const IntVec2& tileCoords, EntityType type, EntityFaction faction );
+
+	int  GetThreat( const IntVec2& tileCoords, EntityFaction faction ) const;
+	int  GetOpportunity( const IntVec2& tileCoords, EntityFaction faction ) const;
+	//central difference of threatWeight * threat + opportunityWeight * opportunity, zero where nothing reaches
+	Vec2 GetGradient( const IntVec2& tileCoords, EntityFaction faction, float threatWeight, float opportunityWeight ) const;
+
+private:
+	IntVec2 m_dimensions;
+	int m_radius = 0;
+	int m_kernelSize = 0;
+	//kernelSize x kernelSize falloff centered on the source tile, radius at the center and 0 from radius tiles out
+	std::vector<int32_t> m_kernel;
+	ChunkedTileLayer<int32_t> m_threat[NUM_FACTIONS];
+	ChunkedTileLayer<int32_t> m_opportunity[NUM_FACTIONS];
+
+	void StampSource( const IntVec2& tileCoords, EntityType type, EntityFaction faction, int sign );
+	void StampLayer( ChunkedTileLayer<int32_t>& layer, const IntVec2& tileCoords, int weight );
+	float GetWeightedValue( const IntVec2& tileCoords, EntityFaction faction, float threatWeight, float opportunityWeight ) const;
+};
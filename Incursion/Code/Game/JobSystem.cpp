@@ -0,0 +1,313 @@
+#include "Game/JobSystem.hpp"
+#include <algorithm>
+
+//ids instead of pointers, so a new job system at the address of a deleted one is never mistaken for it
+static std::atomic<int> s_nextJobSystemID( 1 );
+//job system the current thread last worked for and its queue in that system, a worker queue or an outside queue
+static thread_local int s_threadJobSystemID = 0;
+static thread_local int s_threadQueueIndex = -1;
+
+//////////////////////////////////////////////////////////////////////////
+Job::Job( const std::function<void()>& work )
+	:m_work(work)
+	,m_numBlockers(1)
+	,m_isFinished(false)
+{
+}
+
+//////////////////////////////////////////////////////////////////////////
+JobSystem::JobSystem( int numWorkers )
+	:m_id(s_nextJobSystemID.fetch_add( 1 ))
+	,m_numWorkers(numWorkers)
+	,m_numOutsideThreads(0)
+	,m_numQueuedJobs(0)
+	,m_numOpenParallelFors(0)
+	,m_isQuitting(false)
+{
+	for( int queueID = 0; queueID < numWorkers + MAX_OUTSIDE_THREADS; queueID++ )
+	{
+		m_queues.emplace_back( new JobQueue() );
+	}
+	m_workers.reserve( numWorkers );
+	for( int workerID = 0; workerID < numWorkers; workerID++ )
+	{
+		m_workers.emplace_back( &JobSystem::WorkerMain, this, workerID );
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock( m_sleepMutex );
+		m_isQuitting = true;
+	}
+	m_wakeCondition.notify_all();
+	for( std::thread& worker : m_workers )
+	{
+		worker.join();
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+JobHandle JobSystem::CreateJob( const std::function<void()>& work )
+{
+	return std::make_shared<Job>( work );
+}
+
+//////////////////////////////////////////////////////////////////////////
+void JobSystem::AddDependency( const JobHandle& job, const JobHandle& prerequisite )
+{
+	std::lock_guard<std::mutex> lock( prerequisite->m_dependentsMutex );
+	if( prerequisite->IsFinished() )
+		return;
+	job->m_numBlockers.fetch_add( 1 );
+	prerequisite->m_dependents.push_back( job );
+}
+
+//////////////////////////////////////////////////////////////////////////
+void JobSystem::Submit( const JobHandle& job )
+{
+	//drop the hold taken at creation, the job runs now if nothing else blocks it
+	if( job->m_numBlockers.fetch_sub( 1 ) == 1 )
+		Enqueue( job );
+}
+
+//////////////////////////////////////////////////////////////////////////
+void JobSystem::Wait( const JobHandle& job )
+{
+	//outside threads only run jobs from their own queue, workers run anything
+	while( !job->IsFinished() )
+	{
+		if( !TryRunOneJob() )
+			std::this_thread::yield();
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+void JobSystem::WaitAll( const std::vector<JobHandle>& jobs )
+{
+	for( const JobHandle& job : jobs )
+	{
+		Wait( job );
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+void JobSystem::WorkerMain( int workerIndex )
+{
+	s_threadJobSystemID = m_id;
+	s_threadQueueIndex = workerIndex;
+	while( !m_isQuitting )
+	{
+		if( TryRunOneJob() )
+			continue;
+		std::unique_lock<std::mutex> lock( m_sleepMutex );
+		m_wakeCondition.wait( lock, [this]() { return m_isQuitting || m_numQueuedJobs.load() > 0 || m_numOpenParallelFors.load() > 0; } );
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool JobSystem::IsPoolThread() const
+{
+	return s_threadJobSystemID == m_id && s_threadQueueIndex < GetNumWorkers();
+}
+
+//////////////////////////////////////////////////////////////////////////
+int JobSystem::GetQueueIndexForThisThread()
+{
+	if( s_threadJobSystemID == m_id )
+		return s_threadQueueIndex;
+	//first use from a thread outside the pool
+	int outsideIndex = std::min( m_numOutsideThreads.fetch_add( 1 ), MAX_OUTSIDE_THREADS - 1 );
+	s_threadJobSystemID = m_id;
+	s_threadQueueIndex = GetNumWorkers() + outsideIndex;
+	return s_threadQueueIndex;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void JobSystem::Enqueue( const JobHandle& job )
+{
+	JobQueue& queue = *m_queues[GetQueueIndexForThisThread()];
+	{
+		std::lock_guard<std::mutex> lock( queue.m_mutex );
+		queue.m_jobs.push_back( job );
+	}
+	m_numQueuedJobs.fetch_add( 1 );
+	WakeWorkers( false );
+}
+
+//////////////////////////////////////////////////////////////////////////
+void JobSystem::WakeWorkers( bool wakeAll )
+{
+	//taking the lock keeps a worker from missing the wake up between its check and its wait
+	{
+		std::lock_guard<std::mutex> lock( m_sleepMutex );
+	}
+	if( wakeAll )
+		m_wakeCondition.notify_all();
+	else m_wakeCondition.notify_one();
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool JobSystem::TryRunOneJob()
+{
+	int queueIndex = GetQueueIndexForThisThread();
+	bool isPoolThread = IsPoolThread();
+	if( isPoolThread && TryRunParallelForChunk( nullptr ) )
+		return true;
+	JobHandle job = PopOwnJob( queueIndex );
+	if( job == nullptr && isPoolThread )
+		job = StealJob( queueIndex );
+	if( job == nullptr )
+		return false;
+	RunJob( job );
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+JobHandle JobSystem::PopOwnJob( int queueIndex )
+{
+	JobQueue& queue = *m_queues[queueIndex];
+	std::lock_guard<std::mutex> lock( queue.m_mutex );
+	if( queue.m_jobs.empty() )
+		return nullptr;
+	//newest first, its data is most likely still in cache
+	JobHandle job = queue.m_jobs.back();
+	queue.m_jobs.pop_back();
+	m_numQueuedJobs.fetch_sub( 1 );
+	return job;
+}
+
+//////////////////////////////////////////////////////////////////////////
+JobHandle JobSystem::StealJob( int thiefQueueIndex )
+{
+	int numQueues = (int)m_queues.size();
+	for( int offset = 1; offset < numQueues; offset++ )
+	{
+		JobQueue& queue = *m_queues[(thiefQueueIndex + offset) % numQueues];
+		std::lock_guard<std::mutex> lock( queue.m_mutex );
+		if( queue.m_jobs.empty() )
+			continue;
+		//oldest first, those tend to be the biggest pieces of work
+		JobHandle job = queue.m_jobs.front();
+		queue.m_jobs.pop_front();
+		m_numQueuedJobs.fetch_sub( 1 );
+		return job;
+	}
+	return nullptr;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void JobSystem::RunJob( const JobHandle& job )
+{
+	job->m_work();
+
+	std::vector<JobHandle> dependents;
+	{
+		std::lock_guard<std::mutex> lock( job->m_dependentsMutex );
+		job->m_isFinished.store( true, std::memory_order_release );
+		dependents.swap( job->m_dependents );
+	}
+	for( const JobHandle& dependent : dependents )
+	{
+		if( dependent->m_numBlockers.fetch_sub( 1 ) == 1 )
+			Enqueue( dependent );
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+void JobSystem::RunParallelFor( int count, int grainSize, const void* rangeFunction, RunRangeFunc runRange )
+{
+	if( count <= 0 )
+		return;
+	//a few chunks per thread is enough for the pool to even out the load
+	int numThreads = GetNumWorkers() + 1;
+	int chunkSize = std::max( std::max( grainSize, 1 ), (count + numThreads * 4 - 1) / (numThreads * 4) );
+	if( m_workers.empty() || count <= chunkSize )
+	{
+		runRange( rangeFunction, 0, count );
+		return;
+	}
+
+	ParallelForBatch batch;
+	batch.m_rangeFunction = rangeFunction;
+	batch.m_runRange = runRange;
+	batch.m_count = count;
+	batch.m_chunkSize = chunkSize;
+	batch.m_numChunks = (count + chunkSize - 1) / chunkSize;
+	batch.m_numUnfinishedChunks.store( batch.m_numChunks );
+	int slot = -1;
+	{
+		std::lock_guard<std::mutex> lock( m_parallelForMutex );
+		for( int slotID = 0; slotID < MAX_PARALLEL_FORS; slotID++ )
+		{
+			if( m_parallelFors[slotID] == nullptr )
+			{
+				m_parallelFors[slotID] = &batch;
+				m_numOpenParallelFors.fetch_add( 1 );
+				slot = slotID;
+				break;
+			}
+		}
+	}
+	if( slot < 0 )
+	{
+		runRange( rangeFunction, 0, count );
+		return;
+	}
+	WakeWorkers( true );
+
+	//help with this loop only, then wait for the chunks other threads have claimed
+	while( TryRunParallelForChunk( &batch ) )
+	{
+	}
+	while( batch.m_numUnfinishedChunks.load( std::memory_order_acquire ) > 0 )
+	{
+		std::this_thread::yield();
+	}
+	std::lock_guard<std::mutex> lock( m_parallelForMutex );
+	m_parallelFors[slot] = nullptr;
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool JobSystem::TryRunParallelForChunk( ParallelForBatch* ownBatch )
+{
+	if( ownBatch == nullptr && m_numOpenParallelFors.load() == 0 )
+		return false;
+
+	//claimed under the lock, so a batch is never unregistered between being found and being claimed from
+	ParallelForBatch* batch = nullptr;
+	int chunkIndex = 0;
+	{
+		std::lock_guard<std::mutex> lock( m_parallelForMutex );
+		if( ownBatch != nullptr )
+		{
+			if( ownBatch->m_nextChunk < ownBatch->m_numChunks )
+				batch = ownBatch;
+		}
+		else
+		{
+			for( ParallelForBatch* openBatch : m_parallelFors )
+			{
+				if( openBatch != nullptr && openBatch->m_nextChunk < openBatch->m_numChunks )
+				{
+					batch = openBatch;
+					break;
+				}
+			}
+		}
+		if( batch == nullptr )
+			return false;
+		chunkIndex = batch->m_nextChunk++;
+		if( batch->m_nextChunk == batch->m_numChunks )
+			m_numOpenParallelFors.fetch_sub( 1 );
+	}
+
+	int beginIndex = chunkIndex * batch->m_chunkSize;
+	int endIndex = std::min( beginIndex + batch->m_chunkSize, batch->m_count );
+	batch->m_runRange( batch->m_rangeFunction, beginIndex, endIndex );
+	//the batch may be gone right after this
+	batch->m_numUnfinishedChunks.fetch_sub( 1, std::memory_order_release );
+	return true;
+}
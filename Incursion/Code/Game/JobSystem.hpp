@@ -0,0 +1,125 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+class Job;
+typedef std::shared_ptr<Job> JobHandle;
+
+//////////////////////////////////////////////////////////////////////////
+//one unit of work, runs once all the jobs it depends on have finished
+class Job
+{
+	friend class JobSystem;
+
+public:
+	explicit Job( const std::function<void()>& work );
+
+	bool IsFinished() const { return m_isFinished.load( std::memory_order_acquire ); }
+
+private:
+	std::function<void()> m_work;
+	//unfinished dependencies, plus one until the job is submitted
+	std::atomic<int> m_numBlockers;
+	std::atomic<bool> m_isFinished;
+	std::mutex m_dependentsMutex;
+	std::vector<JobHandle> m_dependents;
+};
+
+//////////////////////////////////////////////////////////////////////////
+//work stealing scheduler: every thread of the pool owns a queue, takes its newest job first and steals the oldest job of others
+//every thread outside the pool gets a queue of its own, and while it waits it only runs jobs from that queue,
+//so the render thread never runs simulation work or the other way around
+//parallel fors are not jobs: their chunks are claimed from a descriptor on the caller's stack, nothing is allocated
+class JobSystem
+{
+public:
+	//outside threads past this many share the last outside queue
+	static constexpr int MAX_OUTSIDE_THREADS = 4;
+	//parallel fors running at once, nested ones included, any further ones run on the calling thread only
+	static constexpr int MAX_PARALLEL_FORS = 64;
+
+	explicit JobSystem( int numWorkers );
+	~JobSystem();
+
+	JobHandle CreateJob( const std::function<void()>& work );
+	void AddDependency( const JobHandle& job, const JobHandle& prerequisite );
+	void Submit( const JobHandle& job );
+	void Wait( const JobHandle& job );
+	void WaitAll( const std::vector<JobHandle>& jobs );
+
+	//calls rangeFunction on [beginIndex, endIndex) chunks of at least grainSize that together cover [0, count)
+	//the caller runs chunks too and, like Wait on an outside thread, only ever runs chunks of its own loop
+	template<typename RangeFunction>
+	void ParallelFor( int count, int grainSize, const RangeFunction& rangeFunction );
+	int  GetNumWorkers() const { return m_numWorkers; }
+
+private:
+	struct JobQueue
+	{
+		std::mutex m_mutex;
+		std::deque<JobHandle> m_jobs;
+	};
+
+	typedef void (*RunRangeFunc)( const void* rangeFunction, int beginIndex, int endIndex );
+
+	//lives on the stack of the thread running the parallel for, registered in m_parallelFors until every chunk is done
+	struct ParallelForBatch
+	{
+		const void*  m_rangeFunction = nullptr;
+		RunRangeFunc m_runRange = nullptr;
+		int m_count = 0;
+		int m_chunkSize = 0;
+		int m_numChunks = 0;
+		//claimed under m_parallelForMutex
+		int m_nextChunk = 0;
+		std::atomic<int> m_numUnfinishedChunks{ 0 };
+	};
+
+	int m_id = 0;
+	//fixed before any worker starts, workers read it while m_workers is still being filled
+	int m_numWorkers = 0;
+	std::vector<std::thread> m_workers;
+	//one queue per worker, then MAX_OUTSIDE_THREADS queues for the threads outside the pool
+	std::vector<std::unique_ptr<JobQueue>> m_queues;
+	std::atomic<int> m_numOutsideThreads;
+	std::atomic<int> m_numQueuedJobs;
+	std::mutex m_parallelForMutex;
+	ParallelForBatch* m_parallelFors[MAX_PARALLEL_FORS] = {};
+	//parallel fors with chunks nobody has claimed yet
+	std::atomic<int> m_numOpenParallelFors;
+	std::mutex m_sleepMutex;
+	std::condition_variable m_wakeCondition;
+	std::atomic<bool> m_isQuitting;
+
+	void WorkerMain( int workerIndex );
+	bool IsPoolThread() const;
+	int  GetQueueIndexForThisThread();
+	void Enqueue( const JobHandle& job );
+	void WakeWorkers( bool wakeAll );
+	bool TryRunOneJob();
+	JobHandle PopOwnJob( int queueIndex );
+	JobHandle StealJob( int thiefQueueIndex );
+	void RunJob( const JobHandle& job );
+
+	void RunParallelFor( int count, int grainSize, const void* rangeFunction, RunRangeFunc runRange );
+	//ownBatch nullptr runs a chunk of any open parallel for
+	bool TryRunParallelForChunk( ParallelForBatch* ownBatch );
+};
+
+//////////////////////////////////////////////////////////////////////////
+template<typename RangeFunction>
+void JobSystem::ParallelFor( int count, int grainSize, const RangeFunction& rangeFunction )
+{
+	//the loop body is passed by address with a plain function to call it, so no std::function is built
+	RunParallelFor( count, grainSize, &rangeFunction, []( const void* function, int beginIndex, int endIndex )
+	{
+		(*static_cast<const RangeFunction*>(function))( beginIndex, endIndex );
+	} );
+}
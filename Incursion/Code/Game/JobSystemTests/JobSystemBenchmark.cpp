@@ -0,0 +1,67 @@
+#include "Game/JobSystem.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////
+//a few hundred flops per item, about the cost of one entity's quad transform or tile row
+static float DoItemWork( int index )
+{
+	float value = (float)index;
+	for( int step = 0; step < 64; step++ )
+	{
+		value = sinf( value ) * 1.0001f + cosf( value * .5f );
+	}
+	return value;
+}
+
+//////////////////////////////////////////////////////////////////////////
+static double MeasureMillisecondsPerLoop( JobSystem& jobSystem, std::vector<float>& results, int grainSize, int numRepeats )
+{
+	auto RunLoop = [&]()
+	{
+		jobSystem.ParallelFor( (int)results.size(), grainSize, [&]( int beginIndex, int endIndex )
+		{
+			for( int index = beginIndex; index < endIndex; index++ )
+			{
+				results[index] = DoItemWork( index );
+			}
+		} );
+	};
+	RunLoop();
+	auto startTime = std::chrono::steady_clock::now();
+	for( int repeat = 0; repeat < numRepeats; repeat++ )
+	{
+		RunLoop();
+	}
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - startTime;
+	return elapsed.count() / (double)numRepeats;
+}
+
+//////////////////////////////////////////////////////////////////////////
+//JobSystemBenchmark [numItems] [grainSize] [numRepeats], one row per thread count from 1 to the number of cores
+int main( int argc, char** argv )
+{
+	int numItems = argc > 1 ? atoi( argv[1] ) : 200000;
+	int grainSize = argc > 2 ? atoi( argv[2] ) : 256;
+	int numRepeats = argc > 3 ? atoi( argv[3] ) : 10;
+	int numCores = std::max( (int)std::thread::hardware_concurrency(), 1 );
+	std::vector<float> results( numItems );
+
+	printf( "%d items, grain %d, %d repeats, %d cores\n", numItems, grainSize, numRepeats, numCores );
+	printf( "threads      ms/loop   speedup\n" );
+	double serialMilliseconds = 0.0;
+	for( int numThreads = 1; numThreads <= numCores; numThreads++ )
+	{
+		//the calling thread runs chunks too
+		JobSystem jobSystem( numThreads - 1 );
+		double milliseconds = MeasureMillisecondsPerLoop( jobSystem, results, grainSize, numRepeats );
+		if( numThreads == 1 )
+			serialMilliseconds = milliseconds;
+		printf( "%7d %12.3f %9.2fx\n", numThreads, milliseconds, serialMilliseconds / milliseconds );
+	}
+	return 0;
+}
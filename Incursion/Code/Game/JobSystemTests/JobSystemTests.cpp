@@ -0,0 +1,253 @@
+#include "Game/JobSystem.hpp"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <vector>
+
+//every heap allocation of the process, to check that parallel fors allocate nothing
+static std::atomic<long long> s_numAllocations( 0 );
+
+void* operator new( size_t numBytes )
+{
+	s_numAllocations.fetch_add( 1 );
+	void* pointer = malloc( numBytes > 0 ? numBytes : 1 );
+	if( pointer == nullptr )
+		throw std::bad_alloc();
+	return pointer;
+}
+
+void operator delete( void* pointer ) noexcept
+{
+	free( pointer );
+}
+
+void operator delete( void* pointer, size_t ) noexcept
+{
+	free( pointer );
+}
+
+static int s_numFailures = 0;
+
+#define CHECK( condition ) \
+	do { if( !(condition) ) { printf( "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #condition ); s_numFailures++; } } while( false )
+
+//////////////////////////////////////////////////////////////////////////
+static void TestParallelForCoversEveryIndexOnce()
+{
+	const int numWorkerCounts[] = { 0, 1, 3, 7 };
+	const int counts[] = { 1, 5, 64, 1000, 12345 };
+	const int grainSizes[] = { 1, 4, 256 };
+	for( int numWorkers : numWorkerCounts )
+	{
+		JobSystem jobSystem( numWorkers );
+		for( int count : counts )
+		{
+			for( int grainSize : grainSizes )
+			{
+				std::vector<std::atomic<int>> hits( count );
+				jobSystem.ParallelFor( count, grainSize, [&]( int beginIndex, int endIndex )
+				{
+					CHECK( beginIndex >= 0 && beginIndex < endIndex && endIndex <= count );
+					for( int index = beginIndex; index < endIndex; index++ )
+					{
+						hits[index].fetch_add( 1 );
+					}
+				} );
+				for( int index = 0; index < count; index++ )
+				{
+					CHECK( hits[index].load() == 1 );
+				}
+			}
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+static void TestNestedParallelFor()
+{
+	JobSystem jobSystem( 4 );
+	const int numRows = 37;
+	const int numColumns = 211;
+	std::vector<std::atomic<int>> hits( numRows * numColumns );
+	jobSystem.ParallelFor( numRows, 1, [&]( int beginRow, int endRow )
+	{
+		for( int row = beginRow; row < endRow; row++ )
+		{
+			jobSystem.ParallelFor( numColumns, 8, [&]( int beginColumn, int endColumn )
+			{
+				for( int column = beginColumn; column < endColumn; column++ )
+				{
+					hits[row * numColumns + column].fetch_add( 1 );
+				}
+			} );
+		}
+	} );
+	for( std::atomic<int>& hit : hits )
+	{
+		CHECK( hit.load() == 1 );
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+static void TestParallelForDoesNotAllocate()
+{
+	JobSystem jobSystem( 3 );
+	std::vector<int> values( 100000, 1 );
+	std::atomic<long long> sum( 0 );
+	auto sumRange = [&]( int beginIndex, int endIndex )
+	{
+		long long rangeSum = 0;
+		for( int index = beginIndex; index < endIndex; index++ )
+		{
+			rangeSum += values[index];
+		}
+		sum.fetch_add( rangeSum );
+	};
+	//the first call registers this thread as an outside thread
+	jobSystem.ParallelFor( (int)values.size(), 256, sumRange );
+	long long numAllocationsBefore = s_numAllocations.load();
+	for( int repeat = 0; repeat < 100; repeat++ )
+	{
+		jobSystem.ParallelFor( (int)values.size(), 256, sumRange );
+	}
+	CHECK( s_numAllocations.load() == numAllocationsBefore );
+	CHECK( sum.load() == 101LL * (long long)values.size() );
+}
+
+//////////////////////////////////////////////////////////////////////////
+static void TestDependencies()
+{
+	JobSystem jobSystem( 4 );
+	for( int repeat = 0; repeat < 200; repeat++ )
+	{
+		//diamond: first, two middles, last
+		std::atomic<int> order( 0 );
+		int firstOrder = -1;
+		int middleOrders[2] = { -1, -1 };
+		int lastOrder = -1;
+		JobHandle first = jobSystem.CreateJob( [&]() { firstOrder = order.fetch_add( 1 ); } );
+		JobHandle middleA = jobSystem.CreateJob( [&]() { middleOrders[0] = order.fetch_add( 1 ); } );
+		JobHandle middleB = jobSystem.CreateJob( [&]() { middleOrders[1] = order.fetch_add( 1 ); } );
+		JobHandle last = jobSystem.CreateJob( [&]() { lastOrder = order.fetch_add( 1 ); } );
+		jobSystem.AddDependency( middleA, first );
+		jobSystem.AddDependency( middleB, first );
+		jobSystem.AddDependency( last, middleA );
+		jobSystem.AddDependency( last, middleB );
+		//submitted in reverse, nothing may start before its prerequisites
+		jobSystem.Submit( last );
+		jobSystem.Submit( middleB );
+		jobSystem.Submit( middleA );
+		CHECK( !last->IsFinished() );
+		jobSystem.Submit( first );
+		jobSystem.Wait( last );
+		CHECK( first->IsFinished() && middleA->IsFinished() && middleB->IsFinished() );
+		CHECK( firstOrder == 0 );
+		CHECK( middleOrders[0] > firstOrder && middleOrders[1] > firstOrder );
+		CHECK( lastOrder == 3 );
+	}
+
+	//a prerequisite that already finished does not hold anything back
+	JobHandle done = jobSystem.CreateJob( []() {} );
+	jobSystem.Submit( done );
+	jobSystem.Wait( done );
+	bool hasRun = false;
+	JobHandle after = jobSystem.CreateJob( [&]() { hasRun = true; } );
+	jobSystem.AddDependency( after, done );
+	jobSystem.Submit( after );
+	jobSystem.Wait( after );
+	CHECK( hasRun );
+}
+
+//////////////////////////////////////////////////////////////////////////
+static void TestWaitFromOutsideThreads()
+{
+	//several threads outside the pool submit, wait and run parallel fors at the same time
+	JobSystem jobSystem( 3 );
+	std::atomic<int> numFinished( 0 );
+	std::vector<std::thread> outsideThreads;
+	for( int threadID = 0; threadID < 3; threadID++ )
+	{
+		outsideThreads.emplace_back( [&]()
+		{
+			for( int repeat = 0; repeat < 100; repeat++ )
+			{
+				std::atomic<int> numRun( 0 );
+				std::vector<JobHandle> jobs;
+				for( int jobID = 0; jobID < 8; jobID++ )
+				{
+					jobs.push_back( jobSystem.CreateJob( [&]() { numRun.fetch_add( 1 ); } ) );
+					jobSystem.Submit( jobs.back() );
+				}
+				jobSystem.WaitAll( jobs );
+				CHECK( numRun.load() == 8 );
+				std::atomic<int> sum( 0 );
+				jobSystem.ParallelFor( 1000, 16, [&]( int beginIndex, int endIndex ) { sum.fetch_add( endIndex - beginIndex ); } );
+				CHECK( sum.load() == 1000 );
+			}
+			numFinished.fetch_add( 1 );
+		} );
+	}
+	for( std::thread& outsideThread : outsideThreads )
+	{
+		outsideThread.join();
+	}
+	CHECK( numFinished.load() == 3 );
+}
+
+//////////////////////////////////////////////////////////////////////////
+static void TestOutsideWaitRunsOnlyOwnJobs()
+{
+	//without workers a job only runs on the outside thread that submitted it, once that thread waits
+	JobSystem jobSystem( 0 );
+	std::atomic<bool> isOtherJobSubmitted( false );
+	std::atomic<bool> mayOtherThreadWait( false );
+	std::thread::id otherJobThread;
+	JobHandle otherJob = jobSystem.CreateJob( [&]() { otherJobThread = std::this_thread::get_id(); } );
+	std::thread otherThread( [&]()
+	{
+		jobSystem.Submit( otherJob );
+		isOtherJobSubmitted = true;
+		while( !mayOtherThreadWait )
+		{
+			std::this_thread::yield();
+		}
+		jobSystem.Wait( otherJob );
+	} );
+	while( !isOtherJobSubmitted )
+	{
+		std::this_thread::yield();
+	}
+
+	bool hasOwnJobRun = false;
+	JobHandle ownJob = jobSystem.CreateJob( [&]() { hasOwnJobRun = true; } );
+	jobSystem.Submit( ownJob );
+	jobSystem.Wait( ownJob );
+	CHECK( hasOwnJobRun );
+	CHECK( !otherJob->IsFinished() );
+
+	std::thread::id otherThreadID = otherThread.get_id();
+	mayOtherThreadWait = true;
+	otherThread.join();
+	CHECK( otherJob->IsFinished() );
+	CHECK( otherJobThread == otherThreadID );
+}
+
+//////////////////////////////////////////////////////////////////////////
+int main()
+{
+	TestParallelForCoversEveryIndexOnce();
+	TestNestedParallelFor();
+	TestParallelForDoesNotAllocate();
+	TestDependencies();
+	TestWaitFromOutsideThreads();
+	TestOutsideWaitRunsOnlyOwnJobs();
+	if( s_numFailures > 0 )
+	{
+		printf( "%d checks failed\n", s_numFailures );
+		return 1;
+	}
+	printf( "all job system tests passed\n" );
+	return 0;
+}
@@ -0,0 +1,219 @@
+#include "Game/LineOfSightCache.hpp"
+#include "Game/Map.hpp"
+#include "Game/GameCommon.hpp"
+#include <algorithm>
+#include <cstdlib>
+
+//////////////////////////////////////////////////////////////////////////
+void LineOfSightCache::Startup( const Map* map, const IntVec2& dimensions, int radius )
+{
+	m_map = map;
+	m_dimensions = dimensions;
+	m_radius = radius;
+	m_windowSize = 2 * radius + 1;
+	m_numWordsPerTile = (m_windowSize * m_windowSize + 63) / 64;
+
+	//one pointer and one flag per chunk, chunks are built when a query asks for them
+	m_chunkDimensions.x = (dimensions.x + TILE_CHUNK_SIZE - 1) >> TILE_CHUNK_SIZE_LOG2;
+	m_chunkDimensions.y = (dimensions.y + TILE_CHUNK_SIZE - 1) >> TILE_CHUNK_SIZE_LOG2;
+	size_t numChunks = (size_t)m_chunkDimensions.x * (size_t)m_chunkDimensions.y;
+	m_chunks.clear();
+	m_chunks.resize( numChunks );
+	m_isChunkRequested = std::make_unique<std::atomic<bool>[]>( numChunks );
+	for( size_t chunkIndex = 0; chunkIndex < numChunks; chunkIndex++ )
+	{
+		m_isChunkRequested[chunkIndex].store( false, std::memory_order_relaxed );
+	}
+	m_numRequestedChunks.store( 0, std::memory_order_relaxed );
+	m_dirtyTiles.clear();
+}
+
+//////////////////////////////////////////////////////////////////////////
+void LineOfSightCache::Shutdown()
+{
+	m_map = nullptr;
+	m_chunks.clear();
+	m_chunks.shrink_to_fit();
+	m_isChunkRequested.reset();
+	m_numRequestedChunks.store( 0, std::memory_order_relaxed );
+	m_dirtyTiles.clear();
+	m_dirtyTiles.shrink_to_fit();
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool LineOfSightCache::IsAlwaysVisible( const IntVec2& fromCoords, const IntVec2& toCoords ) const
+{
+	if( !IsBuilt() || !IsInBounds( fromCoords ) || !IsInBounds( toCoords ) )
+		return false;
+	int deltaX = toCoords.x - fromCoords.x;
+	int deltaY = toCoords.y - fromCoords.y;
+	if( abs( deltaX ) > m_radius || abs( deltaY ) > m_radius )
+		return false;
+	size_t chunkIndex = GetChunkIndex( fromCoords );
+	const SourceChunk* chunk = m_chunks[chunkIndex].get();
+	if( chunk == nullptr )
+	{
+		//the load first keeps repeated queries from writing the shared flag
+		std::atomic<bool>& isRequested = m_isChunkRequested[chunkIndex];
+		if( !isRequested.load( std::memory_order_relaxed ) && !isRequested.exchange( true, std::memory_order_relaxed ) )
+			m_numRequestedChunks.fetch_add( 1, std::memory_order_relaxed );
+		return false;
+	}
+	int localIndex = GetLocalIndex( fromCoords );
+	if( chunk->m_isTileDirty[localIndex] )
+		return false;
+
+	int bitIndex = (deltaX + m_radius) + (deltaY + m_radius) * m_windowSize;
+	const uint64_t* tileBits = &chunk->m_visibleBits[(size_t)localIndex * m_numWordsPerTile];
+	return (tileBits[bitIndex >> 6] & (1ull << (bitIndex & 63))) != 0;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void LineOfSightCache::InvalidateRegion( const IntVec2& changedCoords )
+{
+	if( !IsBuilt() )
+		return;
+	//a pair can only be affected if the changed tile lies in its bounding box
+	int minX = std::max( changedCoords.x - m_radius, 0 );
+	int maxX = std::min( changedCoords.x + m_radius, m_dimensions.x - 1 );
+	int minY = std::max( changedCoords.y - m_radius, 0 );
+	int maxY = std::min( changedCoords.y + m_radius, m_dimensions.y - 1 );
+	for( int tileY = minY; tileY <= maxY; tileY++ )
+	{
+		for( int tileX = minX; tileX <= maxX; tileX++ )
+		{
+			IntVec2 tileCoords( tileX, tileY );
+			//chunks that are not built yet will see the change when they are
+			SourceChunk* chunk = m_chunks[GetChunkIndex( tileCoords )].get();
+			if( chunk == nullptr )
+				continue;
+			bool& isTileDirty = chunk->m_isTileDirty[GetLocalIndex( tileCoords )];
+			if( isTileDirty )
+				continue;
+			isTileDirty = true;
+			m_dirtyTiles.push_back( tileCoords );
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+void LineOfSightCache::RebuildDirtyTiles( int maxTilesToRebuild )
+{
+	if( !IsBuilt() )
+		return;
+	AllocateRequestedChunks();
+	int numRebuilt = 0;
+	while( !m_dirtyTiles.empty() && numRebuilt < maxTilesToRebuild )
+	{
+		IntVec2 tileCoords = m_dirtyTiles.back();
+		m_dirtyTiles.pop_back();
+		BuildTile( tileCoords );
+		m_chunks[GetChunkIndex( tileCoords )]->m_isTileDirty[GetLocalIndex( tileCoords )] = false;
+		numRebuilt++;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+void LineOfSightCache::AllocateRequestedChunks()
+{
+	if( m_numRequestedChunks.load( std::memory_order_relaxed ) == 0 )
+		return;
+	for( size_t chunkIndex = 0; chunkIndex < m_chunks.size(); chunkIndex++ )
+	{
+		if( !m_isChunkRequested[chunkIndex].load( std::memory_order_relaxed ) )
+			continue;
+		m_isChunkRequested[chunkIndex].store( false, std::memory_order_relaxed );
+		if( m_chunks[chunkIndex] != nullptr )
+			continue;
+		std::unique_ptr<SourceChunk> chunk = std::make_unique<SourceChunk>();
+		chunk->m_visibleBits.assign( (size_t)TILE_CHUNK_NUM_TILES * m_numWordsPerTile, 0 );
+		//every tile of a new chunk is dirty, its rows on the map edge only hold the tiles inside the map
+		IntVec2 chunkOrigin( (int)(chunkIndex % m_chunkDimensions.x) << TILE_CHUNK_SIZE_LOG2, (int)(chunkIndex / m_chunkDimensions.x) << TILE_CHUNK_SIZE_LOG2 );
+		for( int localY = 0; localY < TILE_CHUNK_SIZE; localY++ )
+		{
+			for( int localX = 0; localX < TILE_CHUNK_SIZE; localX++ )
+			{
+				IntVec2 tileCoords( chunkOrigin.x + localX, chunkOrigin.y + localY );
+				if( !IsInBounds( tileCoords ) )
+					continue;
+				chunk->m_isTileDirty[GetLocalIndex( tileCoords )] = true;
+				m_dirtyTiles.push_back( tileCoords );
+			}
+		}
+		m_chunks[chunkIndex] = std::move( chunk );
+	}
+	m_numRequestedChunks.store( 0, std::memory_order_relaxed );
+}
+
+//////////////////////////////////////////////////////////////////////////
+size_t LineOfSightCache::GetChunkIndex( const IntVec2& tileCoords ) const
+{
+	return (size_t)(tileCoords.y >> TILE_CHUNK_SIZE_LOG2) * (size_t)m_chunkDimensions.x + (size_t)(tileCoords.x >> TILE_CHUNK_SIZE_LOG2);
+}
+
+//////////////////////////////////////////////////////////////////////////
+int LineOfSightCache::GetLocalIndex( const IntVec2& tileCoords )
+{
+	return ((tileCoords.y & (TILE_CHUNK_SIZE - 1)) << TILE_CHUNK_SIZE_LOG2) | (tileCoords.x & (TILE_CHUNK_SIZE - 1));
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool LineOfSightCache::IsInBounds( const IntVec2& tileCoords ) const
+{
+	return tileCoords.x >= 0 && tileCoords.x < m_dimensions.x && tileCoords.y >= 0 && tileCoords.y < m_dimensions.y;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void LineOfSightCache::BuildTile( const IntVec2& fromCoords )
+{
+	SourceChunk& chunk = *m_chunks[GetChunkIndex( fromCoords )];
+	uint64_t* tileBits = &chunk.m_visibleBits[(size_t)GetLocalIndex( fromCoords ) * m_numWordsPerTile];
+	std::fill( tileBits, tileBits + m_numWordsPerTile, 0ull );
+
+	if( m_map->IsTileSolid( fromCoords ) )
+		return;
+	int radiusSquared = m_radius * m_radius;
+	for( int deltaY = -m_radius; deltaY <= m_radius; deltaY++ )
+	{
+		for( int deltaX = -m_radius; deltaX <= m_radius; deltaX++ )
+		{
+			IntVec2 toCoords( fromCoords.x + deltaX, fromCoords.y + deltaY );
+			if( deltaX * deltaX + deltaY * deltaY > radiusSquared || !IsInBounds( toCoords ) )
+				continue;
+			if( !IsTilePairClear( fromCoords, toCoords ) )
+				continue;
+			int bitIndex = (deltaX + m_radius) + (deltaY + m_radius) * m_windowSize;
+			tileBits[bitIndex >> 6] |= 1ull << (bitIndex & 63);
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+//the segments between two unit tiles sweep the source tile along delta, so the swept area only has
+//three separating axes: x, y and the normal of delta. any solid tile overlapping it on all three blocks the pair
+bool LineOfSightCache::IsTilePairClear( const IntVec2& fromCoords, const IntVec2& toCoords ) const
+{
+	int deltaX = toCoords.x - fromCoords.x;
+	int deltaY = toCoords.y - fromCoords.y;
+	//both tiles project to |deltaX|/2 + |deltaY|/2 on the normal, the sum of the two is the overlap distance
+	int overlapDistOnNormal = abs( deltaX ) + abs( deltaY );
+	int minX = std::min( fromCoords.x, toCoords.x );
+	int maxX = std::max( fromCoords.x, toCoords.x );
+	int minY = std::min( fromCoords.y, toCoords.y );
+	int maxY = std::max( fromCoords.y, toCoords.y );
+	for( int tileY = minY; tileY <= maxY; tileY++ )
+	{
+		for( int tileX = minX; tileX <= maxX; tileX++ )
+		{
+			IntVec2 tileCoords( tileX, tileY );
+			if( !m_map->IsTileSolid( tileCoords ) )
+				continue;
+			//normal ( -deltaY, deltaX ) dotted with the center offset, kept in integers
+			int centerDistOnNormal = -deltaY * (tileX - fromCoords.x) + deltaX * (tileY - fromCoords.y);
+			//touching counts as blocked to stay conservative
+			if( abs( centerDistOnNormal ) <= overlapDistOnNormal )
+				return false;
+		}
+	}
+	return true;
+}
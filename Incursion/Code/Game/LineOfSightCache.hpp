@@ -0,0 +1,63 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+#include "Engine/Math/IntVec2.hpp"
+#include "Game/GameCommon.hpp"
+
+class Map;
+
+//////////////////////////////////////////////////////////////////////////
+//tile to tile visibility, built per tile chunk the first time a query starts in it
+//a set bit means every point of the source tile sees every point of the target tile,
+//so a set bit answers a line of sight query, a clear bit only means the exact ray has to decide
+//each source tile keeps a (2*radius+1)^2 window centered on itself
+//a query from a chunk that is not built yet requests it and falls back to the ray, requested chunks are built
+//with the dirty tiles a few per tick, so a map of any size costs nothing up front
+class LineOfSightCache
+{
+public:
+	LineOfSightCache() = default;
+	~LineOfSightCache() = default;
+
+	void Startup( const Map* map, const IntVec2& dimensions, int radius );
+	void Shutdown();
+
+	bool IsBuilt() const { return m_map != nullptr; }
+	bool IsAlwaysVisible( const IntVec2& fromCoords, const IntVec2& toCoords ) const;
+
+	//a changed tile only dirties the sources around it, dirty sources are rebuilt a few per tick
+	void InvalidateRegion( const IntVec2& changedCoords );
+	//requested chunks are allocated first with every tile dirty
+	void RebuildDirtyTiles( int maxTilesToRebuild );
+	int  GetNumDirtyTiles() const { return (int)m_dirtyTiles.size(); }
+
+private:
+	struct SourceChunk
+	{
+		//m_numWordsPerTile words per tile in chunk tile order
+		std::vector<uint64_t> m_visibleBits;
+		bool m_isTileDirty[TILE_CHUNK_NUM_TILES] = {};
+	};
+
+	const Map* m_map = nullptr;
+	IntVec2 m_dimensions;
+	int m_radius = 0;
+	int m_windowSize = 0;
+	int m_numWordsPerTile = 0;
+	IntVec2 m_chunkDimensions;
+	std::vector<std::unique_ptr<SourceChunk>> m_chunks;
+	//set by queries that may run on any job thread, taken by RebuildDirtyTiles on the simulation thread
+	std::unique_ptr<std::atomic<bool>[]> m_isChunkRequested;
+	mutable std::atomic<int> m_numRequestedChunks{ 0 };
+	std::vector<IntVec2> m_dirtyTiles;
+
+	size_t GetChunkIndex( const IntVec2& tileCoords ) const;
+	static int GetLocalIndex( const IntVec2& tileCoords );
+	bool IsInBounds( const IntVec2& tileCoords ) const;
+	void AllocateRequestedChunks();
+	void BuildTile( const IntVec2& fromCoords );
+	bool IsTilePairClear( const IntVec2& fromCoords, const IntVec2& toCoords ) const;
+};
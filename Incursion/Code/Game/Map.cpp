@@ -12,19 +12,126 @@
 #include "Game/Pickup.hpp"
 #include "Game/World.hpp"
 #include "Game/TileDefinition.hpp"
-#include "Engine/Renderer/RenderContext.hpp"
+#include "Game/RenderSnapshot.hpp"
+#include "Game/DeterministicRNG.hpp"
+#include "Game/SpawnPlacer.hpp"
+#include "Game/JobSystem.hpp"
+#include "Game/TilePushOut.hpp"
 #include "Engine/Math/RandomNumberGenerator.hpp"
 #include "Engine/Math/AABB2.hpp"
 #include "Engine/Math/MathUtils.hpp"
 #include "Engine/Input/InputSystem.hpp"
+#include "Engine/Core/ErrorWarningAssert.hpp"
+#include "Engine/Core/StringUtils.hpp"
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include <cfloat>
+#include <filesystem>
+
+//unique across maps, so the renderer can tell tile meshes of different maps apart
+static int s_nextTileMeshVersion = 1;
+
+//indexed by CollisionPairHandler, entityA is the type the matrix row belongs to
+const Map::CollisionPairHandlerFunc Map::s_collisionPairHandlers[NUM_COLLISION_PAIR_HANDLERS] =
+{
+	nullptr,
+	&Map::ResolveEntitiesCollision,
+	&Map::ResolveBulletHit,
+	&Map::DeflectEntityOffEntity,
+	&Map::ResolveBombContact,
+	&Map::ResolvePickupCollect,
+};
+
+//fraction of displacement at which a moving point enters the box, 0 when it starts inside
+static bool GetSegmentEntryIntoAABB2( const Vec2& start, const Vec2& displacement, const AABB2& box, float& out_fraction )
+{
+	float entryFraction = 0.f;
+	float exitFraction = 1.f;
+	float starts[2] = { start.x, start.y };
+	float deltas[2] = { displacement.x, displacement.y };
+	float mins[2] = { box.mins.x, box.mins.y };
+	float maxs[2] = { box.maxs.x, box.maxs.y };
+	for( int axis = 0; axis < 2; axis++ )
+	{
+		if( deltas[axis] == 0.f )
+		{
+			if( starts[axis] < mins[axis] || starts[axis] > maxs[axis] )
+				return false;
+			continue;
+		}
+		float minFraction = (mins[axis] - starts[axis]) / deltas[axis];
+		float maxFraction = (maxs[axis] - starts[axis]) / deltas[axis];
+		if( minFraction > maxFraction )
+			std::swap( minFraction, maxFraction );
+		entryFraction = std::max( entryFraction, minFraction );
+		exitFraction = std::min( exitFraction, maxFraction );
+		if( entryFraction > exitFraction )
+			return false;
+	}
+	out_fraction = entryFraction;
+	return true;
+}
 
-std::vector<Vertex_PCU> g_tileVerts;
+//physics radius an NPC of this type gets, needed to place it before it exists
+static float GetNPCPhysicsRadius( EntityType type )
+{
+	switch( type )
+	{
+		case ENTITY_TYPE_NPC_TURRET:	return NPC_TURRET_PHYSICS_RADIUS;
+		case ENTITY_TYPE_NPC_TANK:		return NPC_TANK_PHYSICS_RADIUS;
+		case ENTITY_TYPE_BOULDER:		return BOULDER_RADIUS;
+	}
+	return 0.f;
+}
+
+//distance along a unit direction at which a ray leaves the tile chunk holding tileCoords
+static float GetRayExitDistFromChunk( const Vec2& start, const Vec2& forwardDir, const IntVec2& tileCoords )
+{
+	float chunkMinX = (float)((tileCoords.x >> TILE_CHUNK_SIZE_LOG2) << TILE_CHUNK_SIZE_LOG2);
+	float chunkMinY = (float)((tileCoords.y >> TILE_CHUNK_SIZE_LOG2) << TILE_CHUNK_SIZE_LOG2);
+	float exitDist = FLT_MAX;
+	if( forwardDir.x > 0.f )
+		exitDist = std::min( exitDist, (chunkMinX + (float)TILE_CHUNK_SIZE - start.x) / forwardDir.x );
+	else if( forwardDir.x < 0.f )
+		exitDist = std::min( exitDist, (chunkMinX - start.x) / forwardDir.x );
+	if( forwardDir.y > 0.f )
+		exitDist = std::min( exitDist, (chunkMinY + (float)TILE_CHUNK_SIZE - start.y) / forwardDir.y );
+	else if( forwardDir.y < 0.f )
+		exitDist = std::min( exitDist, (chunkMinY - start.y) / forwardDir.y );
+	return exitDist;
+}
+
+//fraction of displacement at which a moving point enters the disc, 0 when it starts inside
+static bool GetSegmentEntryIntoDisc( const Vec2& start, const Vec2& displacement, const Vec2& center, float radius, float& out_fraction )
+{
+	Vec2 centerToStart = start - center;
+	float c = centerToStart.GetLengthSquared() - radius * radius;
+	if( c <= 0.f )
+	{
+		out_fraction = 0.f;
+		return true;
+	}
+	float a = displacement.GetLengthSquared();
+	float b = DotProduct2D( centerToStart, displacement );
+	float discriminant = b * b - a * c;
+	if( a == 0.f || b >= 0.f || discriminant < 0.f )
+		return false;
+	float fraction = (-b - sqrtf( discriminant )) / a;
+	if( fraction > 1.f )
+		return false;
+	out_fraction = fraction;
+	return true;
+}
 
 Map::Map( Game* game, World* world, const IntVec2& tileDimension )
 	:m_world(world)
 	,m_game(game)
 	,m_size(tileDimension)
 {
+	m_entityGrid.Startup( m_size, SPATIAL_GRID_CELL_SIZE );
+	//the start area InitTiles clears, tiles 1 to 5 in both directions
+	AddSpawnExclusionZone( SpawnExclusionZone( Vec2( 3.5f, 3.5f ), PLAYER_START_SPAWN_EXCLUSION_RADIUS ) );
 }
 
 Map::~Map()
@@ -41,23 +148,52 @@ Map::~Map()
 		entityList.clear();
 	}
 	
-	m_tiles.clear();
+	m_tiles.Clear();
 }
 
 void Map::StartUp(int turretNum, int tankNum, int boulderNum)
 {
-	for( int turretID = 0; turretID < turretNum; turretID++ )
-	{
-		SpawnNPC( ENTITY_TYPE_NPC_TURRET, FACTION_EVIL );
-	}
-	ResolveTurretsOverlap();
-	for( int tankID = 0; tankID < tankNum; tankID++ )
+	//the whole level is placed in one pass, apart from walls, from each other and from whatever is already here
+	SpawnPlacer placer( m_size, SPATIAL_GRID_CELL_SIZE, NPC_SPAWN_MIN_SPACING );
+	for( const Entity* entity : GetAliveEntities( ENTITY_TYPE_MASK_ALL ) )
 	{
-		SpawnNPC( ENTITY_TYPE_NPC_TANK, FACTION_EVIL );
+		placer.Add( entity->m_position, entity->m_physicsRadius );
 	}
-	for( int boulderID = 0; boulderID < boulderNum; boulderID++ )
+	SpawnNPCsApart( placer, ENTITY_TYPE_NPC_TURRET, FACTION_EVIL, turretNum );
+	SpawnNPCsApart( placer, ENTITY_TYPE_NPC_TANK, FACTION_EVIL, tankNum );
+	SpawnNPCsApart( placer, ENTITY_TYPE_BOULDER, FACTION_NEUTRAL, boulderNum );
+}
+
+void Map::SpawnNPCsApart( SpawnPlacer& placer, EntityType type, EntityFaction faction, int numNPCs )
+{
+	float radius = GetNPCPhysicsRadius( type );
+	for( int npcID = 0; npcID < numNPCs; npcID++ )
 	{
-		SpawnNPC( ENTITY_TYPE_BOULDER, FACTION_NEUTRAL );
+		//dart throwing over the spawn table, each dart has to clear the walls by the clearance field
+		bool isPlaced = false;
+		for( int attemptID = 0; attemptID < NPC_SPAWN_MAX_ATTEMPTS && !isPlaced; attemptID++ )
+		{
+			Vec2 spawnPos = GetEnemySpawnPoint();
+			//a dart too close to a wall moves to its tile center, tiles too narrow for the radius are thrown again
+			if( !CanDiscFitAt( spawnPos, radius ) )
+			{
+				IntVec2 tileCoords = GetTileCoordsForPosition( spawnPos );
+				spawnPos = Vec2( (float)tileCoords.x + .5f, (float)tileCoords.y + .5f );
+				if( !CanDiscFitAt( spawnPos, radius ) )
+					continue;
+			}
+			if( !placer.IsClear( spawnPos, radius ) )
+				continue;
+			placer.Add( spawnPos, radius );
+			Entity* npcEntity = SpawnNewEntity( type, faction, spawnPos );
+			npcEntity->m_orientationDegrees = g_theGame->m_RNG->RollRandomFloatInRange( 0.f, 360.f );
+			isPlaced = true;
+		}
+		if( !isPlaced )
+		{
+			DebuggerPrintf( "No room left for entity type %d, spawned %d of %d\n", (int)type, npcID, numNPCs );
+			return;
+		}
 	}
 }
 
@@ -99,10 +235,10 @@ Entity* Map::SpawnBomb( EntityFaction faction, const Vec2& spawnPos, float orien
 
 Entity* Map::SpawnPlayer( EntityFaction faction, const Vec2& preferSpawnPosition )
 {
-	m_game->m_playerRespawnChances--;
-	if( m_game->m_playerRespawnChances < 0 )
+	m_world->m_playerRespawnChances--;
+	if( m_world->m_playerRespawnChances < 0 )
 	{
-		m_game->ProgressToState( GAME_STATE_LOSE );
+		m_world->m_hasPlayerLost = true;
 		return nullptr;
 	}
 	//guarantee that only one player alive
@@ -114,10 +250,17 @@ Entity* Map::SpawnPlayer( EntityFaction faction, const Vec2& preferSpawnPosition
 		if( playerList[pID] != nullptr )
 		{
 			trueSpawnPos = playerList[pID]->m_position;
+			if( playerList[pID]->IsAlive() )
+				m_aliveCounts[ENTITY_TYPE_PLAYER][playerList[pID]->m_faction]--;
+			RemoveInfluenceStamp( playerList[pID] );
+			m_entityGrid.Remove( playerList[pID] );
 			delete playerList[pID];
-			playerList[pID] = nullptr;
 		}
 	}
+	playerList.clear();
+	m_numHolesByType[ENTITY_TYPE_PLAYER] = 0;
+	m_player = nullptr;
+	m_playerID = INVALID_ENTITY_ID;
 	Entity* player = SpawnNewEntity( ENTITY_TYPE_PLAYER, faction, trueSpawnPos );
 	
 	return player;
@@ -145,18 +288,20 @@ void Map::AddEntityToMap( Entity* entity )
 {
 	EntityList& myList = m_entityListsByType[entity->m_type];
 	AddEntityToList( entity, myList );
+	m_entityGrid.Insert( entity );
+	if( entity->IsAlive() )
+		m_aliveCounts[entity->m_type][entity->m_faction]++;
+	if( entity->m_type == ENTITY_TYPE_PLAYER )
+	{
+		m_player = entity;
+		m_playerID = entity->m_id;
+	}
 }
 
 void Map::AddEntityToList( Entity* entity, EntityList& entityList )
 {
-	for( int eID = 0; eID < (int)entityList.size(); eID++ )
-	{
-		if( entityList[eID] == nullptr )
-		{
-			entityList[eID] = entity;
-			return;
-		}
-	}
+	//holes left by dead entities are reclaimed by CompactEntityList, not searched for here
+	entity->m_listIndex = (int)entityList.size();
 	entityList.push_back( entity );
 }
 
@@ -166,26 +311,14 @@ void Map::ResolveFactionBombExlopsion( EntityFaction faction, const Vec2& positi
 	ResolveFactionBombForEntityType( ENTITY_TYPE_NPC_TURRET, faction, position, radius );
 }
 
-int Map::GetTileIndexForTileCoords( const IntVec2& tileCoords ) const
-{
-	int index = m_size.x * tileCoords.y + tileCoords.x;
-	int totalNums = m_size.x * m_size.y - 1;
-	if( index > totalNums )
-		index = totalNums;
-	return index;
-}
-
-int Map::GetTileIndexForPosition( const Vec2& position ) const
+int64_t Map::GetTileIndexForTileCoords( const IntVec2& tileCoords ) const
 {
-	IntVec2 tileCoords = GetTileCoordsForPosition( position );
-	return GetTileIndexForTileCoords( tileCoords );
+	return m_tiles.GetTileIndex( tileCoords );
 }
 
-IntVec2 Map::GetTileCoordsForTileIndex( int tileIndex ) const
+IntVec2 Map::GetTileCoordsForTileIndex( int64_t tileIndex ) const
 {
-	int y = tileIndex / m_size.x;
-	int x = tileIndex - y * m_size.x;
-	return IntVec2( x, y );
+	return m_tiles.GetTileCoordsForTileIndex( tileIndex );
 }
 
 IntVec2 Map::GetTileCoordsForPosition( const Vec2& position ) const
@@ -197,35 +330,130 @@ IntVec2 Map::GetTileCoordsForPosition( const Vec2& position ) const
 
 Entity* Map::GetPlayerAlive() const
 {
-	EntityList playerList = m_entityListsByType[ENTITY_TYPE_PLAYER];
-	if( playerList.size() < 1 )
-		return nullptr;
-
-	Entity* player = playerList[0];
-	if( player!=nullptr && player->IsAlive() )
-		return player;
+	//cached when the player is added, no list scan
+	if( m_player != nullptr && m_player->IsAlive() )
+		return m_player;
 	else return nullptr;
 }
 
+void Map::DetachPlayer()
+{
+	for( Entity* player : GetAliveEntitiesOfType( ENTITY_TYPE_PLAYER ) )
+	{
+		m_aliveCounts[ENTITY_TYPE_PLAYER][player->m_faction]--;
+		RemoveInfluenceStamp( player );
+	}
+	for( const Entity* player : m_entityListsByType[ENTITY_TYPE_PLAYER] )
+	{
+		m_entityGrid.Remove( player );
+	}
+	m_entityListsByType[ENTITY_TYPE_PLAYER].clear();
+	m_numHolesByType[ENTITY_TYPE_PLAYER] = 0;
+	m_player = nullptr;
+	m_playerID = INVALID_ENTITY_ID;
+}
+
+int Map::GetAliveCountForType( EntityType type ) const
+{
+	int count = 0;
+	for( int factionID = 0; factionID < (int)NUM_FACTIONS; factionID++ )
+	{
+		count += m_aliveCounts[type][factionID];
+	}
+	return count;
+}
+
+int Map::GetAliveCountForFaction( EntityTypeMask typeMask, EntityFaction faction ) const
+{
+	int count = 0;
+	for( int typeID = 0; typeID < (int)NUM_ENTITY_TYPES; typeID++ )
+	{
+		if( (typeMask & GetEntityTypeMask( (EntityType)typeID )) != 0 )
+			count += m_aliveCounts[typeID][faction];
+	}
+	return count;
+}
+
+void Map::NotifyEntityDied( Entity* entity )
+{
+	m_aliveCounts[entity->m_type][entity->m_faction]--;
+	RemoveInfluenceStamp( entity );
+	if( entity->m_type != ENTITY_TYPE_PLAYER )
+		m_destructionQueue.push_back( entity );
+}
+
+void Map::NotifyEntityFactionSwitched( const Entity* entity, EntityFaction oldFaction )
+{
+	if( !entity->IsAlive() )
+		return;
+	m_aliveCounts[entity->m_type][oldFaction]--;
+	m_aliveCounts[entity->m_type][entity->m_faction]++;
+}
+
+EntityView Map::GetAliveEntities( EntityTypeMask typeMask ) const
+{
+	return EntityView( m_entityListsByType, typeMask );
+}
+
+EntityView Map::GetAliveEntitiesOfType( EntityType type ) const
+{
+	return EntityView( m_entityListsByType, GetEntityTypeMask( type ) );
+}
+
+EntityView Map::GetAliveEntitiesOfFaction( EntityTypeMask typeMask, EntityFaction faction ) const
+{
+	return EntityView( m_entityListsByType, typeMask, faction, false );
+}
+
+EntityView Map::GetAliveEntitiesNotOfFaction( EntityTypeMask typeMask, EntityFaction faction ) const
+{
+	return EntityView( m_entityListsByType, typeMask, faction, true );
+}
+
 bool Map::IsPointInSolid( const Vec2& point ) const
 {
-	int index = GetTileIndexForPosition( point );
-	return TileDefinition::s_definitions[m_tiles[index].m_type].m_isSolid;
+	return m_tiles.IsTileSolid( GetTileCoordsForPosition( point ) );
 }
 
 bool Map::IsPointInTileType( const Vec2& point, TileType type ) const
 {
-	int index = GetTileIndexForPosition( point );
-	if( m_tiles[index].m_type == type )
+	IntVec2 tileCoords = GetTileCoordsForPosition( point );
+	if( m_tiles.IsInBounds( tileCoords ) && m_tiles.GetTileType( tileCoords ) == type )
 		return true;
 	else return false;
 }
 
 bool Map::IsTileSolid( const IntVec2& tileCoords ) const
 {
-	int index = GetTileIndexForTileCoords( tileCoords );
-	TileDefinition& tileDefinition = TileDefinition::s_definitions[m_tiles[index].m_type];
-	return tileDefinition.m_isSolid;
+	//off the map counts as solid
+	return m_tiles.IsTileSolid( tileCoords );
+}
+
+float Map::GetTileClearance( const IntVec2& tileCoords ) const
+{
+	return m_tiles.GetClearance( tileCoords );
+}
+
+bool Map::FindPath( const Vec2& startPos, const Vec2& goalPos, std::vector<Vec2>& out_waypoints ) const
+{
+	return m_pathfinder.FindPath( startPos, goalPos, out_waypoints );
+}
+
+bool Map::CanDiscFitAt( const Vec2& center, float radius ) const
+{
+	//clearance shrinks by at most the distance moved, so the tile center value bounds every point of the tile
+	IntVec2 tileCoords = GetTileCoordsForPosition( center );
+	Vec2 tileCenter( (float)tileCoords.x + .5f, (float)tileCoords.y + .5f );
+	return m_tiles.GetClearance( tileCoords ) - GetDistance2D( center, tileCenter ) >= radius;
+}
+
+TileType Map::GetTileTypeForPosition( const Vec2& position ) const
+{
+	//points off the map take the nearest tile on it
+	IntVec2 tileCoords = GetTileCoordsForPosition( position );
+	tileCoords.x = std::max( 0, std::min( tileCoords.x, m_size.x - 1 ) );
+	tileCoords.y = std::max( 0, std::min( tileCoords.y, m_size.y - 1 ) );
+	return m_tiles.GetTileType( tileCoords );
 }
 
 bool Map::IsTileInEdge( const IntVec2& tileCoords ) const
@@ -245,11 +473,17 @@ RaycastResult Map::Raycast( const Vec2& startPosition, const Vec2& forwardDir, f
 	{
 		Vec2 lastDetectedPos = startPosition + detectedLength*forwardDir;
 		Vec2 thisDetectPos = lastDetectedPos + forwardDir * unitStep;
-		int thisTileIndex = GetTileIndexForPosition( thisDetectPos );
-		TileDefinition& tileDefinition = TileDefinition::s_definitions[m_tiles[thisTileIndex].m_type];
-		if( tileDefinition.m_isSolid )
+		IntVec2 thisTileCoords = GetTileCoordsForPosition( thisDetectPos );
+		//a chunk without solid tiles is crossed in one step, the next sample lands on its far edge
+		if( m_tiles.IsChunkAllWalkable( thisTileCoords ) )
 		{
-			AABB2 thisTileBound = m_tiles[thisTileIndex].GetBounds();
+			detectedLength = std::max( detectedLength + unitStep, GetRayExitDistFromChunk( startPosition, forwardDir, thisTileCoords ) - unitStep );
+			continue;
+		}
+		if( m_tiles.IsTileSolid( thisTileCoords ) )
+		{
+			TileDefinition& tileDefinition = TileDefinition::s_definitions[GetTileTypeForPosition( thisDetectPos )];
+			AABB2 thisTileBound( (float)thisTileCoords.x, (float)thisTileCoords.y, (float)thisTileCoords.x + 1.f, (float)thisTileCoords.y + 1.f );
 			Vec2 pointOnSolid = GetNearestPointOnAABB2D( lastDetectedPos, thisTileBound );
 			result.m_impactDist = (pointOnSolid - startPosition).GetLength();
 			if( result.m_impactDist > maxDist )
@@ -280,101 +514,399 @@ RaycastResult Map::Raycast( const Vec2& startPosition, const Vec2& forwardDir, f
 	return result;
 }
 
-Entity* Map::RaycastForEnemyFaction( EntityFaction faction, const Vec2& startPoint, float maxDist ) const
-{
-	Entity* result = nullptr;
-	//ray cast for player
-	result = RaycastForEnemyType( faction, ENTITY_TYPE_PLAYER, startPoint, maxDist );
-	if( result!=nullptr )		return result;
-	//ray cast for turret
-	result = RaycastForEnemyType( faction, ENTITY_TYPE_NPC_TURRET, startPoint, maxDist );
-	if( result != nullptr )		return result;
-	//ray cast for tank
-	result = RaycastForEnemyType( faction, ENTITY_TYPE_NPC_TANK, startPoint, maxDist );
-	if( result != nullptr )		return result;
-	//ray cast for pickups
-	result = RaycastForEnemyType( faction, ENTITY_TYPE_PICKUP, startPoint, maxDist );
-	if( result != nullptr )		return result;
-	//return false
-	return nullptr;
+bool Map::IsVisibleFrom( const Vec2& observerPos, const Vec2& targetPos, float maxDist ) const
+{
+	Vec2 observerToTarget = targetPos - observerPos;
+	if( observerToTarget.GetLengthSquared() >= maxDist * maxDist )
+		return false;
+	IntVec2 observerCoords = GetTileCoordsForPosition( observerPos );
+	if( m_visibilityField.HasObserverTile( observerCoords ) )
+		return m_visibilityField.IsTileVisibleFrom( observerCoords, GetTileCoordsForPosition( targetPos ) );
+	return HasLineOfSight( observerPos, targetPos, maxDist );
 }
 
-Entity* Map::RaycastForEnemyType( EntityFaction faction, EntityType type, const Vec2& startPoint, float maxDist ) const
+Entity* Map::GetNearestVisibleEnemy( EntityFaction faction, const Vec2& observerPos, float maxDist ) const
 {
-	const EntityList& entityList = m_entityListsByType[type];
-	for( int turID = 0; turID < (int)entityList.size(); turID++ )
+	//units first, pickups only when no unit is in sight
+	EntityTypeMask unitMask = GetEntityTypeMask( ENTITY_TYPE_PLAYER ) | GetEntityTypeMask( ENTITY_TYPE_NPC_TANK ) | GetEntityTypeMask( ENTITY_TYPE_NPC_TURRET );
+	Entity* result = GetNearestVisibleEntity( EntityFilter( unitMask, faction, true ), observerPos, maxDist );
+	if( result != nullptr )
+		return result;
+	return GetNearestVisibleEntity( EntityFilter( GetEntityTypeMask( ENTITY_TYPE_PICKUP ), faction, true ), observerPos, maxDist );
+}
+
+Entity* Map::GetNearestVisibleEntity( const EntityFilter& filter, const Vec2& observerPos, float maxDist ) const
+{
+	//candidates come sorted nearest first, so the first visible one wins and farther ones are never ray tested
+	thread_local EntityList candidates;
+	GetNearestEntities( observerPos, m_entityGrid.GetNumEntities(), maxDist, filter, candidates );
+	for( Entity* entity : candidates )
 	{
-		Entity* result = RaycastForEnemyEntity( faction, entityList[turID], startPoint, maxDist );
-		if( result!=nullptr )		return result;
+		if( IsVisibleFrom( observerPos, entity->m_position, maxDist ) )
+			return entity;
 	}
 	return nullptr;
 }
 
-Entity* Map::RaycastForEnemyEntity( EntityFaction faction, Entity* enemy, const Vec2& startpoint, float maxDist ) const
+void Map::GetEntitiesInDisc( const Vec2& center, float radius, const EntityFilter& filter, EntityList& out_entities ) const
 {
-	RaycastResult result;
-	if( enemy == nullptr || !enemy->IsAlive()||enemy->m_faction == faction )
+	//every entity whose physics disc overlaps the query disc
+	out_entities.clear();
+	AABB2 bounds( center - Vec2( radius, radius ), center + Vec2( radius, radius ) );
+	m_entityGrid.VisitCandidates( bounds, SPATIAL_GRID_QUERY_MARGIN, [&]( Entity* entity )
 	{
-		result.m_impacted = false;
-		result.m_impactDist = maxDist;
-		return nullptr;
+		if( filter.IsMatching( entity ) && DoDiscsOverlap2D( center, radius, entity->m_position, entity->m_physicsRadius ) )
+			out_entities.push_back( entity );
+	} );
+}
+
+void Map::GetEntitiesInAABB2( const AABB2& bounds, const EntityFilter& filter, EntityList& out_entities ) const
+{
+	//every entity whose physics disc overlaps the box
+	out_entities.clear();
+	m_entityGrid.VisitCandidates( bounds, SPATIAL_GRID_QUERY_MARGIN, [&]( Entity* entity )
+	{
+		if( !filter.IsMatching( entity ) )
+			return;
+		Vec2 nearestPoint = GetNearestPointOnAABB2D( entity->m_position, bounds );
+		if( GetDistanceSquared2D( nearestPoint, entity->m_position ) < entity->m_physicsRadius * entity->m_physicsRadius )
+			out_entities.push_back( entity );
+	} );
+}
+
+Entity* Map::RaycastEntities( const Vec2& startPosition, const Vec2& forwardDir, float maxDist, const EntityFilter& filter, float* out_impactDist ) const
+{
+	float impactDist = maxDist;
+	Entity* impactEntity = CastDiscAgainstEntities( startPosition, forwardDir, maxDist, 0.f, filter, impactDist );
+	if( out_impactDist != nullptr )
+		*out_impactDist = impactDist;
+	return impactEntity;
+}
+
+Entity* Map::SweepDiscAgainstEntities( const Vec2& startPosition, float radius, const Vec2& displacement, const EntityFilter& filter, float& out_impactFraction ) const
+{
+	//a disc against discs is a ray against discs grown by its radius
+	float length = displacement.GetLength();
+	Vec2 forwardDir = length > 0.f ? displacement / length : Vec2( 0.f, 0.f );
+	float impactDist = length;
+	Entity* impactEntity = CastDiscAgainstEntities( startPosition, forwardDir, length, radius, filter, impactDist );
+	out_impactFraction = length > 0.f ? impactDist / length : 0.f;
+	return impactEntity;
+}
+
+bool Map::SweepDiscAgainstTiles( const Vec2& startPosition, float radius, const Vec2& displacement, float& out_impactFraction ) const
+{
+	//walks the tiles under the center line once, the cost grows with tiles crossed and never with substeps
+	//the center can only touch a solid tile while it is in one of that tile's neighbors, radius is below one tile like in ResolveEntityTileCollision
+	IntVec2 coords = GetTileCoordsForPosition( startPosition );
+	IntVec2 endCoords = GetTileCoordsForPosition( startPosition + displacement );
+	int stepX = displacement.x > 0.f ? 1 : (displacement.x < 0.f ? -1 : 0);
+	int stepY = displacement.y > 0.f ? 1 : (displacement.y < 0.f ? -1 : 0);
+	float nextFractionX = 2.f;
+	float nextFractionY = 2.f;
+	if( stepX != 0 )
+		nextFractionX = ((float)(stepX > 0 ? coords.x + 1 : coords.x) - startPosition.x) / displacement.x;
+	if( stepY != 0 )
+		nextFractionY = ((float)(stepY > 0 ? coords.y + 1 : coords.y) - startPosition.y) / displacement.y;
+	float fractionPerTileX = stepX != 0 ? fabsf( 1.f / displacement.x ) : 2.f;
+	float fractionPerTileY = stepY != 0 ? fabsf( 1.f / displacement.y ) : 2.f;
+
+	bool hasImpacted = false;
+	float impactFraction = 1.f;
+	int numSteps = abs( endCoords.x - coords.x ) + abs( endCoords.y - coords.y );
+	for( int stepID = 0; stepID <= numSteps; stepID++ )
+	{
+		for( int offsetY = -1; offsetY <= 1; offsetY++ )
+		{
+			for( int offsetX = -1; offsetX <= 1; offsetX++ )
+			{
+				IntVec2 tileCoords = coords + IntVec2( offsetX, offsetY );
+				bool isOutside = tileCoords.x < 0 || tileCoords.y < 0 || tileCoords.x >= m_size.x || tileCoords.y >= m_size.y;
+				if( !isOutside && !IsTileSolid( tileCoords ) )
+					continue;
+				float tileFraction = 1.f;
+				if( GetSweptDiscEntryIntoTile( startPosition, radius, displacement, tileCoords, tileFraction ) && tileFraction <= impactFraction )
+				{
+					hasImpacted = true;
+					impactFraction = tileFraction;
+				}
+			}
+		}
+		//every later tile is entered after the impact, nothing there can come first
+		float nextFraction = std::min( nextFractionX, nextFractionY );
+		if( hasImpacted && nextFraction >= impactFraction )
+			break;
+		if( nextFractionX < nextFractionY )
+		{
+			coords.x += stepX;
+			nextFractionX += fractionPerTileX;
+		}
+		else
+		{
+			coords.y += stepY;
+			nextFractionY += fractionPerTileY;
+		}
+	}
+	out_impactFraction = impactFraction;
+	return hasImpacted;
+}
+
+bool Map::GetSweptDiscEntryIntoTile( const Vec2& startPosition, float radius, const Vec2& displacement, const IntVec2& tileCoords, float& out_fraction ) const
+{
+	//the tile grown by the radius is a rounded box: two grown boxes and a disc on every corner
+	float minX = (float)tileCoords.x;
+	float minY = (float)tileCoords.y;
+	float maxX = minX + 1.f;
+	float maxY = minY + 1.f;
+	bool hasEntered = false;
+	float entryFraction = 1.f;
+	float shapeFraction = 1.f;
+	if( GetSegmentEntryIntoAABB2( startPosition, displacement, AABB2( minX - radius, minY, maxX + radius, maxY ), shapeFraction ) && shapeFraction <= entryFraction )
+	{
+		hasEntered = true;
+		entryFraction = shapeFraction;
 	}
-	Vec2 thisToEnemy = enemy->m_position - startpoint;
-	result = Raycast( startpoint, thisToEnemy.GetNormalized(), maxDist );
-	if( thisToEnemy.GetLength() < result.m_impactDist )
+	if( GetSegmentEntryIntoAABB2( startPosition, displacement, AABB2( minX, minY - radius, maxX, maxY + radius ), shapeFraction ) && shapeFraction <= entryFraction )
 	{
-		return enemy;
+		hasEntered = true;
+		entryFraction = shapeFraction;
 	}
-	else return nullptr;
+	Vec2 corners[4] = { Vec2( minX, minY ), Vec2( maxX, minY ), Vec2( maxX, maxY ), Vec2( minX, maxY ) };
+	for( int cornerID = 0; cornerID < 4; cornerID++ )
+	{
+		if( GetSegmentEntryIntoDisc( startPosition, displacement, corners[cornerID], radius, shapeFraction ) && shapeFraction <= entryFraction )
+		{
+			hasEntered = true;
+			entryFraction = shapeFraction;
+		}
+	}
+	out_fraction = entryFraction;
+	return hasEntered;
+}
+
+Entity* Map::CastDiscAgainstEntities( const Vec2& startPosition, const Vec2& forwardDir, float maxDist, float castRadius, const EntityFilter& filter, float& out_impactDist ) const
+{
+	//first physics disc along the ray, forwardDir is normalized, a start inside a disc hits it at distance 0
+	Vec2 endPosition = startPosition + forwardDir * maxDist;
+	AABB2 bounds( Vec2( fminf( startPosition.x, endPosition.x ), fminf( startPosition.y, endPosition.y ) ),
+		Vec2( fmaxf( startPosition.x, endPosition.x ), fmaxf( startPosition.y, endPosition.y ) ) );
+	Entity* nearestEntity = nullptr;
+	float nearestDist = maxDist;
+	m_entityGrid.VisitCandidates( bounds, SPATIAL_GRID_QUERY_MARGIN + castRadius, [&]( Entity* entity )
+	{
+		if( !filter.IsMatching( entity ) )
+			return;
+		Vec2 startToCenter = entity->m_position - startPosition;
+		float radius = entity->m_physicsRadius + castRadius;
+		float radiusSquared = radius * radius;
+		float alongDist = DotProduct2D( startToCenter, forwardDir );
+		float sideDistSquared = startToCenter.GetLengthSquared() - alongDist * alongDist;
+		if( sideDistSquared >= radiusSquared )
+			return;
+		float impactDist = alongDist - sqrtf( radiusSquared - sideDistSquared );
+		if( impactDist < 0.f )
+		{
+			if( startToCenter.GetLengthSquared() >= radiusSquared )
+				return;//disc is behind the start
+			impactDist = 0.f;
+		}
+		if( impactDist < nearestDist )
+		{
+			nearestEntity = entity;
+			nearestDist = impactDist;
+		}
+	} );
+	out_impactDist = nearestDist;
+	return nearestEntity;
+}
+
+void Map::GetNearestEntities( const Vec2& position, int maxCount, float maxDist, const EntityFilter& filter, EntityList& out_entities ) const
+{
+	out_entities.clear();
+	if( maxCount <= 0 )
+		return;
+
+	float maxDistSquared = maxDist * maxDist;
+	AABB2 bounds( position - Vec2( maxDist, maxDist ), position + Vec2( maxDist, maxDist ) );
+	m_entityGrid.VisitCandidates( bounds, SPATIAL_GRID_QUERY_MARGIN, [&]( Entity* entity )
+	{
+		if( filter.IsMatching( entity ) && GetDistanceSquared2D( entity->m_position, position ) < maxDistSquared )
+			out_entities.push_back( entity );
+	} );
+
+	auto isNearer = [&position]( const Entity* entityA, const Entity* entityB )
+	{
+		return GetDistanceSquared2D( entityA->m_position, position ) < GetDistanceSquared2D( entityB->m_position, position );
+	};
+	if( (int)out_entities.size() > maxCount )
+	{
+		std::partial_sort( out_entities.begin(), out_entities.begin() + maxCount, out_entities.end(), isNearer );
+		out_entities.resize( maxCount );
+	}
+	else std::sort( out_entities.begin(), out_entities.end(), isNearer );
 }
 
 bool Map::HasLineOfSight( const Vec2& startPoint, const Vec2& endPoint, float maxDist ) const
 {
 	Vec2 forward = endPoint - startPoint;
-	RaycastResult raycastResult = Raycast( startPoint, forward.GetNormalized(), maxDist );
-	if( forward.GetLength()<raycastResult.m_impactDist )
+	if( forward.GetLengthSquared() >= maxDist * maxDist )
+		return false;
+	if( m_lineOfSightCache.IsAlwaysVisible( GetTileCoordsForPosition( startPoint ), GetTileCoordsForPosition( endPoint ) ) )
 		return true;
-	else return false;
+	return IsSegmentClearOfSolid( startPoint, endPoint );
+}
+
+bool Map::IsSegmentClearOfSolid( const Vec2& startPoint, const Vec2& endPoint ) const
+{
+	//walk every tile the segment passes through, in order
+	IntVec2 tileCoords = GetTileCoordsForPosition( startPoint );
+	IntVec2 endCoords = GetTileCoordsForPosition( endPoint );
+	Vec2 forward = endPoint - startPoint;
+	int stepX = forward.x > 0.f ? 1 : -1;
+	int stepY = forward.y > 0.f ? 1 : -1;
+	float tDeltaX = forward.x != 0.f ? fabsf( 1.f / forward.x ) : 0.f;
+	float tDeltaY = forward.y != 0.f ? fabsf( 1.f / forward.y ) : 0.f;
+	float tMaxX = 2.f;
+	float tMaxY = 2.f;
+	if( forward.x != 0.f )
+	{
+		float nextBoundaryX = stepX > 0 ? (float)(tileCoords.x + 1) : (float)tileCoords.x;
+		tMaxX = (nextBoundaryX - startPoint.x) / forward.x;
+	}
+	if( forward.y != 0.f )
+	{
+		float nextBoundaryY = stepY > 0 ? (float)(tileCoords.y + 1) : (float)tileCoords.y;
+		tMaxY = (nextBoundaryY - startPoint.y) / forward.y;
+	}
+
+	while( true )
+	{
+		if( IsTileSolid( tileCoords ) )
+			return false;
+		if( tileCoords == endCoords || (tMaxX > 1.f && tMaxY > 1.f) )
+			return true;
+		if( tMaxX < tMaxY )
+		{
+			tileCoords.x += stepX;
+			tMaxX += tDeltaX;
+		}
+		else
+		{
+			tileCoords.y += stepY;
+			tMaxY += tDeltaY;
+		}
+	}
+}
+
+void Map::SetTileType( const IntVec2& tileCoords, TileType type )
+{
+	//the storage keeps chunk flags and solid neighbor masks current
+	TileType oldType = m_tiles.GetTileType( tileCoords );
+	m_tiles.SetTileType( tileCoords, type );
+	if( TileDefinition::s_definitions[oldType].m_isEnemySpawnable != TileDefinition::s_definitions[type].m_isEnemySpawnable )
+		m_isEnemySpawnTableDirty = true;
+	m_lineOfSightCache.InvalidateRegion( tileCoords );
+	m_pathfinder.InvalidateRegion( tileCoords );
+	m_visibilityField.InvalidateRegion( tileCoords );
+	m_areRenderTileTypesDirty = true;
+}
+
+void Map::LoadOrGenerateMap( const MapGenerationParams& params )
+{
+	//the cache file is named by the parameter hash, the hash in its header guards against stale or colliding files
+	uint64_t paramsHash = params.GetHash();
+	std::string cacheFilePath = params.GetCacheFilePath();
+	if( LoadMapFile( cacheFilePath ) && m_mapFile.GetHeader().m_generationHash == paramsHash && m_size == params.m_size )
+		return;
+
+	GenerateMap( params );
+	std::error_code directoryError;
+	std::filesystem::create_directories( MAP_CACHE_DIRECTORY, directoryError );
+	if( !MapFile::Write( cacheFilePath, m_tiles, paramsHash ) )
+		DebuggerPrintf( "Could not write map cache file %s\n", cacheFilePath.c_str() );
 }
 
-void Map::GenerateMap( TileType defaultTile, TileType edgeTile, TileType startTile, TileType endTile, std::vector<WormDefinition>& wormDefs )
+void Map::GenerateMap( const MapGenerationParams& params )
 {
-	InitTiles( defaultTile, edgeTile, startTile, endTile, wormDefs );
+	//the tiles only depend on params, retries continue the same random sequence
+	DeterministicRNG rng( params.GetHash() );
+	m_size = params.m_size;
+	m_entityGrid.Startup( m_size, SPATIAL_GRID_CELL_SIZE );
+	InitTiles( params, rng );
 	while( !IsMapWalkable() )
 	{
-		InitTiles( defaultTile, edgeTile, startTile, endTile, wormDefs );
+		InitTiles( params, rng );
 	}
+	//the walkability check only reads solidity, so clearances are built once for the tiles that are kept
+	m_tiles.RebuildClearances();
+	//every chunk is owned now, a file loaded before is no longer read
+	m_mapFile.Close();
+	StartupTileCaches();
 }
 
-void Map::InitTiles( TileType defaultTile, TileType edgeTile, TileType startTile, TileType endTile, std::vector<WormDefinition>& wormDefs )
+bool Map::LoadMapFile( const std::string& filePath )
 {
-	//init all to default
-	int totalSize = m_size.x * m_size.y;
-	for( int tileID = 0; tileID < totalSize; tileID++ )
+	//the old tiles may point into the file that is about to be replaced
+	m_tiles.Clear();
+	if( !m_mapFile.Open( filePath ) )
+		return false;
+	m_size = m_mapFile.GetDimensions();
+	m_tiles.StartupFromFile( m_mapFile );
+	m_entityGrid.Startup( m_size, SPATIAL_GRID_CELL_SIZE );
+	StartupTileCaches();
+	return true;
+}
+
+bool Map::SaveMapFile( const std::string& filePath ) const
+{
+	return MapFile::Write( filePath, m_tiles );
+}
+
+void Map::StartupTileCaches()
+{
+	//visibility, line of sight and influence keep per chunk state, chunks are only built where something looks or stands
+	m_visibilityField.Startup( this, m_size, VISIBILITY_FIELD_RADIUS );
+	if( LINE_OF_SIGHT_CACHE_ENABLED )
+		m_lineOfSightCache.Startup( this, m_size, LINE_OF_SIGHT_CACHE_RADIUS );
+	else m_lineOfSightCache.Shutdown();
+	m_influenceMap.Startup( m_size, INFLUENCE_MAP_RADIUS );
+	//a generated map builds the cluster graph up front, a loaded one fills it over the first ticks so loading never scans its tiles
+	//maps past the limit leave NPCs to steer straight
+	if( m_tiles.GetNumTiles() <= PATHFINDING_MAX_TILES )
+		m_pathfinder.Startup( this, m_size, !m_mapFile.IsOpen() );
+	else m_pathfinder.Shutdown();
+	//entities already on the map are stamped again on the next update
+	for( Entity* entity : GetAliveEntities( ENTITY_TYPE_MASK_ALL ) )
 	{
-		IntVec2 tileCoords = GetTileCoordsForTileIndex( tileID );
-		Tile newTile( tileCoords.x, tileCoords.y );
-		newTile.m_type = defaultTile;
-		m_tiles.push_back( newTile );
+		entity->m_hasInfluenceStamp = false;
 	}
+	//a loaded map brings its spawn table, a generated one collects it now that the tiles are final
+	if( m_mapFile.IsOpen() )
+		m_enemySpawnTable.SetFromMapFile( m_mapFile.GetSpawnTable( MAP_SPAWN_TABLE_ENEMY ), m_mapFile.GetSpawnTableSize( MAP_SPAWN_TABLE_ENEMY ), m_tiles.GetNumTiles() );
+	else m_enemySpawnTable.BuildForEnemies( m_tiles );
+	m_isEnemySpawnTableDirty = false;
+	m_areRenderTileTypesDirty = true;
+}
+
+void Map::InitTiles( const MapGenerationParams& params, DeterministicRNG& rng )
+{
+	//init all to default
+	m_tiles.Startup( m_size, params.m_defaultTile );
 	//set outer frame to stone
 	for( int tileXPos = 0; tileXPos < m_size.x; tileXPos++ )
 	{
-		m_tiles[tileXPos].m_type = edgeTile;
-		int lastLinePos = GetTileIndexForTileCoords( IntVec2( tileXPos, m_size.y - 1 ) );
-		m_tiles[lastLinePos].m_type = edgeTile;
+		m_tiles.SetTileType( IntVec2( tileXPos, 0 ), params.m_edgeTile );
+		m_tiles.SetTileType( IntVec2( tileXPos, m_size.y - 1 ), params.m_edgeTile );
 	}
 	for( int tileYPos = 0; tileYPos < m_size.y; tileYPos++ )
 	{
-		int startPos = GetTileIndexForTileCoords( IntVec2( 0, tileYPos ) );
-		m_tiles[startPos].m_type = edgeTile;
-		int endPos = GetTileIndexForTileCoords( IntVec2( m_size.x - 1, tileYPos ) );
-		m_tiles[endPos].m_type = edgeTile;
+		m_tiles.SetTileType( IntVec2( 0, tileYPos ), params.m_edgeTile );
+		m_tiles.SetTileType( IntVec2( m_size.x - 1, tileYPos ), params.m_edgeTile );
 	}
 	//set worm tiles in map
-	for( int wormDefID = 0; wormDefID < (int)wormDefs.size(); wormDefID++ )
+	for( int wormDefID = 0; wormDefID < (int)params.m_wormDefs.size(); wormDefID++ )
 	{
-		InitWormsForDefinition( wormDefs[wormDefID] );
+		InitWormsForDefinition( params.m_wormDefs[wormDefID], rng );
 	}
 	//set birth and end point to grass
 	//Remember to leave the outer frame
@@ -383,47 +915,48 @@ void Map::InitTiles( TileType defaultTile, TileType edgeTile, TileType startTile
 	{
 		for( int yID = 1; yID < vacantSize; yID++ )
 		{
-			int birthPlaceID = GetTileIndexForTileCoords( IntVec2( xID, yID ) );
-			int endPlaceID = totalSize - 1 - birthPlaceID;
+			//the exit area mirrors the start area through the map center
+			IntVec2 birthPlaceCoords( xID, yID );
+			IntVec2 endPlaceCoords( m_size.x - 1 - xID, m_size.y - 1 - yID );
 			if( (xID == 4 && (yID > 1 && yID < 5)) || (yID == 4 && (xID > 1 && xID < 5)) )
 			{
-				m_tiles[birthPlaceID].m_type = edgeTile;
-				m_tiles[endPlaceID].m_type = edgeTile;
+				m_tiles.SetTileType( birthPlaceCoords, params.m_edgeTile );
+				m_tiles.SetTileType( endPlaceCoords, params.m_edgeTile );
 			}
 			else
 			{
-				m_tiles[birthPlaceID].m_type = startTile;
-				m_tiles[endPlaceID].m_type = endTile;
+				m_tiles.SetTileType( birthPlaceCoords, params.m_startTile );
+				m_tiles.SetTileType( endPlaceCoords, params.m_endTile );
 			}
 		}
 	}
 }
 
-void Map::InitWormsForDefinition( WormDefinition wormDef )
+void Map::InitWormsForDefinition( const WormDefinition& wormDef, DeterministicRNG& rng )
 {
 	for( int wormID = 0; wormID < wormDef.numWorms; wormID++ )
 	{
 		//choose random start location
-		int xStart = g_theGame->m_RNG->RollRandomIntInRange( 1, m_size.x - 2 );
-		int yStart = g_theGame->m_RNG->RollRandomIntInRange( 1, m_size.y - 2 );
+		int xStart = rng.RollRandomIntInRange( 1, m_size.x - 2 );
+		int yStart = rng.RollRandomIntInRange( 1, m_size.y - 2 );
 		IntVec2 currentTilePos( xStart, yStart );
 		for( int lengthID = 0; lengthID < wormDef.wormLength; lengthID++ )
 		{
-			m_tiles[GetTileIndexForTileCoords( currentTilePos )].m_type = wormDef.wormTile;
-			IntVec2 newTilePos = GetRandomAdjacentTileCoords( currentTilePos );
+			m_tiles.SetTileType( currentTilePos, wormDef.wormTile );
+			IntVec2 newTilePos = GetRandomAdjacentTileCoords( currentTilePos, rng );
 			while(lengthID<wormDef.wormLength && IsTileInEdge(newTilePos) )
 			{
 				lengthID++;
-				newTilePos = GetRandomAdjacentTileCoords( currentTilePos );
+				newTilePos = GetRandomAdjacentTileCoords( currentTilePos, rng );
 			}
 			currentTilePos = newTilePos;
 		}
 	}
 }
 
-IntVec2 Map::GetRandomAdjacentTileCoords( const IntVec2& tileCoords )
+IntVec2 Map::GetRandomAdjacentTileCoords( const IntVec2& tileCoords, DeterministicRNG& rng ) const
 {
-	float factor = g_theGame->m_RNG->RollRandomFloatZeroToOneInclusive();
+	float factor = rng.RollRandomFloatZeroToOneInclusive();
 	if( factor < .25f )//left
 		return IntVec2( tileCoords.x - 1, tileCoords.y );
 	else if( factor < .5f )//up
@@ -437,14 +970,13 @@ IntVec2 Map::GetRandomAdjacentTileCoords( const IntVec2& tileCoords )
 bool Map::IsMapWalkable()
 {
 	//flood-fill to walk the map
-	int mapSize = m_size.x * m_size.y;
-	bool* isReachable = new bool[mapSize];
-	bool* isProcessed = new bool[mapSize];
+	int64_t mapSize = m_tiles.GetNumTiles();
+	std::vector<bool> isReachable( (size_t)mapSize, false );
+	std::vector<bool> isProcessed( (size_t)mapSize, false );
 	//init solid tile to not reachable and is processed
-	for( int tileIndex = 0; tileIndex < mapSize; tileIndex++ )
+	for( int64_t tileIndex = 0; tileIndex < mapSize; tileIndex++ )
 	{
-		isReachable[tileIndex] = false;
-		if( TileDefinition::s_definitions[m_tiles[tileIndex].m_type].m_isSolid )
+		if( m_tiles.IsTileSolid( GetTileCoordsForTileIndex( tileIndex ) ) )
 		{
 			isProcessed[tileIndex] = true;
 		}
@@ -453,19 +985,19 @@ bool Map::IsMapWalkable()
 	//init start point reachable 
 	isReachable[m_size.x + 1] = true;
 	//do flood fill until no new state can be updated
-	int adjacent[4] = { -1,1,m_size.x,-m_size.x };
+	int64_t adjacent[4] = { -1,1,m_size.x,-m_size.x };
 	bool updated = false;
 	do
 	{
 		updated = false;
-		for( int tileID = m_size.x + 1; tileID < mapSize - m_size.x - 1; tileID++ )
+		for( int64_t tileID = m_size.x + 1; tileID < mapSize - m_size.x - 1; tileID++ )
 		{
 			if( !isProcessed[tileID] && isReachable[tileID] )
 			{
 				updated = true;
 				for( int adjID = 0; adjID < 4; adjID++ )
 				{
-					int adjacentTileID = tileID + adjacent[adjID];
+					int64_t adjacentTileID = tileID + adjacent[adjID];
 					if( !isProcessed[adjacentTileID] ) 
 						isReachable[adjacentTileID] = true;
 				}
@@ -476,26 +1008,25 @@ bool Map::IsMapWalkable()
 	//detect if reachable to exit
 	if( !isReachable[mapSize - m_size.x - 2] )//exit not reachable
 	{
-		m_tiles.clear();
 		return false;
 	}
 	//exit reachable, then fill out not reachable area.
 	do
 	{
 		updated = false;
-		for( int tileID = m_size.x + 1; tileID < mapSize - m_size.x - 1; tileID++ )
+		for( int64_t tileID = m_size.x + 1; tileID < mapSize - m_size.x - 1; tileID++ )
 		{
 			if( !isProcessed[tileID] )
 			{
 				for( int adjID = 0; adjID < 4; adjID++ )
 				{
-					int adjacentTileID = tileID + adjacent[adjID];
+					int64_t adjacentTileID = tileID + adjacent[adjID];
 					if( isProcessed[adjacentTileID] )
 					{
 						updated = true;
 						isProcessed[tileID] = true;
 						isReachable[tileID] = isReachable[adjacentTileID];
-						m_tiles[tileID].m_type = m_tiles[adjacentTileID].m_type;
+						m_tiles.SetTileType( GetTileCoordsForTileIndex( tileID ), m_tiles.GetTileType( GetTileCoordsForTileIndex( adjacentTileID ) ) );
 						break;
 					}
 				}
@@ -505,22 +1036,80 @@ bool Map::IsMapWalkable()
 	return true;
 }
 
-Vec2 Map::GetEnemySpawnPoint() const
+Vec2 Map::GetEnemySpawnPoint()
 {
-	Vec2 spawnPos;
-	spawnPos.x = g_theGame->m_RNG->RollRandomFloatInRange( 0.f, (float)m_size.x );
-	spawnPos.y = g_theGame->m_RNG->RollRandomFloatInRange( 0.f, (float)m_size.y );
-	while( !TileDefinition::s_definitions[m_tiles[GetTileIndexForPosition( spawnPos )].m_type].m_isEnemySpawnable )
+	if( m_isEnemySpawnTableDirty )
 	{
-		spawnPos.x = g_theGame->m_RNG->RollRandomFloatInRange( 0.f, (float)m_size.x );
-		spawnPos.y = g_theGame->m_RNG->RollRandomFloatInRange( 0.f, (float)m_size.y );
+		m_enemySpawnTable.BuildForEnemies( m_tiles );
+		m_isEnemySpawnTableDirty = false;
 	}
-	return spawnPos;
+	int64_t numSpawnTiles = m_enemySpawnTable.GetNumTiles();
+	if( numSpawnTiles == 0 )
+		ERROR_AND_DIE( Stringf( "Map %d x %d has no tile enemies can spawn on", m_size.x, m_size.y ) );
+
+	//a random table entry, then a random point in that tile, uniform over the spawnable area
+	for( int attemptID = 0; attemptID < SPAWN_POINT_MAX_ATTEMPTS; attemptID++ )
+	{
+		int64_t tileIndex = m_enemySpawnTable.GetTileIndex( RollRandomSpawnTableEntry( numSpawnTiles ) );
+		if( tileIndex < 0 )
+			return GetEnemySpawnPointFromRebuiltTable();
+		IntVec2 tileCoords = GetTileCoordsForTileIndex( tileIndex );
+		Vec2 spawnPos( (float)tileCoords.x + g_theGame->m_RNG->RollRandomFloatZeroToOneInclusive(), (float)tileCoords.y + g_theGame->m_RNG->RollRandomFloatZeroToOneInclusive() );
+		if( !IsInSpawnExclusionZone( spawnPos ) )
+			return spawnPos;
+	}
+	//exclusion zones cover most of the table, take the first tile center outside them after a random entry
+	int64_t firstEntry = RollRandomSpawnTableEntry( numSpawnTiles );
+	for( int64_t entryOffset = 0; entryOffset < numSpawnTiles; entryOffset++ )
+	{
+		int64_t tileIndex = m_enemySpawnTable.GetTileIndex( (firstEntry + entryOffset) % numSpawnTiles );
+		if( tileIndex < 0 )
+			return GetEnemySpawnPointFromRebuiltTable();
+		IntVec2 tileCoords = GetTileCoordsForTileIndex( tileIndex );
+		Vec2 tileCenter( (float)tileCoords.x + .5f, (float)tileCoords.y + .5f );
+		if( !IsInSpawnExclusionZone( tileCenter ) )
+			return tileCenter;
+	}
+	ERROR_AND_DIE( "Every tile enemies can spawn on is inside a spawn exclusion zone" );
+}
+
+Vec2 Map::GetEnemySpawnPointFromRebuiltTable()
+{
+	//the loaded table has an entry outside the map, the tiles give a table that has none
+	DebuggerPrintf( "Map file spawn table has a tile outside the %d x %d map, rebuilt from the tiles\n", m_size.x, m_size.y );
+	m_enemySpawnTable.BuildForEnemies( m_tiles );
+	m_isEnemySpawnTableDirty = false;
+	return GetEnemySpawnPoint();
+}
+
+bool Map::IsInSpawnExclusionZone( const Vec2& position ) const
+{
+	for( const SpawnExclusionZone& zone : m_spawnExclusionZones )
+	{
+		if( GetDistanceSquared2D( position, zone.m_center ) < zone.m_radius * zone.m_radius )
+			return true;
+	}
+	return false;
+}
+
+int64_t Map::RollRandomSpawnTableEntry( int64_t numEntries ) const
+{
+	if( numEntries <= 0x7FFFFFFF )
+		return (int64_t)g_theGame->m_RNG->RollRandomIntLessThan( (int)numEntries );
+	//tables of huge maps outgrow one int roll, two 31 bit rolls cover them with a negligible modulo bias
+	int64_t highBits = (int64_t)g_theGame->m_RNG->RollRandomIntLessThan( 0x7FFFFFFF );
+	int64_t lowBits = (int64_t)g_theGame->m_RNG->RollRandomIntLessThan( 0x7FFFFFFF );
+	return ((highBits << 31) | lowBits) % numEntries;
+}
+
+void Map::AddSpawnExclusionZone( const SpawnExclusionZone& zone )
+{
+	m_spawnExclusionZones.push_back( zone );
 }
 
 float Map::GetTileSpeedFactorForPoint( const Vec2& point ) const
 {
-	TileType tileType = m_tiles[GetTileIndexForPosition( point )].m_type;
+	TileType tileType = GetTileTypeForPosition( point );
 	return TileDefinition::s_definitions[tileType].m_speedFactor;
 }
 
@@ -547,17 +1136,11 @@ bool Map::IsLevelCompleted() const
 
 bool Map::IsEnemyFactionExist(EntityFaction faction) const
 {
-	for( int typeID = 0; typeID < (int)ENTITY_TYPE_BOULDER; typeID++ )
+	EntityTypeMask unitMask = GetEntityTypeMask( ENTITY_TYPE_PLAYER ) | GetEntityTypeMask( ENTITY_TYPE_NPC_TANK ) | GetEntityTypeMask( ENTITY_TYPE_NPC_TURRET );
+	for( int factionID = 0; factionID < (int)NUM_FACTIONS; factionID++ )
 	{
-		const EntityList& entityList = m_entityListsByType[typeID];
-		for( int eID = 0; eID < (int)entityList.size(); eID++ )
-		{
-			const Entity* entity = entityList[eID];
-			if(entity==nullptr||!entity->IsAlive() )
-				continue;
-			if( entity->m_faction != faction )
-				return false;
-		}
+		if( factionID != (int)faction && GetAliveCountForFaction( unitMask, (EntityFaction)factionID ) > 0 )
+			return false;
 	}
 	return true;
 }
@@ -565,42 +1148,134 @@ bool Map::IsEnemyFactionExist(EntityFaction faction) const
 void Map::Update( float deltaSeconds )
 {
 	CleanDeadTrashEntities();
+	RebuildEntityGrid();
+#if defined(_DEBUG)
+	ValidateAliveCounts();
+#endif
 	if( IsLevelCompleted() )
 	{
 		m_world->LoadNextLevel();
 		return;
 	}
+	m_lineOfSightCache.RebuildDirtyTiles( LINE_OF_SIGHT_REBUILDS_PER_TICK );
+	m_pathfinder.RebuildDirtyClusters( m_pathfinder.IsFilling() ? PATH_CLUSTER_FILL_REBUILDS_PER_TICK : PATH_CLUSTER_REBUILDS_PER_TICK );
+	UpdateInfluenceMap();
+	UpdatePerception();
+	m_aiScheduler.Update( this, deltaSeconds );
 	UpdateEntities( deltaSeconds );	
-	DetectCollisionForBombs();
-	DetectCollisionForPickups();
+	RebuildEntityGrid();
 	DetectCollisionForEntities();
 	DetectCollisionForTilesAndEntities();
 	
 }
 
+void Map::UpdatePerception()
+{
+	//one field of view per occupied tile, shared by everything of every faction standing on it
+	m_visibilityField.BeginUpdate();
+	EntityTypeMask observerMask = GetEntityTypeMask( ENTITY_TYPE_PLAYER ) | GetEntityTypeMask( ENTITY_TYPE_NPC_TANK ) | GetEntityTypeMask( ENTITY_TYPE_NPC_TURRET );
+	for( const Entity* observer : GetAliveEntities( observerMask ) )
+	{
+		m_visibilityField.AddObserver( GetTileCoordsForPosition( observer->m_position ), observer->m_faction );
+	}
+	m_visibilityField.EndUpdate();
+}
+
+void Map::UpdateInfluenceMap()
+{
+	if( !m_influenceMap.IsBuilt() )
+		return;
+	//only sources that changed tile or faction since their last stamp touch the layers, dead ones were taken out as they died
+	for( Entity* entity : GetAliveEntities( ENTITY_TYPE_MASK_ALL ) )
+	{
+		if( !InfluenceMap::IsSourceType( entity->m_type ) )
+			continue;
+		IntVec2 tileCoords = GetTileCoordsForPosition( entity->m_position );
+		if( entity->m_hasInfluenceStamp && entity->m_influenceTileCoords == tileCoords && entity->m_influenceFaction == entity->m_faction )
+			continue;
+		RemoveInfluenceStamp( entity );
+		if( !m_influenceMap.IsInBounds( tileCoords ) )
+			continue;
+		m_influenceMap.AddSource( tileCoords, entity->m_type, entity->m_faction );
+		entity->m_hasInfluenceStamp = true;
+		entity->m_influenceTileCoords = tileCoords;
+		entity->m_influenceFaction = entity->m_faction;
+	}
+}
+
+void Map::RemoveInfluenceStamp( Entity* entity )
+{
+	if( !entity->m_hasInfluenceStamp )
+		return;
+	m_influenceMap.RemoveSource( entity->m_influenceTileCoords, entity->m_type, entity->m_influenceFaction );
+	entity->m_hasInfluenceStamp = false;
+}
+
 void Map::UpdateEntities( float deltaSeconds )
 {
-	for( int entityTypeID = 0; entityTypeID < (int)NUM_ENTITY_TYPES; entityTypeID++ )
+	//steering first, so crowd avoidance sees where every avoiding entity wants to go before anything moves
+	for( Entity* entity : GetAliveEntities( ENTITY_TYPE_MASK_ALL ) )
 	{
-		EntityList& entityList = m_entityListsByType[entityTypeID];
-		for( int entityID = 0; entityID < (int)entityList.size(); entityID++ )
+		entity->UpdateSteering( GetEntityDeltaSeconds( entity, deltaSeconds ) );
+	}
+	UpdateCrowdAvoidance( deltaSeconds );
+	for( Entity* entity : GetAliveEntities( ENTITY_TYPE_MASK_ALL ) )
+	{
+		entity->Update( GetEntityDeltaSeconds( entity, deltaSeconds ) );
+	}
+}
+
+void Map::UpdateCrowdAvoidance( float deltaSeconds )
+{
+	m_avoidingEntities.clear();
+	for( Entity* entity : GetAliveEntities( ENTITY_TYPE_MASK_ALL ) )
+	{
+		if( entity->m_avoidsEntities )
+			m_avoidingEntities.push_back( entity );
+	}
+	//neighbors come from the entity grid as they were after the last tick, each entity only writes its own desired velocity
+	g_theJobSystem->ParallelFor( (int)m_avoidingEntities.size(), CROWD_AVOIDANCE_GRAIN_SIZE, [this, deltaSeconds]( int beginIndex, int endIndex )
+	{
+		thread_local EntityList nearbyEntities;
+		thread_local std::vector<AvoidanceNeighbor> neighbors;
+		EntityFilter neighborFilter( GetEntityTypeMask( ENTITY_TYPE_PLAYER ) | GetEntityTypeMask( ENTITY_TYPE_NPC_TANK ) | GetEntityTypeMask( ENTITY_TYPE_NPC_TURRET ) | GetEntityTypeMask( ENTITY_TYPE_BOULDER ) );
+		for( int entityID = beginIndex; entityID < endIndex; entityID++ )
 		{
-			Entity* entity = entityList[entityID];
-			if( entity != nullptr && entity->IsAlive() )
+			Entity* entity = m_avoidingEntities[entityID];
+			//one more than needed, the entity finds itself
+			GetNearestEntities( entity->m_position, CROWD_AVOIDANCE_MAX_NEIGHBORS + 1, CROWD_AVOIDANCE_NEIGHBOR_DIST, neighborFilter, nearbyEntities );
+			neighbors.clear();
+			for( const Entity* nearbyEntity : nearbyEntities )
 			{
-				if( entityTypeID == ENTITY_TYPE_PLAYER || entityTypeID == ENTITY_TYPE_NPC_TANK )
-				{
-					float speedFactor = GetTileSpeedFactorForPoint( entity->m_position );
-					entity->Update( deltaSeconds * speedFactor );
-				}
-				else entity->Update( deltaSeconds );
+				if( nearbyEntity != entity )
+					neighbors.push_back( AvoidanceNeighbor{ nearbyEntity->m_position, nearbyEntity->m_velocity, nearbyEntity->m_physicsRadius, nearbyEntity->m_avoidsEntities } );
+			}
+			if( !neighbors.empty() )
+			{
+				entity->m_desiredVelocity = ComputeAvoidanceVelocity( entity->m_position, entity->m_velocity, entity->m_physicsRadius, entity->m_desiredVelocity,
+					entity->m_speedLimit, neighbors, CROWD_AVOIDANCE_TIME_HORIZON, deltaSeconds );
 			}
 		}
-	}
+	} );
+}
+
+float Map::GetEntityDeltaSeconds( const Entity* entity, float deltaSeconds ) const
+{
+	//tanks and players move slower or faster with the tile under them
+	if( entity->m_type == ENTITY_TYPE_PLAYER || entity->m_type == ENTITY_TYPE_NPC_TANK )
+		return deltaSeconds * GetTileSpeedFactorForPoint( entity->m_position );
+	return deltaSeconds;
+}
+
+void Map::RebuildEntityGrid()
+{
+	//entities only move in Update and in collision, so two rebuilds a tick keep every query exact within the margin
+	m_entityGrid.Rebuild( m_entityListsByType );
 }
 
 void Map::ClearEntities()
 {
+	m_entityGrid.Clear();
 	for( int listID = 0; listID < (int)NUM_ENTITY_TYPES; listID++ )
 	{
 		EntityList& entityList = m_entityListsByType[listID];
@@ -608,228 +1283,196 @@ void Map::ClearEntities()
 		{
 			if(entityList[eID] != nullptr)
 				delete entityList[eID];
-			entityList[eID] = nullptr;
+		}
+		entityList.clear();
+		m_numHolesByType[listID] = 0;
+	}
+	m_destructionQueue.clear();
+	m_influenceMap.Reset();
+	m_player = nullptr;
+	m_playerID = INVALID_ENTITY_ID;
+	for( int typeID = 0; typeID < (int)NUM_ENTITY_TYPES; typeID++ )
+	{
+		for( int factionID = 0; factionID < (int)NUM_FACTIONS; factionID++ )
+		{
+			m_aliveCounts[typeID][factionID] = 0;
 		}
 	}
 }
 
-void Map::CleanDeadTrashEntities()
+void Map::ValidateAliveCounts() const
 {
-	for( int entityTypeID = 0; entityTypeID < (int)NUM_ENTITY_TYPES; entityTypeID++ )
+	//full scan, debug only
+	int scannedCounts[NUM_ENTITY_TYPES][NUM_FACTIONS] = {};
+	for( const Entity* entity : GetAliveEntities( ENTITY_TYPE_MASK_ALL ) )
 	{
-		if(entityTypeID==ENTITY_TYPE_PLAYER )
-			continue;
-		EntityList& entityList = m_entityListsByType[entityTypeID];
-		for( int entityID = 0; entityID < (int)entityList.size(); entityID++ )
+		scannedCounts[entity->m_type][entity->m_faction]++;
+		if( m_entityListsByType[entity->m_type][entity->m_listIndex] != entity )
+			ERROR_AND_DIE( Stringf( "Entity %u is not at its list index %d", entity->m_id, entity->m_listIndex ) );
+	}
+	for( int typeID = 0; typeID < (int)NUM_ENTITY_TYPES; typeID++ )
+	{
+		for( int factionID = 0; factionID < (int)NUM_FACTIONS; factionID++ )
 		{
-			Entity* entity = entityList[entityID];
-			if( entity!=nullptr && !entity->IsAlive() )
+			if( scannedCounts[typeID][factionID] != m_aliveCounts[typeID][factionID] )
 			{
-				delete entity;
-				entityList[entityID] = nullptr;
+				ERROR_AND_DIE( Stringf( "Alive count mismatch for entity type %d faction %d: counted %d, scanned %d", typeID, factionID,
+					m_aliveCounts[typeID][factionID], scannedCounts[typeID][factionID] ) );
 			}
 		}
 	}
 }
 
+void Map::CleanDeadTrashEntities()
+{
+	//only visit what died since last frame, delete hands the memory back to the entity pools
+	for( int queueID = 0; queueID < (int)m_destructionQueue.size(); queueID++ )
+	{
+		Entity* entity = m_destructionQueue[queueID];
+		m_entityListsByType[entity->m_type][entity->m_listIndex] = nullptr;
+		m_numHolesByType[entity->m_type]++;
+		delete entity;
+	}
+	m_destructionQueue.clear();
+
+	for( int entityTypeID = 0; entityTypeID < (int)NUM_ENTITY_TYPES; entityTypeID++ )
+	{
+		int numHoles = m_numHolesByType[entityTypeID];
+		int listSize = (int)m_entityListsByType[entityTypeID].size();
+		if( numHoles >= ENTITY_LIST_COMPACT_MIN_HOLES && (float)numHoles > ENTITY_LIST_COMPACT_HOLE_RATIO * (float)listSize )
+			CompactEntityList( (EntityType)entityTypeID );
+	}
+}
+
+void Map::CompactEntityList( EntityType type )
+{
+	//keeps the order of the survivors so update order stays the same
+	EntityList& entityList = m_entityListsByType[type];
+	int numKept = 0;
+	for( int entityID = 0; entityID < (int)entityList.size(); entityID++ )
+	{
+		Entity* entity = entityList[entityID];
+		if( entity == nullptr )
+			continue;
+		entity->m_listIndex = numKept;
+		entityList[numKept] = entity;
+		numKept++;
+	}
+	entityList.resize( numKept );
+	m_numHolesByType[type] = 0;
+}
+
 void Map::DetectCollisionForTilesAndEntities()
 {	
 	//detect collision for entityB and tile
-	for( int entityTypeID = 0; entityTypeID < (int)NUM_ENTITY_TYPES; entityTypeID++ )
+	for( Entity* entity : GetAliveEntities( ENTITY_TYPE_MASK_ALL ) )
 	{
-		EntityList& entityList = m_entityListsByType[entityTypeID];
-		for( int entityID = 0; entityID < (int)entityList.size(); entityID++ )
-		{
-			Entity* entity = entityList[entityID];
-			if( entity != nullptr && entity->IsAlive())
-				ResolveEntityTileCollision( entity );
-		}
+		ResolveEntityTileCollision( entity );
 	}
 }
 
 void Map::DetectCollisionForEntities()
 {
-	//detect collision for entities
-	for( int entityTypeAID = 0; entityTypeAID < (int)ENTITY_TYPE_EXPLOSION; entityTypeAID++ )
+	//candidate pairs come from the grid already masked by the collision matrix, the matrix also picks the handler
+	bool isPhysicsEnabled = g_isPhysicsEnabled;
+	thread_local EntityList touchingEntities;
+	for( int entityTypeAID = 0; entityTypeAID < (int)NUM_ENTITY_TYPES; entityTypeAID++ )
 	{
-		EntityList& entityListA = m_entityListsByType[entityTypeAID];
-		//pick up 
-		if(entityTypeAID==ENTITY_TYPE_PICKUP )
+		EntityType typeA = (EntityType)entityTypeAID;
+		EntityTypeMask maskA = COLLISION_MATRIX.GetMask( typeA, isPhysicsEnabled );
+		if( maskA == 0 )
 			continue;
-
-		//bullets
-		else if( entityTypeAID == ENTITY_TYPE_EVIL_BULLET )
+		if( (COLLISION_SWEPT_TYPE_MASK & GetEntityTypeMask( typeA )) != 0 )
 		{
-			DetectCollisionForBulletList( entityListA, FACTION_EVIL );
-		}
-		else if( entityTypeAID == ENTITY_TYPE_GOOD_BULLET )
-			DetectCollisionForBulletList( entityListA, FACTION_GOOD );
-
-		//debug physics option
-		else if( !g_isPhysicsEnabled && entityTypeAID == ENTITY_TYPE_PLAYER )
+			DetectSweptCollisionForType( typeA, maskA );
 			continue;
+		}
 
-		//Discuss collision for each entityA and other entities
-		for( int entityAID = 0; entityAID < (int)entityListA.size(); entityAID++ )
+		for( Entity* entityA : GetAliveEntitiesOfType( typeA ) )
 		{
-			for( int entityTypeBID = 0; entityTypeBID < (int)ENTITY_TYPE_EXPLOSION; entityTypeBID++ )
+			GetEntitiesInDisc( entityA->m_position, entityA->m_physicsRadius, EntityFilter( maskA ), touchingEntities );
+			for( Entity* entityB : touchingEntities )
 			{
-				//bullets & pickups 
-				if( entityTypeBID == ENTITY_TYPE_EVIL_BULLET || entityTypeBID == ENTITY_TYPE_GOOD_BULLET 
-					|| entityTypeBID==ENTITY_TYPE_PICKUP )
+				if( !entityA->IsAlive() )
+					break;
+				if( entityA == entityB || !entityB->IsAlive() )
 					continue;
-
-				//debug physics option
-				if( !g_isPhysicsEnabled && entityTypeBID == ENTITY_TYPE_PLAYER )
+				EntityType typeB = entityB->m_type;
+				if( COLLISION_MATRIX.m_requiresDifferentFaction[typeA][typeB] && entityA->m_faction == entityB->m_faction )
 					continue;
-
-				EntityList& entityListB = m_entityListsByType[entityTypeBID];
-				for( int entityBID = 0; entityBID < (int)entityListB.size(); entityBID++ )
-				{
-					//same entityB
-					if( entityTypeAID == entityTypeBID && entityAID == entityBID )
-						continue;
-					Entity* entityA = entityListA[entityAID];
-					Entity* entityB = entityListB[entityBID];
-					if( entityA == nullptr || !entityA->IsAlive() || entityB == nullptr || !entityB->IsAlive() )
-						continue;
-					if( entityTypeAID == ENTITY_TYPE_BOMB || entityTypeBID == ENTITY_TYPE_BOMB )
-					{
-						if( entityA->m_faction != entityB->m_faction &&
-							DoDiscsOverlap2D(entityA->m_position,entityA->m_physicsRadius,entityB->m_position,entityB->m_physicsRadius))
-						{
-							if( entityTypeAID == ENTITY_TYPE_BOMB )
-							{
-								entityA->Die();
-							}
-							if( entityTypeBID == ENTITY_TYPE_BOMB )
-							{
-								entityB->Die();
-							}
-						}
-					}
-					else ResolveEntitiesCollision( entityA, entityB );
-				}
+				//earlier pushes this frame may have separated them
+				if( !DoDiscsOverlap2D( entityA->m_position, entityA->m_physicsRadius, entityB->m_position, entityB->m_physicsRadius ) )
+					continue;
+				(this->*s_collisionPairHandlers[COLLISION_MATRIX.m_handlers[typeA][typeB]])( entityA, entityB );
 			}
 		}
 	}
 }
 
-void Map::DetectCollisionForBombs()
+void Map::DetectSweptCollisionForType( EntityType type, EntityTypeMask targetMask )
 {
-	EntityList& bombList = m_entityListsByType[ENTITY_TYPE_BOMB];
-	for( int bID = 0; bID < (int)bombList.size(); bID++ )
+	//swept over this tick's move, so a fast entity hits whatever it passed however fast it flies
+	//targets are taken at their end of tick positions, walls stop and destroy swept entities
+	for( Entity* entity : GetAliveEntitiesOfType( type ) )
 	{
-		Entity* bomb = bombList[bID];
-		if( bomb == nullptr || !bomb->IsAlive() )
-			continue;
+		Vec2 startPos = entity->m_positionBeforeMove;
+		Vec2 displacement = entity->m_position - startPos;
+		float tileFraction = 1.f;
+		bool hasHitTile = SweepDiscAgainstTiles( startPos, entity->m_physicsRadius, displacement, tileFraction );
+		float entityFraction = 1.f;
+		EntityFilter targetFilter( targetMask, entity->m_faction, true );
+		Entity* hitEntity = SweepDiscAgainstEntities( startPos, entity->m_physicsRadius, displacement, targetFilter, entityFraction );
+		if( hitEntity != nullptr && (!hasHitTile || entityFraction <= tileFraction) )
+		{
+			entity->m_position = startPos + displacement * entityFraction;
+			(this->*s_collisionPairHandlers[COLLISION_MATRIX.m_handlers[type][hitEntity->m_type]])( entity, hitEntity );
+		}
+		else if( hasHitTile )
+		{
+			entity->m_position = startPos + displacement * tileFraction;
+			entity->Die();
+		}
 	}
 }
 
-void Map::DetectCollisionForPickups()
+void Map::ResolveBulletHit( Entity* bullet, Entity* entity )
 {
-	EntityList& pickupList = m_entityListsByType[ENTITY_TYPE_PICKUP];
-	for( int pID = 0; pID < (int)pickupList.size(); pID++ )
+	if( entity->m_isHitByBullets )
 	{
-		Pickup*pickup = (Pickup*)pickupList[pID];
-		if(pickup==nullptr||!pickup->IsAlive() )
-			continue;
-		DetectPickupCollisionForEntityType(pickup, ENTITY_TYPE_PLAYER );
-		DetectPickupCollisionForEntityType( pickup, ENTITY_TYPE_NPC_TANK );
+		bullet->TakeDamage( 1 );
+		entity->TakeDamage( 1 );
 	}
 }
 
-void Map::DetectPickupCollisionForEntityType( Pickup* pickup, EntityType type )
+void Map::ResolveBombContact( Entity* bomb, Entity* entity )
 {
-	if( pickup == nullptr || !pickup->IsAlive() )
-		return;
-	EntityList& entityList = m_entityListsByType[type];
-	for( int eID = 0; eID < (int)entityList.size(); eID++ )
-	{
-		Entity* entity = entityList[eID];
-		if(entity==nullptr||!entity->IsAlive() )
-			continue;
-		if( DoDiscsOverlap2D( pickup->m_position, pickup->m_physicsRadius, entity->m_position, entity->m_physicsRadius ) )
-		{
-			if(entity->m_faction == pickup->m_faction)
-				entity->PickupStuff( pickup->m_pickupType );
-			pickup->Die();
-		}
-	}
+	bomb->Die();
+	//a bomb that would go off on this contact too goes off with it
+	if( COLLISION_MATRIX.m_handlers[entity->m_type][bomb->m_type] == COLLISION_PAIR_BOMB_CONTACT )
+		entity->Die();
 }
 
-void Map::DetectCollisionForBulletList(EntityList& bulletList,EntityFaction faction)
+void Map::ResolvePickupCollect( Entity* pickupEntity, Entity* entity )
 {
-	for( int bID = 0; bID < (int)bulletList.size(); bID++ )
-	{
-		Entity* bullet = bulletList[bID];
-		if( bullet == nullptr || !bullet->IsAlive())
-			continue;
-		for( int listID = 0; listID < ENTITY_TYPE_EXPLOSION; listID++ )
-		{
-			if(listID==ENTITY_TYPE_EVIL_BULLET||listID==ENTITY_TYPE_GOOD_BULLET ) //do not consider collision between bullets
-				continue;
-			if( !g_isPhysicsEnabled && listID == ENTITY_TYPE_PLAYER )
-				continue;
-			EntityList& thisList = m_entityListsByType[listID];
-			for( int eID = 0; eID < (int)thisList.size(); eID++ )
-			{
-				Entity* entity = thisList[eID];
-				if( entity != nullptr && entity->m_faction != faction && bullet!=entity
-					&& DoDiscsOverlap2D(bullet->m_position,bullet->m_physicsRadius,entity->m_position,entity->m_physicsRadius))
-				{
-					if( listID == ENTITY_TYPE_BOULDER )
-					{
-						DeflectEntityOffEntity(bullet,entity);
-						continue;//deflects
-					}
-					
-					if( entity->m_isHitByBullets )
-					{
-						bullet->TakeDamage( 1 );
-						entity->TakeDamage( 1 );
-					}
-				}
-			}
-		}
-	}
-
+	//a pickup is used up by the first entity that touches it
+	Pickup* pickup = (Pickup*)pickupEntity;
+	if( entity->m_faction == pickup->m_faction )
+		entity->PickupStuff( pickup->m_pickupType );
+	pickup->Die();
 }
 
 void Map::ResolveFactionBombForEntityType( EntityType type, EntityFaction faction, const Vec2& position, float radius )
 {
-	EntityList& entityList = m_entityListsByType[type];
-	for( int eID = 0; eID < (int)entityList.size(); eID++ )
+	//the grid hands back every disc touching the blast, only centers inside it switch
+	thread_local EntityList nearbyEntities;
+	GetEntitiesInDisc( position, radius, EntityFilter( GetEntityTypeMask( type ), faction, true ), nearbyEntities );
+	for( Entity* entity : nearbyEntities )
 	{
-		Entity* entity = entityList[eID];
-		if(entity==nullptr||!entity->IsAlive()||entity->m_faction==faction )
-			continue;
 		if((entity->m_position-position).GetLength()<radius )
 			entity->SwitchFaction();
 	}
 }
 
-void Map::ResolveTurretsOverlap()
-{
-	EntityList& turretList = m_entityListsByType[ENTITY_TYPE_NPC_TURRET];
-	for( int turretA = 0; turretA < (int)turretList.size(); turretA++ )
-	{
-		ResolveOneTurretOverlap( turretList[turretA] );
-	}
-}
-
-void Map::ResolveOneTurretOverlap( Entity* turret )
-{
-	EntityList turretList = m_entityListsByType[ENTITY_TYPE_NPC_TURRET];
-	for( int tID = 0; tID < (int)turretList.size(); tID++ )
-	{
-		Entity* otherTurret = turretList[tID];
-		if(turret== otherTurret)
-			continue;
-		PushDiscsOutOfEachOther2D( turret->m_position, turret->m_physicsRadius, otherTurret->m_position, otherTurret->m_physicsRadius );
-	}
-}
-
 void Map::ResolveEntitiesCollision( Entity* entityA, Entity* entityB )
 {
 	if( !entityA->m_isPushedByEntities && !entityB->m_isPushedByEntities )//both can not be pushed
@@ -863,23 +1506,8 @@ void Map::ResolveEntityTileCollision( Entity* entity )
 	if( !entity->m_isPushedByWalls )
 		return;
 
-	IntVec2 searchOrder[8] = {
-		IntVec2( 1,0 ),IntVec2( 0,1 ),IntVec2( -1,0 ),IntVec2( 0,-1 ),
-		IntVec2( 1,1 ),IntVec2( -1,1 ),IntVec2( -1,-1 ),IntVec2( 1,-1 )
-	};
-	float radius = entity->m_physicsRadius;
-	IntVec2 posCoords = GetTileCoordsForPosition( entity->m_position );
-	//Assume that entityB radius < 1
-	for( int searchID = 0; searchID < 8; searchID++ )
-	{
-		int tileID = GetTileIndexForTileCoords( posCoords + searchOrder[searchID] );
-		if(tileID>=m_size.x*m_size.y || tileID<0)
-			continue;
-
-		Tile& tile = m_tiles[tileID];
-		if( TileDefinition::s_definitions[tile.m_type].m_isSolid )
-			PushDiscOutOfAABB2D( entity->m_position, radius, tile.GetBounds() );
-	}
+	IntVec2 tileCoords = GetTileCoordsForPosition( entity->m_position );
+	PushDiscOutOfSolidNeighbors( entity->m_position, entity->m_physicsRadius, tileCoords, m_tiles.GetSolidNeighborMask( tileCoords ) );
 }
 
 void Map::DeflectEntityOffEntity( Entity* entityMobile, Entity* entityStill )
@@ -892,64 +1520,91 @@ void Map::DeflectEntityOffEntity( Entity* entityMobile, Entity* entityStill )
 	PushDiscOutOfDisc2D( entityMobile->m_position, entityMobile->m_physicsRadius, entityStill->m_position, entityStill->m_physicsRadius );
 }
 
-void Map::Render() const
-{
-	RenderTiles();
-	RenderEntities();
-	if( g_isDebugDrawing )
-		DebugRender();
-}
-
-void Map::DebugRender() const
+void Map::FillRenderSnapshot( RenderSnapshot& snapshot )
 {
-	g_theRenderer->BindDiffuseTexture( (Texture*)nullptr );
+	//entities are visited type by type, so every type ends up in one contiguous range
+	snapshot.m_entities.clear();
 	for( int entityTypeID = 0; entityTypeID < (int)NUM_ENTITY_TYPES; entityTypeID++ )
 	{
-		EntityList entityList = m_entityListsByType[entityTypeID];
-		for( int entityID = 0; entityID < (int)entityList.size(); entityID++ )
+		snapshot.m_firstEntityOfType[entityTypeID] = (int)snapshot.m_entities.size();
+		for( const Entity* entity : GetAliveEntitiesOfType( (EntityType)entityTypeID ) )
 		{
-			Entity* entity = entityList[entityID];
-			if(entity!=nullptr )
-				entity->DebugRender();
+			snapshot.m_entities.emplace_back();
+			entity->FillRenderState( snapshot.m_entities.back() );
 		}
 	}
-}
+	snapshot.m_firstEntityOfType[NUM_ENTITY_TYPES] = (int)snapshot.m_entities.size();
 
-void Map::RenderTiles() const
-{
-	g_theRenderer->BindDiffuseTexture( (Texture*)nullptr );
-	//could change to different tile types and different loops
-	for( int tileTypeID = 0; tileTypeID < NUM_TILE_TYPE; tileTypeID++ )
+	//only the chunks around the player go to the renderer, so a big map is never read whole
+	//tile types are copied again after they changed or the player moved the window
+	const Entity* player = GetPlayerAlive();
+	IntVec2 windowMins = player != nullptr ? GetRenderTileWindowMins( player->m_position ) : m_renderTileWindowMins;
+	if( m_areRenderTileTypesDirty || m_renderTileTypes == nullptr || windowMins != m_renderTileWindowMins )
 	{
-		g_tileVerts.clear();
-		for( int tID = 0; tID < (int)m_tiles.size(); tID++ )
+		int maxWindowSize = (2 * RENDER_TILE_WINDOW_CHUNK_RADIUS + 1) * TILE_CHUNK_SIZE;
+		IntVec2 windowSize( std::min( m_size.x - windowMins.x, maxWindowSize ), std::min( m_size.y - windowMins.y, maxWindowSize ) );
+		std::shared_ptr<std::vector<TileType>> tileTypes = std::make_shared<std::vector<TileType>>( (size_t)windowSize.x * (size_t)windowSize.y );
+		for( int localY = 0; localY < windowSize.y; localY++ )
 		{
-			if(m_tiles[tID].m_type==(TileType)tileTypeID)
-				m_tiles[tID].Render();
+			for( int localX = 0; localX < windowSize.x; localX++ )
+			{
+				(*tileTypes)[(size_t)localY * (size_t)windowSize.x + (size_t)localX] = m_tiles.GetTileType( windowMins + IntVec2( localX, localY ) );
+			}
 		}
-		if(g_tileVerts.size()<1 )
-			continue;
-
-		const Texture& thisTexture = TileDefinition::s_definitions[(int)tileTypeID].m_texture;
-		g_theRenderer->BindDiffuseTexture( &thisTexture );
-		g_theRenderer->DrawVertexArray( g_tileVerts );
+		m_renderTileTypes = tileTypes;
+		m_renderTileWindowMins = windowMins;
+		m_renderTileWindowSize = windowSize;
+		m_renderTileMeshVersion = s_nextTileMeshVersion++;
+		m_areRenderTileTypesDirty = false;
 	}
-}
-
-void Map::RenderEntities() const
-{
-	for( int entityTypeID = 0; entityTypeID < (int)NUM_ENTITY_TYPES; entityTypeID++ )
+	//fog of the player's faction over the same window, copied again after that faction's visibility or the window changed
+	if( player != nullptr )
+		m_renderFogFaction = player->m_faction;
+	int fogFactionVersion = m_visibilityField.GetFactionVersion( m_renderFogFaction );
+	if( m_renderTileFogLevels == nullptr || m_renderFogTileMeshVersion != m_renderTileMeshVersion
+		|| m_renderFogBuiltFaction != m_renderFogFaction || m_renderFogFactionVersion != fogFactionVersion )
 	{
-		EntityList entityList = m_entityListsByType[entityTypeID];
-		if( entityTypeID == (int)NUM_ENTITY_TYPES - 1 )
-			g_theRenderer->SetBlendMode( eBlendMode::BLEND_ADDITIVE );
-		for( int entityID = 0; entityID < (int)entityList.size(); entityID++ )
+		std::shared_ptr<std::vector<TileFogLevel>> fogLevels = std::make_shared<std::vector<TileFogLevel>>( (size_t)m_renderTileWindowSize.x * (size_t)m_renderTileWindowSize.y );
+		for( int localY = 0; localY < m_renderTileWindowSize.y; localY++ )
 		{
-			Entity* entity = entityList[entityID];
-			if( entity != nullptr && entity->IsAlive())
-				entity->Render();
+			for( int localX = 0; localX < m_renderTileWindowSize.x; localX++ )
+			{
+				(*fogLevels)[(size_t)localY * (size_t)m_renderTileWindowSize.x + (size_t)localX] = m_visibilityField.GetFogLevel( m_renderTileWindowMins + IntVec2( localX, localY ), m_renderFogFaction );
+			}
 		}
-		if( entityTypeID == (int)NUM_ENTITY_TYPES - 1 )
-			g_theRenderer->SetBlendMode( eBlendMode::BLEND_ALPHA );
+		m_renderTileFogLevels = fogLevels;
+		m_renderTileFogVersion = s_nextTileMeshVersion++;
+		m_renderFogTileMeshVersion = m_renderTileMeshVersion;
+		m_renderFogBuiltFaction = m_renderFogFaction;
+		m_renderFogFactionVersion = fogFactionVersion;
 	}
+	snapshot.m_tileTypes = m_renderTileTypes;
+	snapshot.m_tileWindowMins = m_renderTileWindowMins;
+	snapshot.m_tileWindowSize = m_renderTileWindowSize;
+	snapshot.m_tileMeshVersion = m_renderTileMeshVersion;
+	snapshot.m_tileFogLevels = m_renderTileFogLevels;
+	snapshot.m_tileFogVersion = m_renderTileFogVersion;
+	snapshot.m_mapSize = m_size;
+
+	snapshot.m_isPlayerAlive = player != nullptr;
+	if( player != nullptr )
+	{
+		snapshot.m_playerPosition = player->m_position;
+		snapshot.m_playerFactionBombNum = player->m_factionBombNum;
+	}
+
+	snapshot.m_numAIThinks = m_aiScheduler.GetNumThinksLastFrame();
+	snapshot.m_numAIDeferred = m_aiScheduler.GetNumDeferredLastFrame();
+	snapshot.m_aiMicroseconds = m_aiScheduler.GetMicrosecondsUsedLastFrame();
+}
+
+IntVec2 Map::GetRenderTileWindowMins( const Vec2& focusPosition ) const
+{
+	//chunk aligned and pushed back inside the map, so maps smaller than the window always show whole
+	IntVec2 chunkDimensions = m_tiles.GetChunkDimensions();
+	int windowNumChunks = 2 * RENDER_TILE_WINDOW_CHUNK_RADIUS + 1;
+	IntVec2 focusChunk = m_tiles.GetChunkCoordsForTile( GetTileCoordsForPosition( focusPosition ) );
+	int minChunkX = std::max( 0, std::min( focusChunk.x - RENDER_TILE_WINDOW_CHUNK_RADIUS, chunkDimensions.x - windowNumChunks ) );
+	int minChunkY = std::max( 0, std::min( focusChunk.y - RENDER_TILE_WINDOW_CHUNK_RADIUS, chunkDimensions.y - windowNumChunks ) );
+	return IntVec2( minChunkX << TILE_CHUNK_SIZE_LOG2, minChunkY << TILE_CHUNK_SIZE_LOG2 );
 }
@@ -1,22 +1,35 @@
 #pragma once
 
 #include <vector>
+#include <memory>
 #include "Engine/Math/IntVec2.hpp"
 #include "Engine/Math/Vec2.hpp"
 #include "Game/Entity.hpp"
+#include "Game/EntityView.hpp"
+#include "Game/EntitySpatialGrid.hpp"
+#include "Game/MapFile.hpp"
+#include "Game/MapGenerationParams.hpp"
+#include "Game/SpawnTable.hpp"
+#include "Game/CollisionMatrix.hpp"
 #include "Game/GameCommon.hpp"
+#include "Game/VisibilityField.hpp"
+#include "Game/LineOfSightCache.hpp"
+#include "Game/HierarchicalPathfinder.hpp"
+#include "Game/AIScheduler.hpp"
 #include "Game/WormDefinition.hpp"
+#include "Game/CrowdAvoidance.hpp"
+#include "Game/InfluenceMap.hpp"
 
 class Tile;
 class Game;
 class World;
 class Entity;
 class Pickup;
-struct Vertex_PCU;
+struct RenderSnapshot;
+class DeterministicRNG;
+class SpawnPlacer;
 enum TileType : int;
 
-extern std::vector<Vertex_PCU> g_tileVerts;
-
 struct RaycastResult
 {
 	bool m_impacted;
@@ -49,37 +62,127 @@ public:
 	void    AddEntityToList( Entity* entity, EntityList& entityList );
 
 	void   ResolveFactionBombExlopsion( EntityFaction faction, const Vec2& position, float radius );
+	//NPC spawn points are never picked inside these
+	void   AddSpawnExclusionZone( const SpawnExclusionZone& zone );
 
-	int     GetTileIndexForTileCoords( const IntVec2& tileCoords ) const;
-	int     GetTileIndexForPosition( const Vec2& position ) const;
-	IntVec2 GetTileCoordsForTileIndex( int tileIndex ) const;
+	//out of bounds dies, linear indices are 64 bit so large maps do not overflow
+	int64_t GetTileIndexForTileCoords( const IntVec2& tileCoords ) const;
+	IntVec2 GetTileCoordsForTileIndex( int64_t tileIndex ) const;
 	IntVec2 GetTileCoordsForPosition( const Vec2& position ) const;
 	Entity* GetPlayerAlive() const;
+	EntityID GetPlayerID() const { return m_playerID; }
+	void    DetachPlayer();
+
+	EntityView GetAliveEntities( EntityTypeMask typeMask ) const;
+	EntityView GetAliveEntitiesOfType( EntityType type ) const;
+	EntityView GetAliveEntitiesOfFaction( EntityTypeMask typeMask, EntityFaction faction ) const;
+	EntityView GetAliveEntitiesNotOfFaction( EntityTypeMask typeMask, EntityFaction faction ) const;
+
+	int  GetAliveCount( EntityType type, EntityFaction faction ) const { return m_aliveCounts[type][faction]; }
+	int  GetAliveCountForType( EntityType type ) const;
+	int  GetAliveCountForFaction( EntityTypeMask typeMask, EntityFaction faction ) const;
+	void NotifyEntityDied( Entity* entity );
+	void NotifyEntityFactionSwitched( const Entity* entity, EntityFaction oldFaction );
 
 	bool IsPointInSolid( const Vec2& point ) const;
 	bool IsPointInTileType( const Vec2& point, TileType type )const;
 	bool IsTileSolid( const IntVec2& tileCoords ) const;
+	//distance from the tile center to the nearest solid tile, capped at TILE_CLEARANCE_RANGE
+	float GetTileClearance( const IntVec2& tileCoords ) const;
+	//conservative: the tile clearance less the distance to the tile center
+	bool CanDiscFitAt( const Vec2& center, float radius ) const;
+	//positions off the map read the nearest tile on it
+	TileType GetTileTypeForPosition( const Vec2& position ) const;
 	bool IsTileInEdge( const IntVec2& tileCoords ) const;
 	bool HasLineOfSight( const Vec2& startPoint, const Vec2& endPoint, float maxDist ) const;
+	bool IsSegmentClearOfSolid( const Vec2& startPoint, const Vec2& endPoint ) const;
+	void SetTileType( const IntVec2& tileCoords, TileType type );
 	RaycastResult Raycast( const Vec2& startPosition, const Vec2& forwardDir, float maxDist ) const;	
-	Entity* RaycastForEnemyFaction( EntityFaction faction, const Vec2& startPoint, float maxDist ) const;
-	Entity* RaycastForEnemyType( EntityFaction faction, EntityType type, const Vec2& startPoint, float maxDist ) const;
-	Entity* RaycastForEnemyEntity( EntityFaction faction, Entity* enemy, const Vec2& startpoint, float maxDist )const;
+
+	//answered from this tick's visibility field, falls back to a raycast for observers that are not in it
+	bool    IsVisibleFrom( const Vec2& observerPos, const Vec2& targetPos, float maxDist ) const;
+	Entity* GetNearestVisibleEnemy( EntityFaction faction, const Vec2& observerPos, float maxDist ) const;
+	Entity* GetNearestVisibleEntity( const EntityFilter& filter, const Vec2& observerPos, float maxDist ) const;
+	const VisibilityField& GetVisibilityField() const { return m_visibilityField; }
+	const AIScheduler& GetAIScheduler() const { return m_aiScheduler; }
+	//brought up to date at the start of every tick, before thinks read it
+	const InfluenceMap& GetInfluenceMap() const { return m_influenceMap; }
+	//waypoints around walls for NAV_AGENT_RADIUS agents, false when the goal cannot be reached or the map is too big to plan on
+	bool    FindPath( const Vec2& startPos, const Vec2& goalPos, std::vector<Vec2>& out_waypoints ) const;
+
+	//spatial queries over alive entities, answered from the entity grid, read only so Think may call them
+	void    GetEntitiesInDisc( const Vec2& center, float radius, const EntityFilter& filter, EntityList& out_entities ) const;
+	void    GetEntitiesInAABB2( const AABB2& bounds, const EntityFilter& filter, EntityList& out_entities ) const;
+	Entity* RaycastEntities( const Vec2& startPosition, const Vec2& forwardDir, float maxDist, const EntityFilter& filter, float* out_impactDist = nullptr ) const;
+	//swept disc tests, out_impactFraction is the time of impact as a fraction of displacement
+	Entity* SweepDiscAgainstEntities( const Vec2& startPosition, float radius, const Vec2& displacement, const EntityFilter& filter, float& out_impactFraction ) const;
+	bool    SweepDiscAgainstTiles( const Vec2& startPosition, float radius, const Vec2& displacement, float& out_impactFraction ) const;
+	//sorted nearest first, at most maxCount entities whose centers are closer than maxDist
+	void    GetNearestEntities( const Vec2& position, int maxCount, float maxDist, const EntityFilter& filter, EntityList& out_entities ) const;
+
+	void FillRenderSnapshot( RenderSnapshot& snapshot );
+
+	//false leaves the map without tiles, to be generated instead
+	bool LoadMapFile( const std::string& filePath );
+	bool SaveMapFile( const std::string& filePath ) const;
 
 private:
 	World*  m_world = nullptr;
 	Game* m_game = nullptr;
 	IntVec2 m_size;
 	float m_playerRespawnCountdown = PLAYER_RESPAWN_INTERVAL;
-	std::vector<Tile> m_tiles;
+	//loaded maps read their tiles from here, declared before m_tiles so it is closed after it
+	MapFile m_mapFile;
+	TileStorage m_tiles;
+	VisibilityField m_visibilityField;
+	LineOfSightCache m_lineOfSightCache;
+	HierarchicalPathfinder m_pathfinder;
+	InfluenceMap m_influenceMap;
+	AIScheduler m_aiScheduler;
 	EntityList m_entityListsByType[NUM_ENTITY_TYPES];
-
-	void GenerateMap( TileType defaultTile, TileType edgeTile, TileType startTile, TileType endTile, std::vector<WormDefinition>& wormDefs );
-	void InitTiles( TileType defaultTile, TileType edgeTile, TileType startTile, TileType endTile, std::vector<WormDefinition>& wormDefs );
-	void InitWormsForDefinition( WormDefinition wormDef );
-
-	IntVec2 GetRandomAdjacentTileCoords( const IntVec2& tileCoords );
-	Vec2    GetEnemySpawnPoint() const;
+	//rebuilt before perception and before collision, spawns in between are inserted as they happen
+	EntitySpatialGrid m_entityGrid;
+	//gathered each tick so crowd avoidance can split them over jobs
+	EntityList m_avoidingEntities;
+	Entity* m_player = nullptr;
+	EntityID m_playerID = INVALID_ENTITY_ID;
+	//alive entities per type and faction, kept up to date on spawn, die, faction switch and removal
+	int m_aliveCounts[NUM_ENTITY_TYPES][NUM_FACTIONS] = {};
+	//entities that died since the last clean up, players stay in their list until respawn
+	std::vector<Entity*> m_destructionQueue;
+	int m_numHolesByType[NUM_ENTITY_TYPES] = {};
+	//tile types handed to render snapshots, copied again only after a tile changed or the window moved
+	std::shared_ptr<const std::vector<TileType>> m_renderTileTypes;
+	IntVec2 m_renderTileWindowMins;
+	IntVec2 m_renderTileWindowSize;
+	//tiles NPCs spawn on, rebuilt from the tiles at the next spawn after a tile changed its spawnability
+	SpawnTable m_enemySpawnTable;
+	bool m_isEnemySpawnTableDirty = false;
+	std::vector<SpawnExclusionZone> m_spawnExclusionZones;
+	int  m_renderTileMeshVersion = 0;
+	bool m_areRenderTileTypesDirty = true;
+	//fog levels of one faction over the render tile window, and what they were copied for
+	std::shared_ptr<const std::vector<TileFogLevel>> m_renderTileFogLevels;
+	int  m_renderTileFogVersion = 0;
+	int  m_renderFogTileMeshVersion = 0;
+	int  m_renderFogFactionVersion = 0;
+	EntityFaction m_renderFogFaction = FACTION_GOOD;
+	EntityFaction m_renderFogBuiltFaction = NUM_FACTIONS;
+
+	//loads the map cached for these parameters, or generates it and writes the cache
+	void LoadOrGenerateMap( const MapGenerationParams& params );
+	void GenerateMap( const MapGenerationParams& params );
+	void InitTiles( const MapGenerationParams& params, DeterministicRNG& rng );
+	void InitWormsForDefinition( const WormDefinition& wormDef, DeterministicRNG& rng );
+	void StartupTileCaches();
+	IntVec2 GetRenderTileWindowMins( const Vec2& focusPosition ) const;
+
+	IntVec2 GetRandomAdjacentTileCoords( const IntVec2& tileCoords, DeterministicRNG& rng ) const;
+	Vec2    GetEnemySpawnPoint();
+	Vec2    GetEnemySpawnPointFromRebuiltTable();
+	void    SpawnNPCsApart( SpawnPlacer& placer, EntityType type, EntityFaction faction, int numNPCs );
+	bool    IsInSpawnExclusionZone( const Vec2& position ) const;
+	int64_t RollRandomSpawnTableEntry( int64_t numEntries ) const;
 	float   GetTileSpeedFactorForPoint( const Vec2& point ) const;
 
 	bool IsMapWalkable();
@@ -87,25 +190,31 @@ private:
 	bool IsEnemyFactionExist(EntityFaction faction) const;
 
 	void Update( float deltaSeconds );
+	void UpdatePerception();
+	void UpdateInfluenceMap();
+	void RemoveInfluenceStamp( Entity* entity );
 	void UpdateEntities( float deltaSeconds );
+	void UpdateCrowdAvoidance( float deltaSeconds );
+	float GetEntityDeltaSeconds( const Entity* entity, float deltaSeconds ) const;
+	void RebuildEntityGrid();
 	void ClearEntities();
 	void CleanDeadTrashEntities();
+	void CompactEntityList( EntityType type );
+	void ValidateAliveCounts() const;
 
 	void DetectCollisionForTilesAndEntities();
 	void DetectCollisionForEntities();
-	void DetectCollisionForBombs();
-	void DetectCollisionForPickups();
-	void DetectPickupCollisionForEntityType( Pickup* pickup, EntityType type );
-	void DetectCollisionForBulletList(EntityList& bulletList, EntityFaction faction);
+	void DetectSweptCollisionForType( EntityType type, EntityTypeMask targetMask );
 	void ResolveFactionBombForEntityType( EntityType type, EntityFaction faction, const Vec2& position, float radius );
-	void ResolveTurretsOverlap();
-	void ResolveOneTurretOverlap( Entity* turret );
+	//collision pair handlers, picked by COLLISION_MATRIX
+	typedef void (Map::*CollisionPairHandlerFunc)( Entity* entityA, Entity* entityB );
+	static const CollisionPairHandlerFunc s_collisionPairHandlers[NUM_COLLISION_PAIR_HANDLERS];
 	void ResolveEntitiesCollision( Entity* entityA, Entity* entityB );
+	void ResolveBulletHit( Entity* bullet, Entity* entity );
+	void ResolveBombContact( Entity* bomb, Entity* entity );
+	void ResolvePickupCollect( Entity* pickupEntity, Entity* entity );
 	void ResolveEntityTileCollision( Entity* entity );
 	void DeflectEntityOffEntity( Entity* entityMobile, Entity* entityStill );
-
-	void Render()const;
-	void DebugRender()const;
-	void RenderTiles()const;
-	void RenderEntities()const;
+	bool GetSweptDiscEntryIntoTile( const Vec2& startPosition, float radius, const Vec2& displacement, const IntVec2& tileCoords, float& out_fraction ) const;
+	Entity* CastDiscAgainstEntities( const Vec2& startPosition, const Vec2& forwardDir, float maxDist, float castRadius, const EntityFilter& filter, float& out_impactDist ) const;
 };
\ No newline at end of file
@@ -0,0 +1,174 @@
+#include "Game/MapFile.hpp"
+#include "Game/SpawnTable.hpp"
+#include "Engine/Core/ErrorWarningAssert.hpp"
+#include <fstream>
+#include <type_traits>
+#include <vector>
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+//chunk records are written and mapped as raw bytes
+static_assert( std::is_trivially_copyable<TileChunk>::value, "TileChunk is stored in map files byte for byte" );
+static_assert( std::is_trivially_copyable<MapFileHeader>::value, "MapFileHeader is stored in map files byte for byte" );
+
+//////////////////////////////////////////////////////////////////////////
+static uint64_t AlignFileOffset( uint64_t offset )
+{
+	return (offset + MAP_FILE_SECTION_ALIGNMENT - 1) / MAP_FILE_SECTION_ALIGNMENT * MAP_FILE_SECTION_ALIGNMENT;
+}
+
+//////////////////////////////////////////////////////////////////////////
+static void WritePadding( std::ofstream& file, uint64_t fromOffset, uint64_t toOffset )
+{
+	static const char s_zeros[MAP_FILE_SECTION_ALIGNMENT] = {};
+	file.write( s_zeros, (std::streamsize)(toOffset - fromOffset) );
+}
+
+//////////////////////////////////////////////////////////////////////////
+MapFile::~MapFile()
+{
+	Close();
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool MapFile::Open( const std::string& filePath )
+{
+	Close();
+	HANDLE fileHandle = CreateFileA( filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr );
+	if( fileHandle == INVALID_HANDLE_VALUE )
+		return false;
+	LARGE_INTEGER fileSize;
+	if( !GetFileSizeEx( fileHandle, &fileSize ) || fileSize.QuadPart < (LONGLONG)sizeof( MapFileHeader ) )
+	{
+		CloseHandle( fileHandle );
+		return false;
+	}
+	HANDLE mappingHandle = CreateFileMappingA( fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr );
+	if( mappingHandle == nullptr )
+	{
+		CloseHandle( fileHandle );
+		return false;
+	}
+	//map the whole file, reserving address space commits no memory until a page is read
+	void* view = MapViewOfFile( mappingHandle, FILE_MAP_READ, 0, 0, 0 );
+	if( view == nullptr )
+	{
+		CloseHandle( mappingHandle );
+		CloseHandle( fileHandle );
+		return false;
+	}
+
+	m_fileHandle = fileHandle;
+	m_mappingHandle = mappingHandle;
+	m_view = static_cast<const unsigned char*>(view);
+	m_viewSize = (uint64_t)fileSize.QuadPart;
+	if( !IsHeaderValid() )
+	{
+		DebuggerPrintf( "Map file %s does not match map file version %u, ignored\n", filePath.c_str(), MAP_FILE_VERSION );
+		Close();
+		return false;
+	}
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void MapFile::Close()
+{
+	if( m_view != nullptr )
+		UnmapViewOfFile( m_view );
+	if( m_mappingHandle != nullptr )
+		CloseHandle( m_mappingHandle );
+	if( m_fileHandle != nullptr )
+		CloseHandle( m_fileHandle );
+	m_view = nullptr;
+	m_mappingHandle = nullptr;
+	m_fileHandle = nullptr;
+	m_viewSize = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool MapFile::Write( const std::string& filePath, const TileStorage& tiles, uint64_t generationHash )
+{
+	//spawn tables are derived from the tile definitions once here, loading never scans tiles
+	std::vector<int64_t> spawnTables[NUM_MAP_SPAWN_TABLES];
+	SpawnTable::CollectEnemySpawnTiles( tiles, spawnTables[MAP_SPAWN_TABLE_ENEMY] );
+	const IntVec2& dimensions = tiles.GetDimensions();
+
+	MapFileHeader header;
+	header.m_headerSize = sizeof( MapFileHeader );
+	header.m_chunkRecordSize = sizeof( TileChunk );
+	header.m_chunkSizeLog2 = TILE_CHUNK_SIZE_LOG2;
+	header.m_numTileTypes = NUM_TILE_TYPE;
+	header.m_dimensionX = dimensions.x;
+	header.m_dimensionY = dimensions.y;
+	header.m_chunkDimensionX = tiles.GetChunkDimensions().x;
+	header.m_chunkDimensionY = tiles.GetChunkDimensions().y;
+	header.m_chunksOffset = AlignFileOffset( sizeof( MapFileHeader ) );
+	uint64_t nextOffset = header.m_chunksOffset + (uint64_t)tiles.GetNumChunks() * sizeof( TileChunk );
+	for( int tableID = 0; tableID < (int)NUM_MAP_SPAWN_TABLES; tableID++ )
+	{
+		header.m_spawnTableOffsets[tableID] = AlignFileOffset( nextOffset );
+		header.m_spawnTableSizes[tableID] = spawnTables[tableID].size();
+		nextOffset = header.m_spawnTableOffsets[tableID] + spawnTables[tableID].size() * sizeof( int64_t );
+	}
+	header.m_fileSize = nextOffset;
+	header.m_generationHash = generationHash;
+
+	std::ofstream file( filePath, std::ios::binary | std::ios::trunc );
+	if( !file )
+		return false;
+	file.write( reinterpret_cast<const char*>(&header), sizeof( MapFileHeader ) );
+	WritePadding( file, sizeof( MapFileHeader ), header.m_chunksOffset );
+	for( size_t chunkIndex = 0; chunkIndex < tiles.GetNumChunks(); chunkIndex++ )
+	{
+		file.write( reinterpret_cast<const char*>(&tiles.GetChunk( chunkIndex )), sizeof( TileChunk ) );
+	}
+	uint64_t writtenOffset = header.m_chunksOffset + (uint64_t)tiles.GetNumChunks() * sizeof( TileChunk );
+	for( int tableID = 0; tableID < (int)NUM_MAP_SPAWN_TABLES; tableID++ )
+	{
+		WritePadding( file, writtenOffset, header.m_spawnTableOffsets[tableID] );
+		file.write( reinterpret_cast<const char*>(spawnTables[tableID].data()), (std::streamsize)(spawnTables[tableID].size() * sizeof( int64_t )) );
+		writtenOffset = header.m_spawnTableOffsets[tableID] + spawnTables[tableID].size() * sizeof( int64_t );
+	}
+	return file.good();
+}
+
+//////////////////////////////////////////////////////////////////////////
+const TileChunk* MapFile::GetChunks() const
+{
+	return reinterpret_cast<const TileChunk*>(m_view + GetHeader().m_chunksOffset);
+}
+
+//////////////////////////////////////////////////////////////////////////
+const int64_t* MapFile::GetSpawnTable( MapSpawnTable table ) const
+{
+	return reinterpret_cast<const int64_t*>(m_view + GetHeader().m_spawnTableOffsets[table]);
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool MapFile::IsHeaderValid() const
+{
+	//sizes and offsets only, so opening never reads the chunks, type bytes and spawn entries are range checked where they are read
+	const MapFileHeader& header = GetHeader();
+	if( header.m_magic != MAP_FILE_MAGIC || header.m_version != MAP_FILE_VERSION || header.m_headerSize != sizeof( MapFileHeader ) )
+		return false;
+	if( header.m_chunkRecordSize != sizeof( TileChunk ) || header.m_chunkSizeLog2 != TILE_CHUNK_SIZE_LOG2 || header.m_numTileTypes != NUM_TILE_TYPE )
+		return false;
+	if( header.m_dimensionX <= 0 || header.m_dimensionY <= 0 || header.m_fileSize != m_viewSize )
+		return false;
+	if( header.m_chunkDimensionX != (header.m_dimensionX + TILE_CHUNK_SIZE - 1) >> TILE_CHUNK_SIZE_LOG2
+		|| header.m_chunkDimensionY != (header.m_dimensionY + TILE_CHUNK_SIZE - 1) >> TILE_CHUNK_SIZE_LOG2 )
+		return false;
+	uint64_t numChunks = (uint64_t)header.m_chunkDimensionX * (uint64_t)header.m_chunkDimensionY;
+	if( header.m_chunksOffset % alignof(TileChunk) != 0 || header.m_chunksOffset + numChunks * sizeof( TileChunk ) > m_viewSize )
+		return false;
+	uint64_t numTiles = (uint64_t)header.m_dimensionX * (uint64_t)header.m_dimensionY;
+	for( int tableID = 0; tableID < (int)NUM_MAP_SPAWN_TABLES; tableID++ )
+	{
+		if( header.m_spawnTableOffsets[tableID] % alignof(int64_t) != 0 || header.m_spawnTableSizes[tableID] > numTiles )
+			return false;
+		if( header.m_spawnTableOffsets[tableID] + header.m_spawnTableSizes[tableID] * sizeof( int64_t ) > m_viewSize )
+			return false;
+	}
+	return true;
+}
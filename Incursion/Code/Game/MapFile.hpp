@@ -0,0 +1,78 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include "Game/TileStorage.hpp"
+
+//"INCM" read as a little endian uint32
+constexpr uint32_t MAP_FILE_MAGIC = 0x4D434E49;
+//bump whenever the layout of the header, a chunk record or a table changes
+constexpr uint32_t MAP_FILE_VERSION = 3;
+//chunk records and tables start on their own pages, so paging in a chunk never pulls in the header
+constexpr uint64_t MAP_FILE_SECTION_ALIGNMENT = 4096;
+
+//tiles listed per spawn table, entries are 64 bit tile indices
+enum MapSpawnTable : uint32_t
+{
+	MAP_SPAWN_TABLE_ENEMY,
+
+	NUM_MAP_SPAWN_TABLES
+};
+
+//////////////////////////////////////////////////////////////////////////
+//at offset 0 of every map file, offsets are bytes from the start of the file, everything is little endian
+//chunk records follow in TileStorage chunk order, each one a TileChunk as it is laid out in memory
+struct MapFileHeader
+{
+	uint32_t m_magic = MAP_FILE_MAGIC;
+	uint32_t m_version = MAP_FILE_VERSION;
+	uint32_t m_headerSize = 0;
+	uint32_t m_chunkRecordSize = 0;
+	uint32_t m_chunkSizeLog2 = 0;
+	uint32_t m_numTileTypes = 0;
+	int32_t  m_dimensionX = 0;
+	int32_t  m_dimensionY = 0;
+	int32_t  m_chunkDimensionX = 0;
+	int32_t  m_chunkDimensionY = 0;
+	uint64_t m_chunksOffset = 0;
+	uint64_t m_spawnTableOffsets[NUM_MAP_SPAWN_TABLES] = {};
+	uint64_t m_spawnTableSizes[NUM_MAP_SPAWN_TABLES] = {};
+	uint64_t m_fileSize = 0;
+	//MapGenerationParams hash of a cached generated map, 0 for authored maps
+	uint64_t m_generationHash = 0;
+};
+
+//////////////////////////////////////////////////////////////////////////
+//read only memory mapping of one map file, opening it only validates the header
+//pages are brought in by the OS the first time a chunk or table entry is read
+class MapFile
+{
+public:
+	MapFile() = default;
+	~MapFile();
+	MapFile( const MapFile& ) = delete;
+	MapFile& operator=( const MapFile& ) = delete;
+
+	//false when the file is missing or was written by another version or tile set
+	bool Open( const std::string& filePath );
+	void Close();
+	bool IsOpen() const { return m_view != nullptr; }
+
+	//tile types, solid neighbor masks, clearances and solid counts, stored per chunk
+	static bool Write( const std::string& filePath, const TileStorage& tiles, uint64_t generationHash = 0 );
+
+	const MapFileHeader& GetHeader() const { return *reinterpret_cast<const MapFileHeader*>(m_view); }
+	IntVec2 GetDimensions() const { return IntVec2( GetHeader().m_dimensionX, GetHeader().m_dimensionY ); }
+	const TileChunk* GetChunks() const;
+	const int64_t* GetSpawnTable( MapSpawnTable table ) const;
+	int64_t GetSpawnTableSize( MapSpawnTable table ) const { return (int64_t)GetHeader().m_spawnTableSizes[table]; }
+
+private:
+	//platform handles, kept opaque so only MapFile.cpp sees windows.h
+	void* m_fileHandle = nullptr;
+	void* m_mappingHandle = nullptr;
+	const unsigned char* m_view = nullptr;
+	uint64_t m_viewSize = 0;
+
+	bool IsHeaderValid() const;
+};
@@ -0,0 +1,108 @@
+#include "Game/MapGenerationParams.hpp"
+#include "Engine/Core/StringUtils.hpp"
+#include "Engine/Core/ErrorWarningAssert.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+//////////////////////////////////////////////////////////////////////////
+//FNV-1a over one value at a time, members are fed one by one so padding never reaches the hash
+static void HashValue( uint64_t& hash, uint64_t value )
+{
+	for( int byteID = 0; byteID < 8; byteID++ )
+	{
+		hash ^= (value >> (byteID * 8)) & 0xFF;
+		hash *= 0x100000001B3ull;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+MapGenerationParams::MapGenerationParams( uint32_t seed, const IntVec2& size, TileType defaultTile, TileType edgeTile, TileType startTile, TileType endTile )
+	:m_seed(seed)
+	,m_size(size)
+	,m_defaultTile(defaultTile)
+	,m_edgeTile(edgeTile)
+	,m_startTile(startTile)
+	,m_endTile(endTile)
+{
+}
+
+//////////////////////////////////////////////////////////////////////////
+uint64_t MapGenerationParams::GetHash() const
+{
+	uint64_t hash = 0xCBF29CE484222325ull;
+	HashValue( hash, MAP_GENERATOR_VERSION );
+	HashValue( hash, NUM_TILE_TYPE );
+	HashValue( hash, m_seed );
+	HashValue( hash, (uint64_t)(int64_t)m_size.x );
+	HashValue( hash, (uint64_t)(int64_t)m_size.y );
+	HashValue( hash, m_defaultTile );
+	HashValue( hash, m_edgeTile );
+	HashValue( hash, m_startTile );
+	HashValue( hash, m_endTile );
+	HashValue( hash, m_wormDefs.size() );
+	for( const WormDefinition& wormDef : m_wormDefs )
+	{
+		HashValue( hash, wormDef.wormTile );
+		HashValue( hash, (uint64_t)(int64_t)wormDef.numWorms );
+		HashValue( hash, (uint64_t)(int64_t)wormDef.wormLength );
+	}
+	return hash;
+}
+
+//////////////////////////////////////////////////////////////////////////
+std::string MapGenerationParams::GetCacheFilePath() const
+{
+	return Stringf( "%s/%016llx.incmap", MAP_CACHE_DIRECTORY, (unsigned long long)GetHash() );
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool ReadSavedMapSeed( uint32_t& out_seed )
+{
+	std::ifstream file( MAP_CACHE_SEED_FILE_PATH );
+	unsigned long long seed = 0;
+	if( !(file >> seed) || seed > 0xFFFFFFFFull )
+		return false;
+	out_seed = (uint32_t)seed;
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void SaveMapSeed( uint32_t seed )
+{
+	std::error_code directoryError;
+	std::filesystem::create_directories( MAP_CACHE_DIRECTORY, directoryError );
+	std::ofstream file( MAP_CACHE_SEED_FILE_PATH, std::ios::trunc );
+	file << seed << "\n";
+	if( !file.good() )
+		DebuggerPrintf( "Could not save map seed to %s\n", MAP_CACHE_SEED_FILE_PATH );
+}
+
+//////////////////////////////////////////////////////////////////////////
+void PruneMapCache( const std::vector<std::string>& keptFilePaths )
+{
+	std::error_code error;
+	//every cached map sits directly in the cache directory, so file names are enough to compare
+	std::vector<std::filesystem::path> keptFileNames;
+	for( const std::string& keptFilePath : keptFilePaths )
+	{
+		keptFileNames.push_back( std::filesystem::path( keptFilePath ).filename() );
+	}
+	//collected first so removing files does not disturb the directory walk
+	std::vector<std::filesystem::path> staleFilePaths;
+	for( std::filesystem::directory_iterator entry( MAP_CACHE_DIRECTORY, error ), end; !error && entry != end; entry.increment( error ) )
+	{
+		const std::filesystem::path& filePath = entry->path();
+		if( filePath.extension() != ".incmap" )
+			continue;
+		if( std::find( keptFileNames.begin(), keptFileNames.end(), filePath.filename() ) != keptFileNames.end() )
+			continue;
+		staleFilePaths.push_back( filePath );
+	}
+	for( const std::filesystem::path& staleFilePath : staleFilePaths )
+	{
+		std::error_code removeError;
+		if( std::filesystem::remove( staleFilePath, removeError ) )
+			DebuggerPrintf( "Removed stale map cache file %s\n", staleFilePath.string().c_str() );
+	}
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include "Engine/Math/IntVec2.hpp"
+#include "Game/Tile.hpp"
+#include "Game/WormDefinition.hpp"
+
+//bump whenever the generator or the tile definitions change, so maps cached by the old code are not reused
+constexpr uint32_t MAP_GENERATOR_VERSION = 1;
+constexpr const char* MAP_CACHE_DIRECTORY = "Data/MapCache";
+//the seed rolled on the first launch without a mapSeed in GameConfig, reused by later launches so their maps come from the cache
+constexpr const char* MAP_CACHE_SEED_FILE_PATH = "Data/MapCache/seed.txt";
+
+//////////////////////////////////////////////////////////////////////////
+//everything a generated map depends on, the same parameters always generate the same tiles
+struct MapGenerationParams
+{
+	uint32_t m_seed = 0;
+	IntVec2  m_size;
+	TileType m_defaultTile = TILE_TYPE_GRASS;
+	TileType m_edgeTile = TILE_TYPE_STONE;
+	TileType m_startTile = TILE_TYPE_GROUND;
+	TileType m_endTile = TILE_TYPE_GROUND;
+	std::vector<WormDefinition> m_wormDefs;
+
+	explicit MapGenerationParams( uint32_t seed, const IntVec2& size, TileType defaultTile, TileType edgeTile, TileType startTile, TileType endTile );
+
+	//also seeds the generator, so two levels sharing a seed still differ
+	uint64_t    GetHash() const;
+	std::string GetCacheFilePath() const;
+};
+
+//false when no seed was saved yet or the file does not hold one
+bool ReadSavedMapSeed( uint32_t& out_seed );
+void SaveMapSeed( uint32_t seed );
+//deletes every cached map that is not one of keptFilePaths, so changing the seed or the generator does not pile up files
+void PruneMapCache( const std::vector<std::string>& keptFilePaths );
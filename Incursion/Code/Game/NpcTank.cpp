@@ -1,13 +1,13 @@
 #include "Game/NpcTank.hpp"
 #include "Game/GameCommon.hpp"
 #include "Game/Game.hpp"
+#include "Game/RenderSnapshot.hpp"
+#include "Game/SimulationThread.hpp"
 #include "Engine/Math/MathUtils.hpp"
 #include "Engine/Math/RandomNumberGenerator.hpp"
 #include "Engine/Math/AABB2.hpp"
 #include "Engine/Core/Vertex_PCU.hpp"
 #include "Engine/Renderer/RenderContext.hpp"
-#include "Engine/Renderer/Texture.hpp"
-#include "Engine/Audio/AudioSystem.hpp"
 
 //////////////////////////////////////////////////////////////////////////
 NpcTank::NpcTank( Map* map, const Vec2& startPos, EntityFaction faction, EntityType type )
@@ -20,6 +20,7 @@ NpcTank::NpcTank( Map* map, const Vec2& startPos, EntityFaction faction, EntityT
 	m_pushesEntities = true;
 	m_isPushedByEntities = true;
 	m_isHitByBullets = true;
+	m_avoidsEntities = true;
 
 	m_physicsRadius = NPC_TANK_PHYSICS_RADIUS;
 	m_cosmeticRadius = NPC_TANK_COSMETIC_RADIUS;
@@ -31,25 +32,26 @@ NpcTank::NpcTank( Map* map, const Vec2& startPos, EntityFaction faction, EntityT
 }
 
 //////////////////////////////////////////////////////////////////////////
-void NpcTank::Update( float deltaSeconds )
+void NpcTank::Think()
 {
 	if( !IsAlive() )
 		return;
 
 	//check if see enemy
-	Entity* visibleEnemy = m_theMap->RaycastForEnemyFaction( m_faction, m_position, NPC_TANK_DETECT_LENGTH );
+	Entity* visibleEnemy = m_theMap->GetNearestVisibleEnemy( m_faction, m_position, NPC_TANK_DETECT_LENGTH );
+	m_isEnemyVisible = visibleEnemy != nullptr;
 	if( visibleEnemy!=nullptr )//can see enemy
 	{
 		m_goalPosReached = false;
 		m_goalAngleReached = true;
 		m_goalPos = visibleEnemy->m_position;
-		CheckToShoot(deltaSeconds);		
 	}
 	else //can't see enemy
 	{
 		//check if see pickup
 		EntityFaction oppoFaction = m_faction == FACTION_GOOD ? FACTION_EVIL : FACTION_GOOD;
-		Entity* visiblePickup = m_theMap->RaycastForEnemyType( oppoFaction, ENTITY_TYPE_PICKUP, m_position, NPC_TANK_DETECT_LENGTH );
+		EntityFilter pickupFilter( GetEntityTypeMask( ENTITY_TYPE_PICKUP ), oppoFaction, true );
+		Entity* visiblePickup = m_theMap->GetNearestVisibleEntity( pickupFilter, m_position, NPC_TANK_DETECT_LENGTH );
 		if( visiblePickup != nullptr )
 		{
 			m_goalPosReached = false;
@@ -61,6 +63,7 @@ void NpcTank::Update( float deltaSeconds )
 	//move toward goal position
 	if( !m_goalPosReached )
 	{
+		UpdatePathToGoal();
 		UpdateForGoalPosNotReached();
 	}
 	//Revise orientation to avoid prolonged collision with solid tiles
@@ -68,6 +71,15 @@ void NpcTank::Update( float deltaSeconds )
 	{
 		UpdateWhiskerDetection();
 	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+void NpcTank::UpdateSteering( float deltaSeconds )
+{
+	if( !IsAlive() )
+		return;
+
+	//perception and goals come from the last Think, steering runs every frame
 	//no goal position, turn to randomized goal orientation
 	if(m_goalPosReached)
 	{
@@ -82,47 +94,45 @@ void NpcTank::Update( float deltaSeconds )
 	//set velocity
 	float deltaDegreesToGoal = m_goalOrientation - m_orientationDegrees;
 	if( deltaDegreesToGoal > NPC_TANK_FORWARD_DEGREES || deltaDegreesToGoal < -NPC_TANK_FORWARD_DEGREES )
-		m_velocity = .4f * m_speedLimit * Vec2::MakeFromPolarDegrees( m_orientationDegrees );
-	else m_velocity = m_speedLimit * Vec2::MakeFromPolarDegrees( m_orientationDegrees );
-	//update
-	Entity::Update( deltaSeconds );
+		m_desiredVelocity = .4f * m_speedLimit * Vec2::MakeFromPolarDegrees( m_orientationDegrees );
+	else m_desiredVelocity = m_speedLimit * Vec2::MakeFromPolarDegrees( m_orientationDegrees );
 }
 
 //////////////////////////////////////////////////////////////////////////
-void NpcTank::Render() const
-{	
-	Texture* tankTexture =nullptr;
-	if( m_faction == FACTION_EVIL )
-		tankTexture = g_theRenderer->CreateOrGetTextureFromFile( "Data/Images/EnemyTank4.png" );
-	else if( m_faction == FACTION_GOOD )
-		tankTexture = g_theRenderer->CreateOrGetTextureFromFile( "Data/Images/FriendlyTank4.png" );
-	g_theRenderer->BindDiffuseTexture( tankTexture );
-	Entity::Render();
+void NpcTank::Update( float deltaSeconds )
+{
+	if( !IsAlive() )
+		return;
 
-	//health bar
-	g_theRenderer->BindDiffuseTexture( (Texture*)nullptr );
-	Vec2 healthBarLeft = m_position + Vec2( -HEALTH_BAR_LENGTH*.5f, m_cosmeticRadius );
-	float healthRate = (float)m_health / (float)NPC_TANK_HEALTH;
-	g_theRenderer->DrawLine2D( healthBarLeft, healthBarLeft + Vec2( HEALTH_BAR_LENGTH*healthRate, 0.f ), 5 * LINE_THICKNESS, Rgba8( 255, 0, 0 ) );
+	if( m_isEnemyVisible )
+	{
+		CheckToShoot( deltaSeconds );
+	}
+	//crowd avoidance has adjusted the steering velocity since UpdateSteering
+	m_velocity = m_desiredVelocity;
+	Entity::Update( deltaSeconds );
 }
 
 //////////////////////////////////////////////////////////////////////////
-void NpcTank::DebugRender() const
+void NpcTank::FillRenderState( EntityRenderState& out_state ) const
 {
-	Entity::DebugRender();
+	Entity::FillRenderState( out_state );
+	out_state.m_hasHealthBar = true;
+	if( !g_isDebugDrawing )
+		return;
 
 	if( !m_goalPosReached )
 	{
-		g_theRenderer->DrawLine2D( m_position, m_goalPos, LINE_THICKNESS, Rgba8( 255, 0, 0 ) );
-		g_theRenderer->DrawDisc2D( m_goalPos, .2f, Rgba8( 255, 0, 0 ) );
+		out_state.m_hasDebugGoal = true;
+		out_state.m_debugGoalPos = m_goalPos;
 	}
 
 	//whiskers
 	Vec2 forward = Vec2::MakeFromPolarDegrees( m_orientationDegrees );
 	Vec2 side = forward.GetRotated90Degrees();
-	g_theRenderer->DrawLine2D( m_position + side * m_physicsRadius, m_leftWhiskerResult.m_impactPos, LINE_THICKNESS, Rgba8::WHITE );
-	g_theRenderer->DrawLine2D( m_position - side * m_physicsRadius, m_rightWhiskerResult.m_impactPos, LINE_THICKNESS, Rgba8::WHITE );
-	g_theRenderer->DrawLine2D( m_position,                          m_centerWhiskerResult.m_impactPos, LINE_THICKNESS, Rgba8::WHITE );
+	out_state.AddDebugLine( m_position + side * m_physicsRadius, m_leftWhiskerResult.m_impactPos, Rgba8::WHITE );
+	out_state.AddDebugLine( m_position - side * m_physicsRadius, m_rightWhiskerResult.m_impactPos, Rgba8::WHITE );
+	out_state.AddDebugLine( m_position,                          m_centerWhiskerResult.m_impactPos, Rgba8::WHITE );
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -130,8 +140,7 @@ void NpcTank::TakeDamage( int damage )
 {
 	Entity::TakeDamage( damage );
 
-	SoundID hitSound = g_theAudio->CreateOrGetSound( "Data/Audio/EnemyHit.wav" );
-	g_theAudio->PlaySound( hitSound );
+	PostSimulationSound( "Data/Audio/EnemyHit.wav" );
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -144,8 +153,37 @@ void NpcTank::Die()
 	EntityFaction newFaction = GetOppositeFaction();
 	m_theMap->SpawnPickup( newFaction,m_position );
 
-	SoundID dieSound = g_theAudio->CreateOrGetSound( "Data/Audio/EnemyDied.wav" );
-	g_theAudio->PlaySound( dieSound );
+	PostSimulationSound( "Data/Audio/EnemyDied.wav" );
+}
+
+//////////////////////////////////////////////////////////////////////////
+void NpcTank::UpdatePathToGoal()
+{
+	//a goal in sight is driven at directly, one behind walls over the map path
+	if( m_theMap->HasLineOfSight( m_position, m_goalPos, NPC_TANK_DETECT_LENGTH ) )
+	{
+		m_pathWaypoints.clear();
+		m_isPathQueried = false;
+		return;
+	}
+	IntVec2 goalCoords = m_theMap->GetTileCoordsForPosition( m_goalPos );
+	if( !m_isPathQueried || goalCoords != m_pathGoalCoords )
+	{
+		//an unreachable goal is asked for once, not every think
+		m_isPathQueried = true;
+		m_pathGoalCoords = goalCoords;
+		m_pathWaypointIndex = 0;
+		m_theMap->FindPath( m_position, m_goalPos, m_pathWaypoints );
+	}
+	//move on past waypoints that are reached or that a later one in sight makes unnecessary
+	for( int lookaheadID = 0; lookaheadID < NPC_TANK_PATH_LOOKAHEAD && m_pathWaypointIndex + 1 < (int)m_pathWaypoints.size(); lookaheadID++ )
+	{
+		const Vec2& waypoint = m_pathWaypoints[m_pathWaypointIndex];
+		bool isReached = (waypoint - m_position).GetLengthSquared() < m_physicsRadius * m_physicsRadius;
+		if( !isReached && !m_theMap->IsSegmentClearOfSolid( m_position, m_pathWaypoints[m_pathWaypointIndex + 1] ) )
+			break;
+		m_pathWaypointIndex++;
+	}
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -155,6 +193,12 @@ void NpcTank::UpdateForGoalPosNotReached()
 	if( tankToPlayer.GetLength() < m_physicsRadius )
 	{
 		m_goalPosReached = true;
+		m_pathWaypoints.clear();
+		m_isPathQueried = false;
+	}
+	else if( !m_pathWaypoints.empty() )
+	{
+		m_goalOrientation = (m_pathWaypoints[m_pathWaypointIndex] - m_position).GetAngleDegrees();
 	}
 	else
 	{
@@ -167,7 +211,14 @@ void NpcTank::UpdateForGoalPosReached( float deltaSeconds )
 {
 	if( m_resetGoalOrienCountdown <= 0.f )
 	{
-		m_goalOrientation = g_theGame->m_RNG->RollRandomFloatInRange( 0.f, 360.f );
+		//head up the local influence slope, toward enemies and pickups, or away from enemies once hurt
+		float threatWeight = m_health < m_healthLimit ? NPC_TANK_HURT_THREAT_WEIGHT : NPC_TANK_HUNT_THREAT_WEIGHT;
+		IntVec2 tileCoords = m_theMap->GetTileCoordsForPosition( m_position );
+		Vec2 gradient = m_theMap->GetInfluenceMap().GetGradient( tileCoords, m_faction, threatWeight, 1.f );
+		//nothing in reach, wander
+		if( gradient.GetLengthSquared() > 0.f )
+			m_goalOrientation = gradient.GetAngleDegrees();
+		else m_goalOrientation = g_theGame->m_RNG->RollRandomFloatInRange( 0.f, 360.f );
 		m_resetGoalOrienCountdown = NPC_TANK_TURN_COUNTDOWN;
 	}
 	else m_resetGoalOrienCountdown -= deltaSeconds;
@@ -266,6 +317,5 @@ void NpcTank::ShootBullet()
 	else if( m_faction == FACTION_GOOD )
 		m_theMap->SpawnBullet( ENTITY_TYPE_GOOD_BULLET, m_faction, spawnPos, m_orientationDegrees );
 
-	SoundID shootSound = g_theAudio->CreateOrGetSound( "Data/Audio/EnemyShoot.wav" );
-	g_theAudio->PlaySound( shootSound );
+	PostSimulationSound( "Data/Audio/EnemyShoot.wav" );
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <vector>
 #include "Game/Entity.hpp"
 #include "Game/Map.hpp"
 
@@ -11,9 +12,10 @@ class NpcTank : public Entity
 public:
 	NpcTank( Map* map, const Vec2& startPos, EntityFaction faction, EntityType type );
 	
+	virtual void Think() override;
+	virtual void UpdateSteering( float deltaSeconds ) override;
 	virtual void Update( float deltaSeconds ) override;
-	virtual void Render() const override;
-	virtual void DebugRender() const override;
+	virtual void FillRenderState( EntityRenderState& out_state ) const override;
 	virtual void TakeDamage( int damage )override;
 	virtual void Die() override;
 
@@ -23,11 +25,18 @@ private:
 	float m_goalOrientation = 0.f;
 	bool  m_goalPosReached = true;
 	bool  m_goalAngleReached = true;
+	bool  m_isEnemyVisible = false;
 	Vec2  m_goalPos;
+	//path to m_goalPos while it is out of sight, m_pathGoalCoords is the goal tile it was found for
+	std::vector<Vec2> m_pathWaypoints;
+	int     m_pathWaypointIndex = 0;
+	bool    m_isPathQueried = false;
+	IntVec2 m_pathGoalCoords;
 	RaycastResult m_leftWhiskerResult;
 	RaycastResult m_centerWhiskerResult;
 	RaycastResult m_rightWhiskerResult;
 
+	void UpdatePathToGoal();
 	void UpdateForGoalPosNotReached();
 	void UpdateForGoalPosReached(float deltaSeconds);
 	void UpdateWhiskerDetection();
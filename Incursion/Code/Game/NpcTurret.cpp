@@ -1,10 +1,11 @@
 #include "Game/NpcTurret.hpp"
 #include "Game/Map.hpp"
 #include "Game/GameCommon.hpp"
+#include "Game/RenderSnapshot.hpp"
+#include "Game/SimulationThread.hpp"
 #include "Engine/Renderer/RenderContext.hpp"
 #include "Engine/Math/MathUtils.hpp"
 #include "Engine/Math/AABB2.hpp"
-#include "Engine/Audio/AudioSystem.hpp"
 
 //////////////////////////////////////////////////////////////////////////
 NpcTurret::NpcTurret( Map* map, const Vec2& startPos, EntityFaction faction, EntityType type )
@@ -25,19 +26,43 @@ NpcTurret::NpcTurret( Map* map, const Vec2& startPos, EntityFaction faction, Ent
 }
 
 //////////////////////////////////////////////////////////////////////////
-void NpcTurret::Update( float deltaSeconds )
+void NpcTurret::Think()
 {
 	if( !IsAlive() )
 		return;
 
 	// can see anti-faction enemy
-	Entity* visibleEnemy = m_theMap->RaycastForEnemyFaction(m_faction,m_position,NPC_TURRET_DETECT_LENGTH);
-	if(visibleEnemy!=nullptr )
+	Entity* visibleEnemy = m_theMap->GetNearestVisibleEnemy( m_faction, m_position, NPC_TURRET_DETECT_LENGTH );
+	m_isEnemyVisible = visibleEnemy != nullptr;
+	if( visibleEnemy != nullptr )
 	{
 		m_enemySeen = true;
 		m_angularVelocity = 0.f;
 		m_impactedPos = visibleEnemy->m_position;
 		m_lastEnemySeenDegrees = (m_impactedPos - m_position).GetAngleDegrees();
+	}
+	// can't see player, laser follows the scan
+	else
+	{
+		Vec2 forward = Vec2::MakeFromPolarDegrees( m_orientationDegrees );
+		RaycastResult result = m_theMap->Raycast( m_position, forward, NPC_TURRET_DETECT_LENGTH );
+		m_impactedPos = result.m_impactPos;
+		//the laser also stops at the first tank or boulder in front of the wall
+		EntityTypeMask blockerMask = GetEntityTypeMask( ENTITY_TYPE_PLAYER ) | GetEntityTypeMask( ENTITY_TYPE_NPC_TANK ) | GetEntityTypeMask( ENTITY_TYPE_BOULDER );
+		float blockerDist = 0.f;
+		if( m_theMap->RaycastEntities( m_position, forward, result.m_impactDist, EntityFilter( blockerMask ), &blockerDist ) != nullptr )
+			m_impactedPos = m_position + forward * blockerDist;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+void NpcTurret::Update( float deltaSeconds )
+{
+	if( !IsAlive() )
+		return;
+
+	if( m_isEnemyVisible )
+	{
 		m_orientationDegrees = GetTurnedToward( m_orientationDegrees, m_lastEnemySeenDegrees, NPC_TURRET_TURN_SPEED * deltaSeconds );
 		//shoot
 		if( m_lastEnemySeenDegrees - m_orientationDegrees > -NPC_TURRET_SHOOT_DEGREES && 
@@ -64,48 +89,22 @@ void NpcTurret::Update( float deltaSeconds )
 		{			
 			m_angularVelocity = -NPC_TURRET_TURN_SPEED;
 		}
-		Vec2 forward = Vec2::MakeFromPolarDegrees( m_orientationDegrees );
-		RaycastResult result = m_theMap->Raycast( m_position, forward, NPC_TURRET_DETECT_LENGTH );
-		m_impactedPos = result.m_impactPos;
 	}
 
 	Entity::Update( deltaSeconds );
 }
 
 //////////////////////////////////////////////////////////////////////////
-void NpcTurret::Render() const
+void NpcTurret::FillRenderState( EntityRenderState& out_state ) const
 {
-	//draw base
-	Texture* baseTexture = nullptr;
-	if( m_faction == FACTION_EVIL )
-		baseTexture = g_theRenderer->CreateOrGetTextureFromFile( "Data/Images/EnemyTurretBase.png" );
-	else if( m_faction == FACTION_GOOD )
-		baseTexture = g_theRenderer->CreateOrGetTextureFromFile( "Data/Images/FriendlyTurretBase.png" );
-	g_theRenderer->BindDiffuseTexture( baseTexture );
-
-	std::vector<Vertex_PCU> baseVerts = m_verts;
-	TransformVertexArray( (int)baseVerts.size(), &baseVerts[0], 1.f, 0.f, m_position );
-	g_theRenderer->DrawVertexArray( baseVerts );
-
-	//draw laser
-	g_theRenderer->BindDiffuseTexture( (Texture*)nullptr );
-	g_theRenderer->DrawLine2D( m_position, m_impactedPos, LINE_THICKNESS, Rgba8( 255, 0, 0 ) );
-
-	//draw turret
-	Texture* topTexture = nullptr;
-	if(m_faction==FACTION_EVIL )
-		topTexture = g_theRenderer->CreateOrGetTextureFromFile( "Data/Images/EnemyTurretTop.png" );
-	else if(m_faction==FACTION_GOOD )
-		topTexture = g_theRenderer->CreateOrGetTextureFromFile( "Data/Images/FriendlyTurretTop.png" );
-	g_theRenderer->BindDiffuseTexture( topTexture );
-
-	Entity::Render();
-
-	//health bar
-	g_theRenderer->BindDiffuseTexture((Texture*)nullptr );
-	Vec2 healthBarLeft = m_position + Vec2( -HEALTH_BAR_LENGTH * .5f, m_cosmeticRadius );
-	float healthRate = (float)m_health / (float)NPC_TURRET_HEALTH;
-	g_theRenderer->DrawLine2D( healthBarLeft, healthBarLeft + Vec2( HEALTH_BAR_LENGTH * healthRate, 0.f ), 5 * LINE_THICKNESS, Rgba8( 255, 0, 0 ) );
+	Entity::FillRenderState( out_state );
+	//base never rotates, the top follows the turret orientation
+	out_state.m_orientationDegrees = 0.f;
+	out_state.m_hasTopLayer = true;
+	out_state.m_topOrientationDegrees = m_orientationDegrees;
+	out_state.m_hasHealthBar = true;
+	out_state.m_hasLaser = true;
+	out_state.m_laserEnd = m_impactedPos;
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -113,8 +112,7 @@ void NpcTurret::TakeDamage( int damage )
 {
 	Entity::TakeDamage( damage );
 
-	SoundID hitSound = g_theAudio->CreateOrGetSound( "Data/Audio/EnemyHit.wav" );
-	g_theAudio->PlaySound( hitSound );
+	PostSimulationSound( "Data/Audio/EnemyHit.wav" );
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -127,8 +125,7 @@ void NpcTurret::Die()
 	EntityFaction newFaction = GetOppositeFaction();
 	m_theMap->SpawnPickup( newFaction,m_position );
 
-	SoundID dieSound = g_theAudio->CreateOrGetSound( "Data/Audio/EnemyDied.wav" );
-	g_theAudio->PlaySound( dieSound );
+	PostSimulationSound( "Data/Audio/EnemyDied.wav" );
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -140,6 +137,5 @@ void NpcTurret::ShootBullet()
 	else if(m_faction==FACTION_GOOD )
 		m_theMap->SpawnBullet( ENTITY_TYPE_GOOD_BULLET, m_faction, spawnPos, m_orientationDegrees );
 
-	SoundID shootSound = g_theAudio->CreateOrGetSound( "Data/Audio/EnemyShoot.wav" );
-	g_theAudio->PlaySound( shootSound );
+	PostSimulationSound( "Data/Audio/EnemyShoot.wav" );
 }
@@ -11,8 +11,9 @@ public:
 	NpcTurret(Map* map, const Vec2& startPos, EntityFaction faction, EntityType type );
 	~NpcTurret()=default;
 	
+	virtual void Think() override;
 	virtual void Update( float deltaSeconds ) override;
-	virtual void Render() const override;
+	virtual void FillRenderState( EntityRenderState& out_state ) const override;
 	virtual void TakeDamage( int damage )override;
 	virtual void Die() override;
 
@@ -21,6 +22,7 @@ private:
 	Vec2  m_impactedPos;
 	float m_lastEnemySeenDegrees = 0.f;
 	bool  m_enemySeen = false;
+	bool  m_isEnemyVisible = false;
 
 	void ShootBullet();
 };
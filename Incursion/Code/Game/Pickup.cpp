@@ -1,6 +1,6 @@
 #include "Game/Pickup.hpp"
 #include "Game/GameCommon.hpp"
-#include "Engine/Renderer/Texture.hpp"
+#include "Game/Game.hpp"
 #include "Engine/Renderer/RenderContext.hpp"
 #include "Engine/Renderer/SpriteSheet.hpp"
 #include "Engine/Math/AABB2.hpp"
@@ -20,27 +20,18 @@ void Pickup::Startup( PickupType pickupType )
 {
 	m_pickupType = pickupType;
 
-	Texture* texture = g_theRenderer->CreateOrGetTextureFromFile( "Data/Images/Extras_4x4.png" );
-	const SpriteSheet* sheet = new SpriteSheet( *texture, IntVec2( 4, 4 ) );
+	const SpriteSheet& sheet = g_theGame->GetExtrasSpriteSheet();
 	Vec2 uvAtMins, uvAtMaxs;
 	if( m_pickupType == PICKUP_HEALTH )
 	{
-		sheet->GetSpriteUVs( uvAtMins, uvAtMaxs, 11 );
+		sheet.GetSpriteUVs( uvAtMins, uvAtMaxs, 11 );
 	}
 	else if( m_pickupType == PICKUP_FACTION_BOMB )
 	{
-		sheet->GetSpriteUVs( uvAtMins, uvAtMaxs, 13 );
+		sheet.GetSpriteUVs( uvAtMins, uvAtMaxs, 13 );
 	}
 
 	Rgba8 tint = GetFactionColor();
 	AppendVertsForAABB2D( m_verts, AABB2( -m_cosmeticRadius, -m_cosmeticRadius, m_cosmeticRadius, m_cosmeticRadius ),
 		uvAtMins, uvAtMaxs, tint );
 }
-
-//////////////////////////////////////////////////////////////////////////
-void Pickup::Render() const
-{
-	Texture* pickupTexture = g_theRenderer->CreateOrGetTextureFromFile( "Data/Images/Extras_4x4.png" );
-	g_theRenderer->BindDiffuseTexture( pickupTexture );
-	Entity::Render();
-}
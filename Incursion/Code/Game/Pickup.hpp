@@ -17,7 +17,6 @@ public:
 
 	void Startup( PickupType pickupType );
 
-	virtual void Render() const override;
 
 	PickupType m_pickupType = NUM_PICKUP;
 	
@@ -1,14 +1,10 @@
 #include "Game/Player.hpp"
 #include "Game/GameCommon.hpp"
 #include "Game/Map.hpp"
-#include "Engine/Input/InputSystem.hpp"
-#include "Engine/Input/XboxController.hpp"
 #include "Engine/Math/MathUtils.hpp"
 #include "Engine/Math/AABB2.hpp"
 #include "Engine/Core/Vertex_PCU.hpp"
 #include "Engine/Renderer/RenderContext.hpp"
-#include "Engine/Renderer/Texture.hpp"
-#include "Engine/Audio/AudioSystem.hpp"
 
 //////////////////////////////////////////////////////////////////////////
 Player::Player( Map* map, const Vec2& startPos, EntityFaction faction, EntityType type )
@@ -36,13 +32,12 @@ Player::Player( Map* map, const Vec2& startPos, EntityFaction faction, EntityTyp
 //////////////////////////////////////////////////////////////////////////
 void Player::Update( float deltaSeconds )
 {
+	//only the end of a vibration is sent, not a stop every tick
 	if( m_vibrationCounter > 0 )
 	{
 		m_vibrationCounter -= deltaSeconds;
-	}
-	else
-	{
-		g_theInput->SetVibrationValue( m_controllerID, 0, 0 );
+		if( m_vibrationCounter <= 0 )
+			PostSimulationVibration( m_controllerID, 0.f );
 	}
 
 	if( !IsAlive() )
@@ -61,35 +56,19 @@ void Player::Update( float deltaSeconds )
 }
 
 //////////////////////////////////////////////////////////////////////////
-void Player::Render() const
+void Player::FillRenderState( EntityRenderState& out_state ) const
 {
-	//base
-	Texture* baseTank = g_theRenderer->CreateOrGetTextureFromFile( "Data/Images/PlayerTankBase.png" );
-	g_theRenderer->BindDiffuseTexture( baseTank );
-	Entity::Render();
-
-	//turret
-	Texture* turretTank = g_theRenderer->CreateOrGetTextureFromFile( "Data/Images/PlayerTankTop.png" );
-	g_theRenderer->BindDiffuseTexture( turretTank );
-	std::vector<Vertex_PCU> turretVerts = m_verts;
-	TransformVertexArray( (int)turretVerts.size(), &turretVerts[0], 1.f, m_orientationDegrees + m_gunRelativeOrientation, m_position );
-	g_theRenderer->DrawVertexArray( turretVerts );
-
-	//health bar
-	g_theRenderer->BindDiffuseTexture((Texture*)nullptr );
-	Vec2 healthBarLeft = m_position + Vec2( -HEALTH_BAR_LENGTH * .5f, m_cosmeticRadius );
-	float healthRate = (float)m_health / (float)PLAYER_HEALTH;
-	g_theRenderer->DrawLine2D( healthBarLeft, healthBarLeft + Vec2( HEALTH_BAR_LENGTH * healthRate, 0.f ), 5 * LINE_THICKNESS, Rgba8( 255, 0, 0 ) );
-}
+	Entity::FillRenderState( out_state );
+	out_state.m_hasTopLayer = true;
+	out_state.m_topOrientationDegrees = GetGunAbsoluteDegrees();
+	out_state.m_hasHealthBar = true;
 
-//////////////////////////////////////////////////////////////////////////
-void Player::DebugRender() const
-{
-	Entity::DebugRender();
-
-	Vec2 forward = Vec2::MakeFromPolarDegrees( m_orientationDegrees + m_gunRelativeOrientation );
-	RaycastResult result = m_theMap->Raycast( m_position, forward, 100.f );
-	g_theRenderer->DrawLine2D( m_position, result.m_impactPos, LINE_THICKNESS, Rgba8( 255, 0, 0 ) );
+	if( g_isDebugDrawing )
+	{
+		Vec2 forward = Vec2::MakeFromPolarDegrees( GetGunAbsoluteDegrees() );
+		RaycastResult result = m_theMap->Raycast( m_position, forward, 100.f );
+		out_state.AddDebugLine( m_position, result.m_impactPos, Rgba8( 255, 0, 0 ) );
+	}
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -97,10 +76,9 @@ void Player::TakeDamage( int damage )
 {
 	Entity::TakeDamage( damage );
 
-	SoundID hitSound = g_theAudio->CreateOrGetSound( "Data/Audio/PlayerHit.wav" );
-	g_theAudio->PlaySound( hitSound );
+	PostSimulationSound( "Data/Audio/PlayerHit.wav" );
 
-	g_theInput->SetVibrationValue( m_controllerID, .3f, .3f );
+	PostSimulationVibration( m_controllerID, .3f );
 	m_vibrationCounter = PLAYER_HIT_VIBRATION_TIME;
 }
 
@@ -111,8 +89,7 @@ void Player::Die()
 
 	m_theMap->SpawnExplosion( m_position, 2.f*m_cosmeticRadius, EXPLOSION_MAX_DURATION );
 
-	SoundID dieSound = g_theAudio->CreateOrGetSound( "Data/Audio/PlayerDied.wav" );
-	g_theAudio->PlaySound( dieSound );
+	PostSimulationSound( "Data/Audio/PlayerDied.wav" );
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -121,42 +98,40 @@ void Player::UpdateFromController(float deltaSeconds)
 	if( m_controllerID < 0 )
 		return;
 
-	const XboxController controller = g_theInput->GetXboxController( m_controllerID );
-	if( !controller.IsConnected() )
+	//read from the latest command of the main thread, the input system is not touched here
+	if( !m_inputCommand.m_isControllerConnected )
 		return;
 
 	//movement
-	const AnalogJoystick leftJoystick = controller.GetLeftJoystick();
-	float leftMagnitude = leftJoystick.GetMagnitude();
-	if( leftMagnitude > 0.f )
+	if( m_inputCommand.m_moveMagnitude > 0.f )
 	{
-		m_thrustFraction = leftMagnitude;
-		m_orientationDegrees = GetTurnedToward( m_orientationDegrees, leftJoystick.GetAngleDegrees(), PLAYER_TURN_SPEED * deltaSeconds );
+		m_thrustFraction = m_inputCommand.m_moveMagnitude;
+		m_orientationDegrees = GetTurnedToward( m_orientationDegrees, m_inputCommand.m_moveDegrees, PLAYER_TURN_SPEED * deltaSeconds );
 	}
 
 	//gun movement
-	const AnalogJoystick rightJoystick = controller.GetRightJoystick();
-	float magnitude = rightJoystick.GetMagnitude();
-	if( magnitude > 0.f )
+	if( m_inputCommand.m_aimMagnitude > 0.f )
 	{
 		float turnedAbsolute = GetTurnedToward( m_orientationDegrees + m_gunRelativeOrientation, 
-			rightJoystick.GetAngleDegrees(), PLAYER_GUN_TURN_SPEED * deltaSeconds );
+			m_inputCommand.m_aimDegrees, PLAYER_GUN_TURN_SPEED * deltaSeconds );
 		m_gunRelativeOrientation = turnedAbsolute - m_orientationDegrees;
 	}
 
 	//shoot bullet
-	const KeyButtonState aButton = controller.GetButtonState( XBOX_BUTTON_ID_RSHOULDER );
-	if( aButton.WasJustPressed() )
+	if( m_inputCommand.m_wasShootPressed )
 	{
 		ShootBullet();
 	}
 
 	//shoot bomb
-	const KeyButtonState bButton = controller.GetButtonState( XBOX_BUTTON_ID_LSHOULDER );
-	if( bButton.WasJustPressed() )
+	if( m_inputCommand.m_wasBombPressed )
 	{
 		ShootBomb();
 	}
+
+	//a command is only applied by one tick
+	m_inputCommand.m_wasShootPressed = false;
+	m_inputCommand.m_wasBombPressed = false;
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -166,8 +141,7 @@ void Player::ShootBullet()
 	m_theMap->SpawnBullet( ENTITY_TYPE_GOOD_BULLET, FACTION_GOOD, 
 		m_position + Vec2::MakeFromPolarDegrees(absoluteBulletOrientation, m_cosmeticRadius ), absoluteBulletOrientation );
 	
-	SoundID shootSound = g_theAudio->CreateOrGetSound( "Data/Audio/PlayerShootNormal.ogg" );
-	g_theAudio->PlaySound( shootSound );
+	PostSimulationSound( "Data/Audio/PlayerShootNormal.ogg" );
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -180,8 +154,7 @@ void Player::ShootBomb()
 	m_theMap->SpawnBomb( m_faction,
 		m_position + Vec2::MakeFromPolarDegrees( absoluteBulletOrientation, m_cosmeticRadius ), absoluteBulletOrientation );
 	
-	SoundID shootSound = g_theAudio->CreateOrGetSound( "Data/Audio/PlayerShootNormal.ogg" );
-	g_theAudio->PlaySound( shootSound );
+	PostSimulationSound( "Data/Audio/PlayerShootNormal.ogg" );
 
 	m_factionBombNum--;
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Game/Entity.hpp"
+#include "Game/SimulationThread.hpp"
 
 struct Vec2;
 
@@ -11,18 +12,19 @@ public:
 	~Player() = default;
 
 	virtual void Update( float deltaSeconds ) override;
-	virtual void Render()const override;
-	virtual void DebugRender() const override;
+	virtual void FillRenderState( EntityRenderState& out_state ) const override;
 	virtual void TakeDamage( int damage )override;
 	virtual void Die()override;
 	
 	float GetGunAbsoluteDegrees() const { return m_gunRelativeOrientation + m_orientationDegrees; }
+	void  SetInputCommand( const InputCommand& command ) { m_inputCommand = command; }
 
 private:
 	float m_thrustFraction = 0.f;
 	int   m_controllerID = -1;
 	float m_gunRelativeOrientation = 0.f;
 	float m_vibrationCounter = 0.f;
+	InputCommand m_inputCommand;
 
 	void UpdateFromController(float deltaSeconds);
 	void ShootBullet();
@@ -0,0 +1,112 @@
+#include "Game/QuadBatch.hpp"
+#include "Game/FrameArena.hpp"
+#include "Game/GameCommon.hpp"
+#include "Game/JobSystem.hpp"
+#include "Engine/Core/Vertex_PCU.hpp"
+#include "Engine/Core/ErrorWarningAssert.hpp"
+#include "Engine/Core/StringUtils.hpp"
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE__)
+#define QUAD_BATCH_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+constexpr float QUAD_BATCH_DEGREES_TO_RADIANS = 3.14159265f / 180.f;
+
+//////////////////////////////////////////////////////////////////////////
+void TransformQuadInstances( int numInstances, const Vec2* positions, const float* orientationDegrees, const float* scales, const Rgba8* tints,
+	int numQuadVerts, const Vertex_PCU* quadVerts, Vertex_PCU* out_verts )
+{
+	//shared quad as structure of arrays, padded to a multiple of 4
+	alignas(16) float localX[MAX_QUAD_BATCH_VERTS] = {};
+	alignas(16) float localY[MAX_QUAD_BATCH_VERTS] = {};
+	for( int vID = 0; vID < numQuadVerts; vID++ )
+	{
+		localX[vID] = quadVerts[vID].m_position.x;
+		localY[vID] = quadVerts[vID].m_position.y;
+	}
+
+	alignas(16) float worldX[MAX_QUAD_BATCH_VERTS];
+	alignas(16) float worldY[MAX_QUAD_BATCH_VERTS];
+	for( int iID = 0; iID < numInstances; iID++ )
+	{
+		float radians = orientationDegrees[iID] * QUAD_BATCH_DEGREES_TO_RADIANS;
+		float scaledCos = scales[iID] * cosf( radians );
+		float scaledSin = scales[iID] * sinf( radians );
+		const Vec2& translation = positions[iID];
+
+#if defined(QUAD_BATCH_USE_SSE)
+		__m128 cosValues = _mm_set1_ps( scaledCos );
+		__m128 sinValues = _mm_set1_ps( scaledSin );
+		__m128 translationX = _mm_set1_ps( translation.x );
+		__m128 translationY = _mm_set1_ps( translation.y );
+		for( int vID = 0; vID < numQuadVerts; vID += 4 )
+		{
+			__m128 x = _mm_load_ps( localX + vID );
+			__m128 y = _mm_load_ps( localY + vID );
+			__m128 rotatedX = _mm_sub_ps( _mm_mul_ps( cosValues, x ), _mm_mul_ps( sinValues, y ) );
+			__m128 rotatedY = _mm_add_ps( _mm_mul_ps( sinValues, x ), _mm_mul_ps( cosValues, y ) );
+			_mm_store_ps( worldX + vID, _mm_add_ps( rotatedX, translationX ) );
+			_mm_store_ps( worldY + vID, _mm_add_ps( rotatedY, translationY ) );
+		}
+#else
+		for( int vID = 0; vID < numQuadVerts; vID++ )
+		{
+			worldX[vID] = scaledCos * localX[vID] - scaledSin * localY[vID] + translation.x;
+			worldY[vID] = scaledSin * localX[vID] + scaledCos * localY[vID] + translation.y;
+		}
+#endif
+
+		Vertex_PCU* instanceVerts = out_verts + iID * numQuadVerts;
+		for( int vID = 0; vID < numQuadVerts; vID++ )
+		{
+			Vertex_PCU& vert = instanceVerts[vID];
+			vert.m_position.x = worldX[vID];
+			vert.m_position.y = worldY[vID];
+			vert.m_position.z = quadVerts[vID].m_position.z;
+			vert.m_color = tints[iID];
+			vert.m_uvTexCoords = quadVerts[vID].m_uvTexCoords;
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+void QuadBatch::Clear()
+{
+	m_positions.clear();
+	m_orientations.clear();
+	m_scales.clear();
+	m_tints.clear();
+}
+
+//////////////////////////////////////////////////////////////////////////
+void QuadBatch::AddInstance( const Vec2& position, float orientationDegrees, float scale, const Rgba8& tint )
+{
+	m_positions.push_back( position );
+	m_orientations.push_back( orientationDegrees );
+	m_scales.push_back( scale );
+	m_tints.push_back( tint );
+}
+
+//////////////////////////////////////////////////////////////////////////
+VertexSpan QuadBatch::GetTransformedVerts( int numQuadVerts, const Vertex_PCU* quadVerts ) const
+{
+	//dropping the extra verts would silently cut the mesh
+	if( numQuadVerts > MAX_QUAD_BATCH_VERTS )
+		ERROR_AND_DIE( Stringf( "Quad batch mesh has %d verts, at most %d fit", numQuadVerts, MAX_QUAD_BATCH_VERTS ) );
+	int numInstances = GetNumInstances();
+	if( numInstances == 0 || numQuadVerts == 0 )
+		return VertexSpan();
+
+	//write straight into this frame's vertex memory
+	VertexSpan span = AllocateFrameVerts( numInstances * numQuadVerts );
+	//instances write disjoint vertex ranges, big batches are split across the job system
+	g_theJobSystem->ParallelFor( numInstances, QUAD_BATCH_GRAIN_SIZE, [&]( int beginInstance, int endInstance )
+	{
+		TransformQuadInstances( endInstance - beginInstance, &m_positions[beginInstance], &m_orientations[beginInstance], &m_scales[beginInstance],
+			&m_tints[beginInstance], numQuadVerts, quadVerts, span.m_verts + beginInstance * numQuadVerts );
+	} );
+	span.m_size = span.m_capacity;
+	return span;
+}
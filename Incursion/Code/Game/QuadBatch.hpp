@@ -0,0 +1,32 @@
+#pragma once
+
+#include <vector>
+#include "Engine/Math/Vec2.hpp"
+#include "Engine/Core/Rgba8.hpp"
+
+struct Vertex_PCU;
+struct VertexSpan;
+
+//transform numInstances copies of the shared quad verts into out_verts( numInstances * numQuadVerts long ), numQuadVerts is at most MAX_QUAD_BATCH_VERTS
+//sin/cos is computed once per instance, the vertices of each instance are transformed 4 at a time with SIMD
+void TransformQuadInstances( int numInstances, const Vec2* positions, const float* orientationDegrees, const float* scales, const Rgba8* tints,
+	int numQuadVerts, const Vertex_PCU* quadVerts, Vertex_PCU* out_verts );
+
+class QuadBatch
+{
+public:
+	QuadBatch() = default;
+	~QuadBatch() = default;
+
+	void Clear();
+	void AddInstance( const Vec2& position, float orientationDegrees, float scale, const Rgba8& tint );
+	VertexSpan GetTransformedVerts( int numQuadVerts, const Vertex_PCU* quadVerts ) const;
+
+	int GetNumInstances() const { return (int)m_positions.size(); }
+
+private:
+	std::vector<Vec2>  m_positions;
+	std::vector<float> m_orientations;
+	std::vector<float> m_scales;
+	std::vector<Rgba8> m_tints;
+};
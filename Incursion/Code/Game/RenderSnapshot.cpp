@@ -0,0 +1,43 @@
+#include "Game/RenderSnapshot.hpp"
+
+//////////////////////////////////////////////////////////////////////////
+void EntityRenderState::SetVerts( const std::vector<Vertex_PCU>& verts )
+{
+	m_numVerts = (int)verts.size();
+	if( m_numVerts > MAX_ENTITY_RENDER_VERTS )
+		m_numVerts = MAX_ENTITY_RENDER_VERTS;
+	for( int vID = 0; vID < m_numVerts; vID++ )
+	{
+		m_verts[vID] = verts[vID];
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+void EntityRenderState::AddDebugLine( const Vec2& start, const Vec2& end, const Rgba8& color )
+{
+	if( m_numDebugLines >= MAX_ENTITY_DEBUG_LINES )
+		return;
+	m_debugLineStarts[m_numDebugLines] = start;
+	m_debugLineEnds[m_numDebugLines] = end;
+	m_debugLineColors[m_numDebugLines] = color;
+	m_numDebugLines++;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void RenderSnapshotBuffer::Publish()
+{
+	int previousShared = m_sharedIndex.exchange( m_writeIndex | NEW_SNAPSHOT_BIT, std::memory_order_acq_rel );
+	m_writeIndex = previousShared & SNAPSHOT_INDEX_MASK;
+	m_hasPublished.store( true, std::memory_order_release );
+}
+
+//////////////////////////////////////////////////////////////////////////
+const RenderSnapshot& RenderSnapshotBuffer::AcquireLatest()
+{
+	if( (m_sharedIndex.load( std::memory_order_relaxed ) & NEW_SNAPSHOT_BIT) != 0 )
+	{
+		int previousShared = m_sharedIndex.exchange( m_readIndex, std::memory_order_acq_rel );
+		m_readIndex = previousShared & SNAPSHOT_INDEX_MASK;
+	}
+	return m_snapshots[m_readIndex];
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include "Game/Entity.hpp"
+#include "Game/GameCommon.hpp"
+#include "Game/Tile.hpp"
+#include "Game/VisibilityField.hpp"
+#include "Engine/Math/IntVec2.hpp"
+#include "Engine/Math/Vec2.hpp"
+#include "Engine/Core/Rgba8.hpp"
+#include "Engine/Core/Vertex_PCU.hpp"
+
+//////////////////////////////////////////////////////////////////////////
+//everything the renderer needs from one entity, copied out of the simulation at the end of a tick
+struct EntityRenderState
+{
+	EntityType    m_type = NUM_ENTITY_TYPES;
+	EntityFaction m_faction = NUM_FACTIONS;
+	Vec2  m_position;
+	Vec2  m_velocity;
+	float m_orientationDegrees = 0.f;
+	float m_physicsRadius = 0.f;
+	float m_cosmeticRadius = 0.f;
+	//local space verts with this tick's tint and uvs
+	int   m_numVerts = 0;
+	Vertex_PCU m_verts[MAX_ENTITY_RENDER_VERTS];
+	//player gun and turret top, drawn with the same verts
+	bool  m_hasTopLayer = false;
+	float m_topOrientationDegrees = 0.f;
+	bool  m_hasHealthBar = false;
+	float m_healthFraction = 1.f;
+	bool  m_hasLaser = false;
+	Vec2  m_laserEnd;
+	//only filled while debug drawing
+	int   m_numDebugLines = 0;
+	Vec2  m_debugLineStarts[MAX_ENTITY_DEBUG_LINES];
+	Vec2  m_debugLineEnds[MAX_ENTITY_DEBUG_LINES];
+	Rgba8 m_debugLineColors[MAX_ENTITY_DEBUG_LINES];
+	bool  m_hasDebugGoal = false;
+	Vec2  m_debugGoalPos;
+
+	void SetVerts( const std::vector<Vertex_PCU>& verts );
+	void AddDebugLine( const Vec2& start, const Vec2& end, const Rgba8& color );
+};
+
+//////////////////////////////////////////////////////////////////////////
+//immutable picture of the world after one simulation tick, the render thread never touches live entities
+struct RenderSnapshot
+{
+	//sorted by type, entities of type t are in [m_firstEntityOfType[t], m_firstEntityOfType[t+1])
+	std::vector<EntityRenderState> m_entities;
+	int m_firstEntityOfType[NUM_ENTITY_TYPES + 1] = {};
+
+	//tiles of the window around the player, row by row, shared with the map until its tiles change or the window moves
+	//the version is unique across maps
+	std::shared_ptr<const std::vector<TileType>> m_tileTypes;
+	IntVec2 m_tileWindowMins;
+	IntVec2 m_tileWindowSize;
+	int     m_tileMeshVersion = 0;
+	//fog of the player's faction over the same window, versioned like the tile mesh
+	std::shared_ptr<const std::vector<TileFogLevel>> m_tileFogLevels;
+	int     m_tileFogVersion = 0;
+	IntVec2 m_mapSize;
+
+	bool  m_isPlayerAlive = false;
+	Vec2  m_playerPosition;
+	int   m_playerFactionBombNum = 0;
+	int   m_playerRespawnChances = 0;
+	bool  m_hasPlayerWon = false;
+	bool  m_hasPlayerLost = false;
+
+	int   m_numAIThinks = 0;
+	int   m_numAIDeferred = 0;
+	int   m_aiMicroseconds = 0;
+	int   m_tickIndex = 0;
+
+	int GetNumEntitiesOfType( EntityType type ) const { return m_firstEntityOfType[type + 1] - m_firstEntityOfType[type]; }
+	const EntityRenderState* GetFirstEntityOfType( EntityType type ) const { return m_entities.data() + m_firstEntityOfType[type]; }
+};
+
+//////////////////////////////////////////////////////////////////////////
+//triple buffer: the simulation always has a snapshot to write and the renderer always has the latest complete one to read
+//publishing and acquiring swap indices with one atomic exchange, so neither side ever waits for the other
+class RenderSnapshotBuffer
+{
+public:
+	RenderSnapshotBuffer() = default;
+
+	//simulation side
+	RenderSnapshot& GetWriteSnapshot() { return m_snapshots[m_writeIndex]; }
+	void Publish();
+
+	//render side, returns the newest published snapshot, or the previous one when nothing new was published
+	const RenderSnapshot& AcquireLatest();
+	bool HasPublished() const { return m_hasPublished.load( std::memory_order_acquire ); }
+
+private:
+	static constexpr int NEW_SNAPSHOT_BIT = 4;
+	static constexpr int SNAPSHOT_INDEX_MASK = 3;
+
+	RenderSnapshot m_snapshots[3];
+	int m_writeIndex = 0;
+	int m_readIndex = 1;
+	//index of the snapshot between the two sides, NEW_SNAPSHOT_BIT is set until the renderer takes it
+	std::atomic<int> m_sharedIndex{ 2 };
+	std::atomic<bool> m_hasPublished{ false };
+};
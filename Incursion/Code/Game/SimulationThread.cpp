@@ -0,0 +1,166 @@
+#include "Game/SimulationThread.hpp"
+#include "Game/World.hpp"
+#include "Game/Map.hpp"
+#include "Game/Player.hpp"
+#include <chrono>
+
+//////////////////////////////////////////////////////////////////////////
+SimulationThread::SimulationThread( World* world )
+	:m_world(world)
+{
+}
+
+//////////////////////////////////////////////////////////////////////////
+SimulationThread::~SimulationThread()
+{
+	Stop();
+}
+
+//////////////////////////////////////////////////////////////////////////
+void SimulationThread::Start()
+{
+	if( IsRunning() )
+		return;
+
+	//commands sent while stopped belong to the previous game
+	InputCommand staleCommand;
+	while( m_inputCommands.TryPop( staleCommand ) ) {}
+	m_input = InputCommand();
+
+	m_isRunning.store( true, std::memory_order_release );
+	m_thread = std::thread( &SimulationThread::ThreadMain, this );
+}
+
+//////////////////////////////////////////////////////////////////////////
+void SimulationThread::Stop()
+{
+	if( !IsRunning() )
+		return;
+
+	m_isRunning.store( false, std::memory_order_release );
+	m_thread.join();
+}
+
+//////////////////////////////////////////////////////////////////////////
+void SimulationThread::PublishSnapshot()
+{
+	RenderSnapshot& snapshot = m_snapshots.GetWriteSnapshot();
+	m_world->FillRenderSnapshot( snapshot );
+	snapshot.m_tickIndex = m_tickIndex;
+	m_snapshots.Publish();
+}
+
+//////////////////////////////////////////////////////////////////////////
+void SimulationThread::ThreadMain()
+{
+	typedef std::chrono::steady_clock SimulationClock;
+	const std::chrono::duration<double> tickDuration( (double)SIMULATION_TICK_SECONDS );
+
+	SimulationClock::time_point lastTime = SimulationClock::now();
+	double unsimulatedSeconds = 0.0;
+	while( IsRunning() )
+	{
+		SimulationClock::time_point now = SimulationClock::now();
+		double elapsedSeconds = std::chrono::duration<double>( now - lastTime ).count();
+		lastTime = now;
+
+		DrainInputCommands();
+		if( !m_isPaused.load( std::memory_order_acquire ) )
+		{
+			unsimulatedSeconds += elapsedSeconds * (double)m_input.m_timeScale;
+		}
+
+		int numTicks = 0;
+		while( unsimulatedSeconds >= (double)SIMULATION_TICK_SECONDS && numTicks < SIMULATION_MAX_TICKS_PER_STEP )
+		{
+			Tick( SIMULATION_TICK_SECONDS );
+			unsimulatedSeconds -= (double)SIMULATION_TICK_SECONDS;
+			numTicks++;
+		}
+		//too far behind to catch up, drop the backlog instead of spiraling
+		if( numTicks == SIMULATION_MAX_TICKS_PER_STEP )
+		{
+			unsimulatedSeconds = 0.0;
+		}
+		if( numTicks > 0 )
+		{
+			PublishSnapshot();
+		}
+
+		std::this_thread::sleep_until( now + std::chrono::duration_cast<SimulationClock::duration>( tickDuration ) );
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+void SimulationThread::DrainInputCommands()
+{
+	//analog state comes from the newest command, button presses of every command are kept
+	InputCommand command;
+	while( m_inputCommands.TryPop( command ) )
+	{
+		m_input.m_isControllerConnected = command.m_isControllerConnected;
+		m_input.m_moveMagnitude = command.m_moveMagnitude;
+		m_input.m_moveDegrees = command.m_moveDegrees;
+		m_input.m_aimMagnitude = command.m_aimMagnitude;
+		m_input.m_aimDegrees = command.m_aimDegrees;
+		m_input.m_timeScale = command.m_timeScale;
+		m_input.m_wasShootPressed = m_input.m_wasShootPressed || command.m_wasShootPressed;
+		m_input.m_wasBombPressed = m_input.m_wasBombPressed || command.m_wasBombPressed;
+		m_input.m_wasRespawnRequested = m_input.m_wasRespawnRequested || command.m_wasRespawnRequested;
+		m_input.m_wasSpawnAlliesRequested = m_input.m_wasSpawnAlliesRequested || command.m_wasSpawnAlliesRequested;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+void SimulationThread::Tick( float deltaSeconds )
+{
+	Map* currentMap = m_world->GetCurrentMap();
+	if( m_input.m_wasRespawnRequested && currentMap->GetPlayerAlive() == nullptr )
+	{
+		currentMap->SpawnPlayer( FACTION_GOOD, Vec2( 1.5f, 1.5f ) );
+	}
+	if( m_input.m_wasSpawnAlliesRequested )
+	{
+		currentMap->SpawnNPC( ENTITY_TYPE_NPC_TANK, FACTION_GOOD );
+		currentMap->SpawnNPC( ENTITY_TYPE_NPC_TURRET, FACTION_GOOD );
+	}
+	Player* player = (Player*)currentMap->GetPlayerAlive();
+	if( player != nullptr )
+	{
+		player->SetInputCommand( m_input );
+	}
+
+	m_world->Update( deltaSeconds );
+	m_tickIndex++;
+
+	//presses are consumed by the first tick that sees them
+	m_input.m_wasShootPressed = false;
+	m_input.m_wasBombPressed = false;
+	m_input.m_wasRespawnRequested = false;
+	m_input.m_wasSpawnAlliesRequested = false;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void PostSimulationSound( const char* soundFilePath )
+{
+	if( g_theSimulation == nullptr )
+		return;
+
+	SimulationEvent event;
+	event.m_type = SIMULATION_EVENT_PLAY_SOUND;
+	event.m_soundFilePath = soundFilePath;
+	g_theSimulation->PostEvent( event );
+}
+
+//////////////////////////////////////////////////////////////////////////
+void PostSimulationVibration( int controllerID, float vibration )
+{
+	if( g_theSimulation == nullptr )
+		return;
+
+	SimulationEvent event;
+	event.m_type = SIMULATION_EVENT_SET_VIBRATION;
+	event.m_controllerID = controllerID;
+	event.m_vibration = vibration;
+	g_theSimulation->PostEvent( event );
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <thread>
+#include <atomic>
+#include "Game/GameCommon.hpp"
+#include "Game/SpscQueue.hpp"
+#include "Game/RenderSnapshot.hpp"
+
+class World;
+
+//////////////////////////////////////////////////////////////////////////
+//what the main thread read from the input system this frame, edge flags are kept until a tick consumes them
+struct InputCommand
+{
+	bool  m_isControllerConnected = false;
+	float m_moveMagnitude = 0.f;
+	float m_moveDegrees = 0.f;
+	float m_aimMagnitude = 0.f;
+	float m_aimDegrees = 0.f;
+	bool  m_wasShootPressed = false;
+	bool  m_wasBombPressed = false;
+	bool  m_wasRespawnRequested = false;
+	bool  m_wasSpawnAlliesRequested = false;
+	float m_timeScale = 1.f;
+};
+
+enum SimulationEventType
+{
+	SIMULATION_EVENT_PLAY_SOUND,
+	SIMULATION_EVENT_SET_VIBRATION,
+};
+
+//////////////////////////////////////////////////////////////////////////
+//side effects the simulation cannot do itself because the audio and input systems belong to the main thread
+struct SimulationEvent
+{
+	SimulationEventType m_type = SIMULATION_EVENT_PLAY_SOUND;
+	const char* m_soundFilePath = nullptr;
+	int   m_controllerID = 0;
+	float m_vibration = 0.f;
+};
+
+//////////////////////////////////////////////////////////////////////////
+//runs World::Update at a fixed tick on its own thread, talks to the main thread only through lock free queues and snapshots
+//the world may only be touched from the main thread while the simulation is stopped
+class SimulationThread
+{
+public:
+	explicit SimulationThread( World* world );
+	~SimulationThread();
+
+	void Start();
+	void Stop();
+	bool IsRunning() const { return m_isRunning.load( std::memory_order_acquire ); }
+	void SetPaused( bool isPaused ) { m_isPaused.store( isPaused, std::memory_order_release ); }
+
+	//main thread
+	bool PushInputCommand( const InputCommand& command ) { return m_inputCommands.TryPush( command ); }
+	bool PopEvent( SimulationEvent& out_event ) { return m_events.TryPop( out_event ); }
+	const RenderSnapshot& AcquireLatestSnapshot() { return m_snapshots.AcquireLatest(); }
+	bool HasSnapshot() const { return m_snapshots.HasPublished(); }
+
+	//simulation side, or main thread while stopped
+	void PostEvent( const SimulationEvent& event ) { m_events.TryPush( event ); }
+	void PublishSnapshot();
+
+private:
+	World* m_world = nullptr;
+	std::thread m_thread;
+	std::atomic<bool> m_isRunning{ false };
+	std::atomic<bool> m_isPaused{ false };
+	InputCommand m_input;
+	int m_tickIndex = 0;
+
+	SpscQueue<InputCommand, SIMULATION_INPUT_QUEUE_SIZE> m_inputCommands;
+	SpscQueue<SimulationEvent, SIMULATION_EVENT_QUEUE_SIZE> m_events;
+	RenderSnapshotBuffer m_snapshots;
+
+	void ThreadMain();
+	void DrainInputCommands();
+	void Tick( float deltaSeconds );
+};
+
+//callable from any simulation code, dropped when the queue is full
+void PostSimulationSound( const char* soundFilePath );
+void PostSimulationVibration( int controllerID, float vibration );
@@ -0,0 +1,63 @@
+#include "Game/SpawnPlacer.hpp"
+#include "Engine/Math/MathUtils.hpp"
+#include <algorithm>
+
+//////////////////////////////////////////////////////////////////////////
+SpawnPlacer::SpawnPlacer( const IntVec2& mapSize, float cellSize, float minSpacing )
+	:m_cellSize(cellSize)
+	,m_minSpacing(minSpacing)
+{
+	m_dimensions.x = (int)((float)mapSize.x / cellSize) + 1;
+	m_dimensions.y = (int)((float)mapSize.y / cellSize) + 1;
+	m_cellHeads.assign( (size_t)m_dimensions.x * (size_t)m_dimensions.y, -1 );
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool SpawnPlacer::IsClear( const Vec2& position, float radius ) const
+{
+	//discs are bucketed by center, so the cells to check reach as far as the largest accepted disc could touch
+	float reach = radius + m_minSpacing + m_maxRadius;
+	int minX = GetClampedCellX( position.x - reach );
+	int maxX = GetClampedCellX( position.x + reach );
+	int minY = GetClampedCellY( position.y - reach );
+	int maxY = GetClampedCellY( position.y + reach );
+	for( int cellY = minY; cellY <= maxY; cellY++ )
+	{
+		for( int cellX = minX; cellX <= maxX; cellX++ )
+		{
+			for( int discIndex = m_cellHeads[(size_t)cellY * (size_t)m_dimensions.x + (size_t)cellX]; discIndex >= 0; discIndex = m_discs[discIndex].m_nextInCell )
+			{
+				const PlacedDisc& disc = m_discs[discIndex];
+				float minDist = radius + disc.m_radius + m_minSpacing;
+				if( GetDistanceSquared2D( position, disc.m_position ) < minDist * minDist )
+					return false;
+			}
+		}
+	}
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void SpawnPlacer::Add( const Vec2& position, float radius )
+{
+	size_t cellIndex = (size_t)GetClampedCellY( position.y ) * (size_t)m_dimensions.x + (size_t)GetClampedCellX( position.x );
+	PlacedDisc disc;
+	disc.m_position = position;
+	disc.m_radius = radius;
+	disc.m_nextInCell = m_cellHeads[cellIndex];
+	m_cellHeads[cellIndex] = (int)m_discs.size();
+	m_discs.push_back( disc );
+	m_maxRadius = std::max( m_maxRadius, radius );
+}
+
+//////////////////////////////////////////////////////////////////////////
+int SpawnPlacer::GetClampedCellX( float x ) const
+{
+	return std::max( 0, std::min( RoundDownToInt( x / m_cellSize ), m_dimensions.x - 1 ) );
+}
+
+//////////////////////////////////////////////////////////////////////////
+int SpawnPlacer::GetClampedCellY( float y ) const
+{
+	return std::max( 0, std::min( RoundDownToInt( y / m_cellSize ), m_dimensions.y - 1 ) );
+}
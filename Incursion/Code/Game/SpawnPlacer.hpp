@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+#include "Engine/Math/IntVec2.hpp"
+#include "Engine/Math/Vec2.hpp"
+
+//////////////////////////////////////////////////////////////////////////
+//keeps spawn discs apart, an accepted disc is at least the spacing away from every disc accepted before it
+//discs are bucketed by center in a uniform grid, so a candidate only checks the few cells its reach covers
+//and placing n discs costs O(n) checks on any map
+class SpawnPlacer
+{
+public:
+	explicit SpawnPlacer( const IntVec2& mapSize, float cellSize, float minSpacing );
+	~SpawnPlacer() = default;
+
+	bool IsClear( const Vec2& position, float radius ) const;
+	void Add( const Vec2& position, float radius );
+	int  GetNumDiscs() const { return (int)m_discs.size(); }
+
+private:
+	struct PlacedDisc
+	{
+		Vec2  m_position;
+		float m_radius = 0.f;
+		//next disc in the same cell, -1 ends the list
+		int   m_nextInCell = -1;
+	};
+
+	IntVec2 m_dimensions;
+	float m_cellSize = 1.f;
+	float m_minSpacing = 0.f;
+	float m_maxRadius = 0.f;
+	//first disc of every cell, -1 when empty
+	std::vector<int> m_cellHeads;
+	std::vector<PlacedDisc> m_discs;
+
+	int GetClampedCellX( float x ) const;
+	int GetClampedCellY( float y ) const;
+};
@@ -0,0 +1,54 @@
+#include "Game/SpawnTable.hpp"
+#include "Game/TileStorage.hpp"
+#include "Game/TileDefinition.hpp"
+
+//////////////////////////////////////////////////////////////////////////
+void SpawnTable::CollectEnemySpawnTiles( const TileStorage& tiles, std::vector<int64_t>& out_tileIndices )
+{
+	out_tileIndices.clear();
+	const IntVec2& dimensions = tiles.GetDimensions();
+	for( int tileY = 0; tileY < dimensions.y; tileY++ )
+	{
+		for( int tileX = 0; tileX < dimensions.x; tileX++ )
+		{
+			IntVec2 tileCoords( tileX, tileY );
+			if( TileDefinition::s_definitions[tiles.GetTileType( tileCoords )].m_isEnemySpawnable )
+				out_tileIndices.push_back( tiles.GetTileIndex( tileCoords ) );
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+void SpawnTable::BuildForEnemies( const TileStorage& tiles )
+{
+	CollectEnemySpawnTiles( tiles, m_builtTileIndices );
+	m_tileIndices = m_builtTileIndices.data();
+	m_numTiles = (int64_t)m_builtTileIndices.size();
+	m_numMapTiles = tiles.GetNumTiles();
+}
+
+//////////////////////////////////////////////////////////////////////////
+void SpawnTable::SetFromMapFile( const int64_t* tileIndices, int64_t numTiles, int64_t numMapTiles )
+{
+	//entries are not checked here, that would page in the whole table, each one is checked when it is picked
+	m_builtTileIndices.clear();
+	m_tileIndices = tileIndices;
+	m_numTiles = numTiles;
+	m_numMapTiles = numMapTiles;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void SpawnTable::Clear()
+{
+	m_builtTileIndices.clear();
+	m_tileIndices = nullptr;
+	m_numTiles = 0;
+	m_numMapTiles = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////
+int64_t SpawnTable::GetTileIndex( int64_t entry ) const
+{
+	int64_t tileIndex = m_tileIndices[entry];
+	return tileIndex >= 0 && tileIndex < m_numMapTiles ? tileIndex : -1;
+}
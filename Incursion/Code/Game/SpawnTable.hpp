@@ -0,0 +1,50 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include "Engine/Math/Vec2.hpp"
+
+class TileStorage;
+
+//////////////////////////////////////////////////////////////////////////
+//disc no spawn point may be picked in
+struct SpawnExclusionZone
+{
+	Vec2  m_center;
+	float m_radius = 0.f;
+
+	SpawnExclusionZone() = default;
+	explicit SpawnExclusionZone( const Vec2& center, float radius )
+		:m_center(center)
+		,m_radius(radius)
+	{
+	}
+};
+
+//////////////////////////////////////////////////////////////////////////
+//tile indices of every tile one kind of spawn may use, so picking a spawn tile is one random index
+//the entries either point into a map file or are built from the tiles
+class SpawnTable
+{
+public:
+	SpawnTable() = default;
+	~SpawnTable() = default;
+
+	static void CollectEnemySpawnTiles( const TileStorage& tiles, std::vector<int64_t>& out_tileIndices );
+
+	void BuildForEnemies( const TileStorage& tiles );
+	//the map file has to stay open as long as the table uses it, numMapTiles bounds the entries it may hold
+	void SetFromMapFile( const int64_t* tileIndices, int64_t numTiles, int64_t numMapTiles );
+	void Clear();
+
+	bool    IsEmpty() const { return m_numTiles == 0; }
+	int64_t GetNumTiles() const { return m_numTiles; }
+	//-1 for an entry outside the map, which only a damaged map file holds
+	int64_t GetTileIndex( int64_t entry ) const;
+
+private:
+	const int64_t* m_tileIndices = nullptr;
+	int64_t m_numTiles = 0;
+	int64_t m_numMapTiles = 0;
+	std::vector<int64_t> m_builtTileIndices;
+};
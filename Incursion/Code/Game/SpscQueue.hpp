@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+
+//////////////////////////////////////////////////////////////////////////
+//lock free ring buffer for exactly one producer thread and one consumer thread
+//neither side ever waits: TryPush fails when the queue is full, TryPop fails when it is empty
+template<typename T, int CAPACITY>
+class SpscQueue
+{
+	static_assert( CAPACITY > 0 && (CAPACITY & (CAPACITY - 1)) == 0, "SpscQueue capacity must be a power of two" );
+
+public:
+	SpscQueue() = default;
+	SpscQueue( const SpscQueue& ) = delete;
+	SpscQueue& operator=( const SpscQueue& ) = delete;
+
+	//producer only
+	bool TryPush( const T& item )
+	{
+		unsigned int tail = m_tail.load( std::memory_order_relaxed );
+		if( tail - m_head.load( std::memory_order_acquire ) >= (unsigned int)CAPACITY )
+			return false;
+		m_items[tail & (CAPACITY - 1)] = item;
+		m_tail.store( tail + 1, std::memory_order_release );
+		return true;
+	}
+
+	//consumer only
+	bool TryPop( T& out_item )
+	{
+		unsigned int head = m_head.load( std::memory_order_relaxed );
+		if( head == m_tail.load( std::memory_order_acquire ) )
+			return false;
+		out_item = m_items[head & (CAPACITY - 1)];
+		m_head.store( head + 1, std::memory_order_release );
+		return true;
+	}
+
+private:
+	T m_items[CAPACITY];
+	//free running counters, kept on separate cache lines so both sides do not fight over one line
+	alignas(64) std::atomic<unsigned int> m_head{ 0 };
+	alignas(64) std::atomic<unsigned int> m_tail{ 0 };
+};
@@ -1,6 +1,5 @@
 #include "Game/Tile.hpp"
 #include "Game/GameCommon.hpp"
-#include "Game/Map.hpp"
 #include "Game/TileDefinition.hpp"
 #include "Engine/Math/AABB2.hpp"
 #include "Engine/Core/Rgba8.hpp"
@@ -14,12 +13,12 @@ Tile::Tile( int posX, int posY )
 {
 }
 
-void Tile::Render() const
+void Tile::AppendVerts( std::vector<Vertex_PCU>& verts ) const
 {
 	Vec2 uvAtMins, uvAtMaxs;
 	GetUVCoords(uvAtMins,uvAtMaxs);
 	AABB2 bounds = GetBounds();
-	AppendVertsForAABB2D( g_tileVerts, bounds, uvAtMins, uvAtMaxs,Rgba8::WHITE);
+	AppendVertsForAABB2D( verts, bounds, uvAtMins, uvAtMaxs,Rgba8::WHITE);
 }
 
 AABB2 Tile::GetBounds() const
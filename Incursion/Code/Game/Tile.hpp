@@ -1,9 +1,11 @@
 #pragma once
 #include "Engine/Math/IntVec2.hpp"
+#include <vector>
 
 struct AABB2;
 struct Rgba8;
 struct Vec2;
+struct Vertex_PCU;
 
 enum TileType : int
 {
@@ -29,7 +31,7 @@ public:
 	Tile(int posX, int posY);
 	~Tile()=default;
 
-	void Render()const;
+	void AppendVerts( std::vector<Vertex_PCU>& verts ) const;
 
 	//origin is at the left bottom corner.
 	AABB2 GetBounds() const;
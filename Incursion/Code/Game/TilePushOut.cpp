@@ -0,0 +1,36 @@
+#include "Game/TilePushOut.hpp"
+#include <cmath>
+
+//corners shared with the diagonal neighbors 4 to 7 of TileStorage::NEIGHBOR_OFFSETS, relative to the tile mins
+static const float DIAGONAL_CORNER_OFFSETS[4][2] = { { 1.f, 1.f }, { 0.f, 1.f }, { 0.f, 0.f }, { 1.f, 0.f } };
+
+//////////////////////////////////////////////////////////////////////////
+void PushDiscOutOfSolidNeighbors( Vec2& position, float radius, const IntVec2& tileCoords, uint8_t solidNeighborMask )
+{
+	//open ground or off the map, nothing to push out of
+	if( solidNeighborMask == 0 )
+		return;
+
+	//Assume that radius < 1, then the center stays in its own tile and each neighbor is a half plane or a corner point
+	float minX = (float)tileCoords.x;
+	float minY = (float)tileCoords.y;
+	if( (solidNeighborMask & 1) != 0 && position.x > minX + 1.f - radius )
+		position.x = minX + 1.f - radius;
+	if( (solidNeighborMask & 2) != 0 && position.y > minY + 1.f - radius )
+		position.y = minY + 1.f - radius;
+	if( (solidNeighborMask & 4) != 0 && position.x < minX + radius )
+		position.x = minX + radius;
+	if( (solidNeighborMask & 8) != 0 && position.y < minY + radius )
+		position.y = minY + radius;
+	for( int cornerID = 0; cornerID < 4; cornerID++ )
+	{
+		if( (solidNeighborMask & (16 << cornerID)) == 0 )
+			continue;
+		Vec2 corner( minX + DIAGONAL_CORNER_OFFSETS[cornerID][0], minY + DIAGONAL_CORNER_OFFSETS[cornerID][1] );
+		Vec2 cornerToPosition = position - corner;
+		float distSquared = cornerToPosition.GetLengthSquared();
+		if( distSquared >= radius * radius || distSquared == 0.f )
+			continue;
+		position = corner + cornerToPosition * (radius / sqrtf( distSquared ));
+	}
+}
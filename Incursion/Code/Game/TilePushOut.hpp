@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstdint>
+#include "Engine/Math/IntVec2.hpp"
+#include "Engine/Math/Vec2.hpp"
+
+//////////////////////////////////////////////////////////////////////////
+//push a disc of radius < 1 out of the solid neighbors of tileCoords, the tile its center is in
+//solidNeighborMask is TileStorage::GetSolidNeighborMask( tileCoords ), bit i for the neighbor at TileStorage::NEIGHBOR_OFFSETS[i]
+//only reads its arguments, so the benchmarks build it without the map
+void PushDiscOutOfSolidNeighbors( Vec2& position, float radius, const IntVec2& tileCoords, uint8_t solidNeighborMask );
@@ -0,0 +1,344 @@
+#include "Game/TileStorage.hpp"
+#include "Game/TileDefinition.hpp"
+#include "Game/MapFile.hpp"
+#include "Engine/Core/ErrorWarningAssert.hpp"
+#include "Engine/Core/StringUtils.hpp"
+#include <algorithm>
+#include <cmath>
+
+const IntVec2 TileStorage::NEIGHBOR_OFFSETS[8] = {
+	IntVec2( 1,0 ),IntVec2( 0,1 ),IntVec2( -1,0 ),IntVec2( 0,-1 ),
+	IntVec2( 1,1 ),IntVec2( -1,1 ),IntVec2( -1,-1 ),IntVec2( 1,-1 )
+};
+
+//////////////////////////////////////////////////////////////////////////
+//map files are not checked tile by tile when they open, a type byte past the tile set can only come from a damaged one
+//it reads as stone, so it stays a wall and never indexes past the tile definitions
+static TileType GetTileTypeForByte( uint8_t typeByte )
+{
+	return typeByte < NUM_TILE_TYPE ? (TileType)typeByte : TILE_TYPE_STONE;
+}
+
+//////////////////////////////////////////////////////////////////////////
+//distance from a tile center to the nearest point of the tile dx columns and dy rows away
+static float GetDistanceToTileAtOffset( int dx, int dy )
+{
+	float gapX = dx == 0 ? 0.f : (float)std::abs( dx ) - .5f;
+	float gapY = dy == 0 ? 0.f : (float)std::abs( dy ) - .5f;
+	return sqrtf( gapX * gapX + gapY * gapY );
+}
+
+//////////////////////////////////////////////////////////////////////////
+static uint8_t QuantizeClearance( float clearance )
+{
+	//rounded down, a disc that fits the stored value always fits the real one
+	return (uint8_t)(clearance * (float)TILE_CLEARANCE_STEPS_PER_TILE);
+}
+
+//////////////////////////////////////////////////////////////////////////
+void TileStorage::Startup( const IntVec2& dimensions, TileType fillType )
+{
+	StartupChunkGrid( dimensions );
+
+	//fill every chunk, then the masks once all types are in
+	bool isFillSolid = m_isTypeSolid[fillType];
+	for( int chunkY = 0; chunkY < m_chunkDimensions.y; chunkY++ )
+	{
+		for( int chunkX = 0; chunkX < m_chunkDimensions.x; chunkX++ )
+		{
+			size_t chunkIndex = (size_t)chunkY * (size_t)m_chunkDimensions.x + (size_t)chunkX;
+			m_ownedChunks[chunkIndex] = std::make_unique<TileChunk>();
+			m_chunks[chunkIndex] = m_ownedChunks[chunkIndex].get();
+			TileChunk& chunk = *m_ownedChunks[chunkIndex];
+			int numColumns = std::min( TILE_CHUNK_SIZE, dimensions.x - (chunkX << TILE_CHUNK_SIZE_LOG2) );
+			int numRows = std::min( TILE_CHUNK_SIZE, dimensions.y - (chunkY << TILE_CHUNK_SIZE_LOG2) );
+			chunk.m_numTilesInMap = numColumns * numRows;
+			chunk.m_numSolidTiles = isFillSolid ? chunk.m_numTilesInMap : 0;
+			for( int localIndex = 0; localIndex < TILE_CHUNK_NUM_TILES; localIndex++ )
+			{
+				chunk.m_types[localIndex] = (uint8_t)fillType;
+			}
+		}
+	}
+	for( int tileY = 0; tileY < dimensions.y; tileY++ )
+	{
+		for( int tileX = 0; tileX < dimensions.x; tileX++ )
+		{
+			IntVec2 tileCoords( tileX, tileY );
+			GetWritableChunkForTile( tileCoords ).m_solidNeighborMasks[GetLocalIndex( tileCoords )] = ComputeSolidNeighborMask( tileCoords );
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+void TileStorage::StartupFromFile( const MapFile& mapFile )
+{
+	StartupChunkGrid( mapFile.GetDimensions() );
+
+	//no tile is read here, the OS pages a chunk in the first time a query lands in it
+	const TileChunk* fileChunks = mapFile.GetChunks();
+	for( size_t chunkIndex = 0; chunkIndex < m_chunks.size(); chunkIndex++ )
+	{
+		m_chunks[chunkIndex] = fileChunks + chunkIndex;
+	}
+	//the file stores clearances with the tiles
+	m_areClearancesBuilt = true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void TileStorage::StartupChunkGrid( const IntVec2& dimensions )
+{
+	if( dimensions.x <= 0 || dimensions.y <= 0 )
+		ERROR_AND_DIE( Stringf( "Tile storage size %d x %d is empty", dimensions.x, dimensions.y ) );
+
+	for( int typeByte = 0; typeByte <= UINT8_MAX; typeByte++ )
+	{
+		m_isTypeSolid[typeByte] = TileDefinition::s_definitions[GetTileTypeForByte( (uint8_t)typeByte )].m_isSolid;
+	}
+	m_dimensions = dimensions;
+	m_chunkDimensions.x = (dimensions.x + TILE_CHUNK_SIZE - 1) >> TILE_CHUNK_SIZE_LOG2;
+	m_chunkDimensions.y = (dimensions.y + TILE_CHUNK_SIZE - 1) >> TILE_CHUNK_SIZE_LOG2;
+	size_t numChunks = (size_t)m_chunkDimensions.x * (size_t)m_chunkDimensions.y;
+	m_chunks.assign( numChunks, nullptr );
+	m_ownedChunks.clear();
+	m_ownedChunks.resize( numChunks );
+	m_areClearancesBuilt = false;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void TileStorage::Clear()
+{
+	m_dimensions = IntVec2( 0, 0 );
+	m_chunkDimensions = IntVec2( 0, 0 );
+	m_chunks.clear();
+	m_ownedChunks.clear();
+	m_areClearancesBuilt = false;
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool TileStorage::IsInBounds( const IntVec2& tileCoords ) const
+{
+	return tileCoords.x >= 0 && tileCoords.y >= 0 && tileCoords.x < m_dimensions.x && tileCoords.y < m_dimensions.y;
+}
+
+//////////////////////////////////////////////////////////////////////////
+TileType TileStorage::GetTileType( const IntVec2& tileCoords ) const
+{
+	if( !IsInBounds( tileCoords ) )
+		ERROR_AND_DIE( Stringf( "Tile (%d, %d) is outside the %d x %d map", tileCoords.x, tileCoords.y, m_dimensions.x, m_dimensions.y ) );
+	return GetTileTypeForByte( GetChunkForTile( tileCoords ).m_types[GetLocalIndex( tileCoords )] );
+}
+
+//////////////////////////////////////////////////////////////////////////
+void TileStorage::SetTileType( const IntVec2& tileCoords, TileType type )
+{
+	if( !IsInBounds( tileCoords ) )
+		ERROR_AND_DIE( Stringf( "Tile (%d, %d) is outside the %d x %d map", tileCoords.x, tileCoords.y, m_dimensions.x, m_dimensions.y ) );
+
+	TileChunk& chunk = GetWritableChunkForTile( tileCoords );
+	int localIndex = GetLocalIndex( tileCoords );
+	bool wasSolid = m_isTypeSolid[chunk.m_types[localIndex]];
+	bool isSolid = m_isTypeSolid[type];
+	chunk.m_types[localIndex] = (uint8_t)type;
+	if( wasSolid == isSolid )
+		return;
+
+	//solidity changed: fix the chunk count and the matching bit of the eight neighbors
+	chunk.m_numSolidTiles += isSolid ? 1 : -1;
+	for( int neighborID = 0; neighborID < 8; neighborID++ )
+	{
+		IntVec2 neighborCoords = tileCoords + NEIGHBOR_OFFSETS[neighborID];
+		if( !IsInBounds( neighborCoords ) )
+			continue;
+		//the neighbor sees this tile at the opposite offset, which is 2 bits further in both halves of the order
+		int oppositeID = (neighborID & 4) | ((neighborID + 2) & 3);
+		uint8_t& neighborMask = GetWritableChunkForTile( neighborCoords ).m_solidNeighborMasks[GetLocalIndex( neighborCoords )];
+		if( isSolid )
+			neighborMask |= (uint8_t)(1 << oppositeID);
+		else neighborMask &= (uint8_t)~(1 << oppositeID);
+	}
+	if( m_areClearancesBuilt )
+		UpdateClearancesAround( tileCoords );
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool TileStorage::IsTileSolid( const IntVec2& tileCoords ) const
+{
+	if( !IsInBounds( tileCoords ) )
+		return true;
+	return m_isTypeSolid[GetChunkForTile( tileCoords ).m_types[GetLocalIndex( tileCoords )]];
+}
+
+//////////////////////////////////////////////////////////////////////////
+uint8_t TileStorage::GetSolidNeighborMask( const IntVec2& tileCoords ) const
+{
+	if( !IsInBounds( tileCoords ) )
+		return 0;
+	return GetChunkForTile( tileCoords ).m_solidNeighborMasks[GetLocalIndex( tileCoords )];
+}
+
+//////////////////////////////////////////////////////////////////////////
+float TileStorage::GetClearance( const IntVec2& tileCoords ) const
+{
+	if( !IsInBounds( tileCoords ) )
+		return 0.f;
+	return (float)GetChunkForTile( tileCoords ).m_clearances[GetLocalIndex( tileCoords )] / (float)TILE_CLEARANCE_STEPS_PER_TILE;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void TileStorage::RebuildClearances()
+{
+	//exact in two linear passes: the nearest solid column of every row, then the nearest of the rows in range
+	//within one row the distance only grows with the column gap, so the nearest column is the nearest tile of that row
+	int capDistance = TILE_CLEARANCE_RANGE + 1;
+	std::vector<uint8_t> rowDistances( (size_t)GetNumTiles() );
+	for( int tileY = 0; tileY < m_dimensions.y; tileY++ )
+	{
+		size_t rowStart = (size_t)tileY * (size_t)m_dimensions.x;
+		//off-map columns count as solid
+		int lastSolidX = -1;
+		for( int tileX = 0; tileX < m_dimensions.x; tileX++ )
+		{
+			if( IsTileSolid( IntVec2( tileX, tileY ) ) )
+				lastSolidX = tileX;
+			rowDistances[rowStart + tileX] = (uint8_t)std::min( tileX - lastSolidX, capDistance );
+		}
+		int nextSolidX = m_dimensions.x;
+		for( int tileX = m_dimensions.x - 1; tileX >= 0; tileX-- )
+		{
+			if( rowDistances[rowStart + tileX] == 0 )
+				nextSolidX = tileX;
+			rowDistances[rowStart + tileX] = (uint8_t)std::min( (int)rowDistances[rowStart + tileX], std::min( nextSolidX - tileX, capDistance ) );
+		}
+	}
+	for( int tileY = 0; tileY < m_dimensions.y; tileY++ )
+	{
+		for( int tileX = 0; tileX < m_dimensions.x; tileX++ )
+		{
+			float clearance = (float)TILE_CLEARANCE_RANGE;
+			for( int dy = -TILE_CLEARANCE_RANGE; dy <= TILE_CLEARANCE_RANGE; dy++ )
+			{
+				int rowY = tileY + dy;
+				//rows off the map are solid all along
+				int columnDistance = (rowY < 0 || rowY >= m_dimensions.y) ? 0 : (int)rowDistances[(size_t)rowY * (size_t)m_dimensions.x + tileX];
+				if( columnDistance < capDistance )
+					clearance = std::min( clearance, GetDistanceToTileAtOffset( columnDistance, dy ) );
+			}
+			IntVec2 tileCoords( tileX, tileY );
+			GetWritableChunkForTile( tileCoords ).m_clearances[GetLocalIndex( tileCoords )] = QuantizeClearance( clearance );
+		}
+	}
+	m_areClearancesBuilt = true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+const TileChunk& TileStorage::GetChunkForTile( const IntVec2& tileCoords ) const
+{
+	return *m_chunks[GetChunkIndex( tileCoords )];
+}
+
+//////////////////////////////////////////////////////////////////////////
+TileChunk& TileStorage::GetWritableChunkForTile( const IntVec2& tileCoords )
+{
+	//a chunk still read from the map file is copied out on its first write, the file itself stays read only
+	size_t chunkIndex = GetChunkIndex( tileCoords );
+	if( m_ownedChunks[chunkIndex] == nullptr )
+	{
+		m_ownedChunks[chunkIndex] = std::make_unique<TileChunk>( *m_chunks[chunkIndex] );
+		m_chunks[chunkIndex] = m_ownedChunks[chunkIndex].get();
+	}
+	return *m_ownedChunks[chunkIndex];
+}
+
+//////////////////////////////////////////////////////////////////////////
+IntVec2 TileStorage::GetChunkCoordsForTile( const IntVec2& tileCoords ) const
+{
+	return IntVec2( tileCoords.x >> TILE_CHUNK_SIZE_LOG2, tileCoords.y >> TILE_CHUNK_SIZE_LOG2 );
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool TileStorage::IsChunkAllWalkable( const IntVec2& tileCoords ) const
+{
+	if( !IsInBounds( tileCoords ) )
+		return false;
+	return GetChunkForTile( tileCoords ).IsAllWalkable();
+}
+
+//////////////////////////////////////////////////////////////////////////
+int64_t TileStorage::GetTileIndex( const IntVec2& tileCoords ) const
+{
+	if( !IsInBounds( tileCoords ) )
+		ERROR_AND_DIE( Stringf( "Tile (%d, %d) is outside the %d x %d map", tileCoords.x, tileCoords.y, m_dimensions.x, m_dimensions.y ) );
+	return (int64_t)tileCoords.y * (int64_t)m_dimensions.x + (int64_t)tileCoords.x;
+}
+
+//////////////////////////////////////////////////////////////////////////
+IntVec2 TileStorage::GetTileCoordsForTileIndex( int64_t tileIndex ) const
+{
+	if( tileIndex < 0 || tileIndex >= GetNumTiles() )
+		ERROR_AND_DIE( Stringf( "Tile index %lld is outside the %d x %d map", (long long)tileIndex, m_dimensions.x, m_dimensions.y ) );
+	int64_t y = tileIndex / m_dimensions.x;
+	return IntVec2( (int)(tileIndex - y * m_dimensions.x), (int)y );
+}
+
+//////////////////////////////////////////////////////////////////////////
+size_t TileStorage::GetChunkIndex( const IntVec2& tileCoords ) const
+{
+	size_t chunkX = (size_t)(tileCoords.x >> TILE_CHUNK_SIZE_LOG2);
+	size_t chunkY = (size_t)(tileCoords.y >> TILE_CHUNK_SIZE_LOG2);
+	return chunkY * (size_t)m_chunkDimensions.x + chunkX;
+}
+
+//////////////////////////////////////////////////////////////////////////
+int TileStorage::GetLocalIndex( const IntVec2& tileCoords ) const
+{
+	int localX = tileCoords.x & (TILE_CHUNK_SIZE - 1);
+	int localY = tileCoords.y & (TILE_CHUNK_SIZE - 1);
+	return (localY << TILE_CHUNK_SIZE_LOG2) | localX;
+}
+
+//////////////////////////////////////////////////////////////////////////
+uint8_t TileStorage::ComputeSolidNeighborMask( const IntVec2& tileCoords ) const
+{
+	uint8_t solidMask = 0;
+	for( int neighborID = 0; neighborID < 8; neighborID++ )
+	{
+		if( IsTileSolid( tileCoords + NEIGHBOR_OFFSETS[neighborID] ) )
+			solidMask |= (uint8_t)(1 << neighborID);
+	}
+	return solidMask;
+}
+
+//////////////////////////////////////////////////////////////////////////
+uint8_t TileStorage::ComputeClearance( const IntVec2& tileCoords ) const
+{
+	//the search of RebuildClearances for one tile, scanning each row out from the tile column
+	float clearance = (float)TILE_CLEARANCE_RANGE;
+	for( int dy = -TILE_CLEARANCE_RANGE; dy <= TILE_CLEARANCE_RANGE; dy++ )
+	{
+		for( int dx = 0; dx <= TILE_CLEARANCE_RANGE; dx++ )
+		{
+			if( IsTileSolid( tileCoords + IntVec2( dx, dy ) ) || IsTileSolid( tileCoords + IntVec2( -dx, dy ) ) )
+			{
+				clearance = std::min( clearance, GetDistanceToTileAtOffset( dx, dy ) );
+				break;
+			}
+		}
+	}
+	return QuantizeClearance( clearance );
+}
+
+//////////////////////////////////////////////////////////////////////////
+void TileStorage::UpdateClearancesAround( const IntVec2& tileCoords )
+{
+	//only tiles within the clearance range can see the change
+	for( int dy = -TILE_CLEARANCE_RANGE; dy <= TILE_CLEARANCE_RANGE; dy++ )
+	{
+		for( int dx = -TILE_CLEARANCE_RANGE; dx <= TILE_CLEARANCE_RANGE; dx++ )
+		{
+			IntVec2 nearCoords = tileCoords + IntVec2( dx, dy );
+			if( IsInBounds( nearCoords ) )
+				GetWritableChunkForTile( nearCoords ).m_clearances[GetLocalIndex( nearCoords )] = ComputeClearance( nearCoords );
+		}
+	}
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "Engine/Math/IntVec2.hpp"
+#include "Game/GameCommon.hpp"
+#include "Game/Tile.hpp"
+
+class MapFile;
+
+//////////////////////////////////////////////////////////////////////////
+//square block of tiles stored together, one byte each of type, solid neighbor mask and clearance per tile
+//also the record layout of map files, so only fixed size members
+struct TileChunk
+{
+	uint8_t m_types[TILE_CHUNK_NUM_TILES] = {};
+	//bit i set when the neighbor at TileStorage::NEIGHBOR_OFFSETS[i] is solid, off-map neighbors count as solid
+	uint8_t m_solidNeighborMasks[TILE_CHUNK_NUM_TILES] = {};
+	//distance from the tile center to the nearest solid tile in 1/TILE_CLEARANCE_STEPS_PER_TILE tiles, rounded down
+	//capped at TILE_CLEARANCE_RANGE tiles, solid tiles are 0
+	uint8_t m_clearances[TILE_CHUNK_NUM_TILES] = {};
+	//only tiles inside the map are counted, chunks on the far edges may be partly outside
+	int m_numTilesInMap = 0;
+	int m_numSolidTiles = 0;
+
+	bool IsAllSolid() const { return m_numSolidTiles == m_numTilesInMap; }
+	bool IsAllWalkable() const { return m_numSolidTiles == 0; }
+};
+
+//////////////////////////////////////////////////////////////////////////
+//tile types of one map in TILE_CHUNK_SIZE square chunks, so neighbors stay in cache on maps of any size
+//linear tile indices are 64 bit, coordinates outside the map are never clamped onto another tile
+//chunks of a loaded map are read in place from the mapped file and copied out only when a tile in them changes
+class TileStorage
+{
+public:
+	//orthogonal first, the push-out order of ResolveEntityTileCollision
+	static const IntVec2 NEIGHBOR_OFFSETS[8];
+
+public:
+	TileStorage() = default;
+	~TileStorage() = default;
+
+	void Startup( const IntVec2& dimensions, TileType fillType );
+	//the map file has to stay open as long as the storage uses it
+	void StartupFromFile( const MapFile& mapFile );
+	void Clear();
+
+	bool     IsInBounds( const IntVec2& tileCoords ) const;
+	//callers check bounds first, out of bounds dies
+	TileType GetTileType( const IntVec2& tileCoords ) const;
+	void     SetTileType( const IntVec2& tileCoords, TileType type );
+	//off-map tiles are solid
+	bool     IsTileSolid( const IntVec2& tileCoords ) const;
+	uint8_t  GetSolidNeighborMask( const IntVec2& tileCoords ) const;
+	//in tiles, off-map tiles are 0
+	float    GetClearance( const IntVec2& tileCoords ) const;
+	//clearances are kept current by SetTileType only once built, generation rebuilds them after bulk edits
+	void     RebuildClearances();
+	bool     AreClearancesBuilt() const { return m_areClearancesBuilt; }
+
+	const TileChunk& GetChunkForTile( const IntVec2& tileCoords ) const;
+	const TileChunk& GetChunk( size_t chunkIndex ) const { return *m_chunks[chunkIndex]; }
+	size_t   GetNumChunks() const { return m_chunks.size(); }
+	const IntVec2& GetChunkDimensions() const { return m_chunkDimensions; }
+	IntVec2  GetChunkCoordsForTile( const IntVec2& tileCoords ) const;
+	bool     IsChunkAllWalkable( const IntVec2& tileCoords ) const;
+
+	int64_t  GetTileIndex( const IntVec2& tileCoords ) const;
+	IntVec2  GetTileCoordsForTileIndex( int64_t tileIndex ) const;
+	int64_t  GetNumTiles() const { return (int64_t)m_dimensions.x * (int64_t)m_dimensions.y; }
+	const IntVec2& GetDimensions() const { return m_dimensions; }
+
+private:
+	IntVec2 m_dimensions;
+	IntVec2 m_chunkDimensions;
+	//every chunk is read through m_chunks, which points either into the map file or at the owned copy
+	std::vector<const TileChunk*> m_chunks;
+	std::vector<std::unique_ptr<TileChunk>> m_ownedChunks;
+	//indexed by the raw type byte, so a byte past the tile set in a damaged map file cannot read past the table
+	bool m_isTypeSolid[UINT8_MAX + 1] = {};
+	bool m_areClearancesBuilt = false;
+
+	size_t GetChunkIndex( const IntVec2& tileCoords ) const;
+	int    GetLocalIndex( const IntVec2& tileCoords ) const;
+	void   StartupChunkGrid( const IntVec2& dimensions );
+	TileChunk& GetWritableChunkForTile( const IntVec2& tileCoords );
+	uint8_t ComputeSolidNeighborMask( const IntVec2& tileCoords ) const;
+	uint8_t ComputeClearance( const IntVec2& tileCoords ) const;
+	void    UpdateClearancesAround( const IntVec2& tileCoords );
+};
@@ -0,0 +1,330 @@
+#include "Game/VisibilityField.hpp"
+#include "Game/Map.hpp"
+#include "Game/GameCommon.hpp"
+#include "Game/JobSystem.hpp"
+#include "Engine/Core/ErrorWarningAssert.hpp"
+#include "Engine/Core/StringUtils.hpp"
+#include <algorithm>
+
+//octant transforms for the recursive shadowcasting
+static const int OCTANT_XX[8] = { 1, 0,  0, -1, -1,  0,  0,  1 };
+static const int OCTANT_XY[8] = { 0, 1, -1,  0,  0, -1,  1,  0 };
+static const int OCTANT_YX[8] = { 0, 1,  1,  0,  0, -1, -1,  0 };
+static const int OCTANT_YY[8] = { 1, 0,  0,  1, -1,  0,  0, -1 };
+
+//////////////////////////////////////////////////////////////////////////
+void VisibilityField::Startup( const Map* map, const IntVec2& dimensions, int radius )
+{
+	if( 2 * radius + 1 > 64 )
+		ERROR_AND_DIE( Stringf( "Visibility field radius %d does not fit a 64 bit window row", radius ) );
+	m_map = map;
+	m_dimensions = dimensions;
+	m_radius = radius;
+	m_windowSize = 2 * radius + 1;
+	m_numWordsPerField = m_windowSize;
+
+	m_observerSlotForTile.Startup( dimensions, -1 );
+	m_observerSlots.clear();
+	m_freeSlots.clear();
+	m_observerFields.clear();
+	for( int factionID = 0; factionID < (int)NUM_FACTIONS; factionID++ )
+	{
+		m_factionSeenCounts[factionID].Startup( dimensions, 0 );
+		m_factionFogLevels[factionID].Startup( dimensions, TILE_FOG_UNEXPLORED );
+		m_factionVersions[factionID]++;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+void VisibilityField::BeginUpdate()
+{
+	//slots stay with their tile, only who stands on it is gathered again
+	for( ObserverSlot& observerSlot : m_observerSlots )
+	{
+		observerSlot.m_factionMask = 0;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+void VisibilityField::AddObserver( const IntVec2& observerCoords, EntityFaction faction )
+{
+	if( !IsInBounds( observerCoords ) )
+		return;
+
+	int slot = m_observerSlotForTile.GetValue( observerCoords );
+	if( slot < 0 )
+	{
+		//a tile someone just entered, its field is computed in EndUpdate
+		if( !m_freeSlots.empty() )
+		{
+			slot = m_freeSlots.back();
+			m_freeSlots.pop_back();
+		}
+		else
+		{
+			slot = (int)m_observerSlots.size();
+			m_observerSlots.emplace_back();
+		}
+		m_observerSlotForTile.GetWritableValue( observerCoords ) = slot;
+		m_observerSlots[slot] = ObserverSlot();
+		m_observerSlots[slot].m_tileIndex = GetTileIndex( observerCoords );
+	}
+	if( faction < NUM_FACTIONS )
+		m_observerSlots[slot].m_factionMask |= 1u << (unsigned int)faction;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void VisibilityField::EndUpdate()
+{
+	//factions left a tile, or its field is out of date: take the old field out of their counts
+	//every faction only touches its own counts and masks
+	g_theJobSystem->ParallelFor( (int)NUM_FACTIONS, 1, [this]( int beginFaction, int endFaction )
+	{
+		for( int factionID = beginFaction; factionID < endFaction; factionID++ )
+		{
+			unsigned int factionBit = 1u << (unsigned int)factionID;
+			for( int slot = 0; slot < (int)m_observerSlots.size(); slot++ )
+			{
+				const ObserverSlot& observerSlot = m_observerSlots[slot];
+				unsigned int keptMask = observerSlot.m_isFieldValid ? observerSlot.m_factionMask : 0;
+				if( (observerSlot.m_appliedFactionMask & ~keptMask & factionBit) != 0 )
+					ApplySlotToFaction( slot, (EntityFaction)factionID, -1 );
+			}
+		}
+	} );
+
+	//fields of the tiles that were entered or changed, the buffer only grows
+	m_slotsToCompute.clear();
+	for( int slot = 0; slot < (int)m_observerSlots.size(); slot++ )
+	{
+		ObserverSlot& observerSlot = m_observerSlots[slot];
+		observerSlot.m_appliedFactionMask &= observerSlot.m_isFieldValid ? observerSlot.m_factionMask : 0;
+		if( observerSlot.m_factionMask != 0 && !observerSlot.m_isFieldValid )
+			m_slotsToCompute.push_back( slot );
+	}
+	if( m_observerFields.size() < m_observerSlots.size() * (size_t)m_numWordsPerField )
+		m_observerFields.resize( m_observerSlots.size() * (size_t)m_numWordsPerField );
+	g_theJobSystem->ParallelFor( (int)m_slotsToCompute.size(), 1, [this]( int beginID, int endID )
+	{
+		for( int computeID = beginID; computeID < endID; computeID++ )
+		{
+			int slot = m_slotsToCompute[computeID];
+			uint64_t* windowRows = &m_observerFields[(size_t)slot * m_numWordsPerField];
+			std::fill( windowRows, windowRows + m_numWordsPerField, 0ull );
+			ComputeFieldOfView( GetTileCoordsForTileIndex( m_observerSlots[slot].m_tileIndex ), windowRows );
+			m_observerSlots[slot].m_isFieldValid = true;
+		}
+	} );
+
+	//factions that entered a tile, or whose field was just recomputed
+	g_theJobSystem->ParallelFor( (int)NUM_FACTIONS, 1, [this]( int beginFaction, int endFaction )
+	{
+		for( int factionID = beginFaction; factionID < endFaction; factionID++ )
+		{
+			unsigned int factionBit = 1u << (unsigned int)factionID;
+			for( int slot = 0; slot < (int)m_observerSlots.size(); slot++ )
+			{
+				const ObserverSlot& observerSlot = m_observerSlots[slot];
+				if( (observerSlot.m_factionMask & ~observerSlot.m_appliedFactionMask & factionBit) != 0 )
+					ApplySlotToFaction( slot, (EntityFaction)factionID, 1 );
+			}
+		}
+	} );
+
+	//tiles everyone left give their slot back
+	for( int slot = 0; slot < (int)m_observerSlots.size(); slot++ )
+	{
+		ObserverSlot& observerSlot = m_observerSlots[slot];
+		observerSlot.m_appliedFactionMask = observerSlot.m_factionMask;
+		if( observerSlot.m_tileIndex >= 0 && observerSlot.m_factionMask == 0 )
+		{
+			m_observerSlotForTile.GetWritableValue( GetTileCoordsForTileIndex( observerSlot.m_tileIndex ) ) = -1;
+			observerSlot = ObserverSlot();
+			m_freeSlots.push_back( slot );
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+void VisibilityField::InvalidateRegion( const IntVec2& changedCoords )
+{
+	if( m_map == nullptr )
+		return;
+	//the old field stays until EndUpdate has taken it out of the counts
+	for( int tileY = changedCoords.y - m_radius; tileY <= changedCoords.y + m_radius; tileY++ )
+	{
+		for( int tileX = changedCoords.x - m_radius; tileX <= changedCoords.x + m_radius; tileX++ )
+		{
+			IntVec2 tileCoords( tileX, tileY );
+			if( !IsInBounds( tileCoords ) )
+				continue;
+			int slot = m_observerSlotForTile.GetValue( tileCoords );
+			if( slot >= 0 )
+				m_observerSlots[slot].m_isFieldValid = false;
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool VisibilityField::HasObserverTile( const IntVec2& observerCoords ) const
+{
+	if( !IsInBounds( observerCoords ) )
+		return false;
+	int slot = m_observerSlotForTile.GetValue( observerCoords );
+	return slot >= 0 && m_observerSlots[slot].m_isFieldValid;
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool VisibilityField::IsTileVisibleFrom( const IntVec2& observerCoords, const IntVec2& tileCoords ) const
+{
+	if( !HasObserverTile( observerCoords ) || !IsInBounds( tileCoords ) )
+		return false;
+	int windowX = tileCoords.x - observerCoords.x + m_radius;
+	int windowY = tileCoords.y - observerCoords.y + m_radius;
+	if( windowX < 0 || windowY < 0 || windowX >= m_windowSize || windowY >= m_windowSize )
+		return false;
+	int slot = m_observerSlotForTile.GetValue( observerCoords );
+	return (m_observerFields[(size_t)slot * m_numWordsPerField + windowY] & (1ull << windowX)) != 0;
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool VisibilityField::IsTileVisibleToFaction( const IntVec2& tileCoords, EntityFaction faction ) const
+{
+	if( faction >= NUM_FACTIONS || !IsInBounds( tileCoords ) )
+		return false;
+	return m_factionFogLevels[faction].GetValue( tileCoords ) == TILE_FOG_VISIBLE;
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool VisibilityField::IsTileExploredByFaction( const IntVec2& tileCoords, EntityFaction faction ) const
+{
+	if( faction >= NUM_FACTIONS || !IsInBounds( tileCoords ) )
+		return false;
+	return m_factionFogLevels[faction].GetValue( tileCoords ) >= TILE_FOG_EXPLORED;
+}
+
+//////////////////////////////////////////////////////////////////////////
+TileFogLevel VisibilityField::GetFogLevel( const IntVec2& tileCoords, EntityFaction faction ) const
+{
+	if( faction >= NUM_FACTIONS || !IsInBounds( tileCoords ) )
+		return TILE_FOG_UNEXPLORED;
+	return m_factionFogLevels[faction].GetValue( tileCoords );
+}
+
+//////////////////////////////////////////////////////////////////////////
+int VisibilityField::GetFactionVersion( EntityFaction faction ) const
+{
+	if( faction >= NUM_FACTIONS )
+		return 0;
+	return m_factionVersions[faction];
+}
+
+//////////////////////////////////////////////////////////////////////////
+void VisibilityField::ApplySlotToFaction( int slot, EntityFaction faction, int delta )
+{
+	//a tile turns visible with the first observer tile that sees it and falls back to explored with the last one
+	const uint64_t* windowRows = &m_observerFields[(size_t)slot * m_numWordsPerField];
+	IntVec2 originCoords = GetTileCoordsForTileIndex( m_observerSlots[slot].m_tileIndex );
+	ChunkedTileLayer<uint16_t>& seenCounts = m_factionSeenCounts[faction];
+	ChunkedTileLayer<TileFogLevel>& fogLevels = m_factionFogLevels[faction];
+	for( int windowY = 0; windowY < m_windowSize; windowY++ )
+	{
+		uint64_t rowBits = windowRows[windowY];
+		if( rowBits == 0 )
+			continue;
+		for( int windowX = 0; windowX < m_windowSize; windowX++ )
+		{
+			if( (rowBits & (1ull << windowX)) == 0 )
+				continue;
+			IntVec2 tileCoords( originCoords.x + windowX - m_radius, originCoords.y + windowY - m_radius );
+			uint16_t& seenCount = seenCounts.GetWritableValue( tileCoords );
+			if( delta > 0 )
+			{
+				if( seenCount++ == 0 )
+					fogLevels.GetWritableValue( tileCoords ) = TILE_FOG_VISIBLE;
+			}
+			else if( --seenCount == 0 )
+			{
+				fogLevels.GetWritableValue( tileCoords ) = TILE_FOG_EXPLORED;
+			}
+		}
+	}
+	m_factionVersions[faction]++;
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool VisibilityField::IsInBounds( const IntVec2& tileCoords ) const
+{
+	return tileCoords.x >= 0 && tileCoords.x < m_dimensions.x && tileCoords.y >= 0 && tileCoords.y < m_dimensions.y;
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool VisibilityField::IsOpaque( int tileX, int tileY ) const
+{
+	IntVec2 tileCoords( tileX, tileY );
+	if( !IsInBounds( tileCoords ) )
+		return true;
+	return m_map->IsTileSolid( tileCoords );
+}
+
+//////////////////////////////////////////////////////////////////////////
+void VisibilityField::ComputeFieldOfView( const IntVec2& originCoords, uint64_t* out_windowRows ) const
+{
+	out_windowRows[m_radius] |= 1ull << m_radius;
+	for( int octant = 0; octant < 8; octant++ )
+	{
+		CastLightInOctant( originCoords, 1, 1.f, 0.f, OCTANT_XX[octant], OCTANT_XY[octant], OCTANT_YX[octant], OCTANT_YY[octant], out_windowRows );
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+//recursive shadowcasting, walks the octant row by row and recurses under every run of opaque tiles
+void VisibilityField::CastLightInOctant( const IntVec2& originCoords, int row, float startSlope, float endSlope,
+	int xx, int xy, int yx, int yy, uint64_t* out_windowRows ) const
+{
+	if( startSlope < endSlope )
+		return;
+
+	int radiusSquared = m_radius * m_radius;
+	float nextStartSlope = startSlope;
+	for( int distance = row; distance <= m_radius; distance++ )
+	{
+		bool isBlocked = false;
+		int deltaY = -distance;
+		for( int deltaX = -distance; deltaX <= 0; deltaX++ )
+		{
+			float leftSlope = ((float)deltaX - .5f) / ((float)deltaY + .5f);
+			float rightSlope = ((float)deltaX + .5f) / ((float)deltaY - .5f);
+			if( startSlope < rightSlope )
+				continue;
+			if( endSlope > leftSlope )
+				break;
+
+			int tileX = originCoords.x + deltaX * xx + deltaY * xy;
+			int tileY = originCoords.y + deltaX * yx + deltaY * yy;
+			IntVec2 tileCoords( tileX, tileY );
+			if( deltaX * deltaX + deltaY * deltaY <= radiusSquared && IsInBounds( tileCoords ) )
+				out_windowRows[tileY - originCoords.y + m_radius] |= 1ull << (tileX - originCoords.x + m_radius);
+
+			bool isOpaque = IsOpaque( tileX, tileY );
+			if( isBlocked )
+			{
+				if( isOpaque )
+				{
+					nextStartSlope = rightSlope;
+					continue;
+				}
+				isBlocked = false;
+				startSlope = nextStartSlope;
+			}
+			else if( isOpaque && distance < m_radius )
+			{
+				isBlocked = true;
+				CastLightInOctant( originCoords, distance + 1, startSlope, leftSlope, xx, xy, yx, yy, out_windowRows );
+				nextStartSlope = rightSlope;
+			}
+		}
+		if( isBlocked )
+			break;
+	}
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include "Engine/Math/IntVec2.hpp"
+#include "Game/Entity.hpp"
+#include "Game/ChunkedTileLayer.hpp"
+
+class Map;
+
+//how much of a tile a faction knows, what the renderer darkens by
+enum TileFogLevel : uint8_t
+{
+	TILE_FOG_UNEXPLORED,
+	TILE_FOG_EXPLORED,
+	TILE_FOG_VISIBLE,
+
+	NUM_TILE_FOG_LEVELS
+};
+
+//////////////////////////////////////////////////////////////////////////
+//fog of war: tiles seen by the observers of each faction this tick, and every tile they have ever seen
+//every observer tile gets one shadowcast field of view that all units standing on it share, kept as a window of
+//one bit row per tile row around the observer tile, computed when the first unit enters the tile and kept while any stays
+//faction masks only change where an observer tile gained or lost a faction, a per tile count of the observer tiles
+//of each faction that see it decides when a tile turns visible or falls back to explored
+//per tile state is kept in chunks allocated where observers have been, so a large map costs nothing until it is seen
+//BeginUpdate, AddObserver for every observer, then EndUpdate applies what changed since the last tick
+class VisibilityField
+{
+public:
+	VisibilityField() = default;
+	~VisibilityField() = default;
+
+	void Startup( const Map* map, const IntVec2& dimensions, int radius );
+	void BeginUpdate();
+	void AddObserver( const IntVec2& observerCoords, EntityFaction faction );
+	void EndUpdate();
+	//a changed tile recomputes the fields of the observer tiles within radius at the next EndUpdate
+	void InvalidateRegion( const IntVec2& changedCoords );
+
+	bool HasObserverTile( const IntVec2& observerCoords ) const;
+	bool IsTileVisibleFrom( const IntVec2& observerCoords, const IntVec2& tileCoords ) const;
+	//one chunk lookup each
+	bool IsTileVisibleToFaction( const IntVec2& tileCoords, EntityFaction faction ) const;
+	bool IsTileExploredByFaction( const IntVec2& tileCoords, EntityFaction faction ) const;
+	TileFogLevel GetFogLevel( const IntVec2& tileCoords, EntityFaction faction ) const;
+	//changes whenever a fog level of the faction may have changed
+	int  GetFactionVersion( EntityFaction faction ) const;
+	int  GetNumObserverTiles() const { return (int)m_observerSlots.size() - (int)m_freeSlots.size(); }
+
+private:
+	struct ObserverSlot
+	{
+		int m_tileIndex = -1;
+		//factions standing on the tile this tick, and the factions whose counts hold its field
+		unsigned int m_factionMask = 0;
+		unsigned int m_appliedFactionMask = 0;
+		bool m_isFieldValid = false;
+	};
+
+	const Map* m_map = nullptr;
+	IntVec2 m_dimensions;
+	int m_radius = 0;
+	int m_windowSize = 0;
+	int m_numWordsPerField = 0;
+
+	//observer slot for every tile, -1 when nobody watches from that tile
+	ChunkedTileLayer<int> m_observerSlotForTile;
+	std::vector<ObserverSlot> m_observerSlots;
+	std::vector<int> m_freeSlots;
+	std::vector<int> m_slotsToCompute;
+	//m_windowSize rows per slot, bit x of a row is the tile x - radius from the observer tile
+	std::vector<uint64_t> m_observerFields;
+	ChunkedTileLayer<uint16_t> m_factionSeenCounts[NUM_FACTIONS];
+	ChunkedTileLayer<TileFogLevel> m_factionFogLevels[NUM_FACTIONS];
+	int m_factionVersions[NUM_FACTIONS] = {};
+
+	int  GetTileIndex( const IntVec2& tileCoords ) const { return tileCoords.x + tileCoords.y * m_dimensions.x; }
+	IntVec2 GetTileCoordsForTileIndex( int tileIndex ) const { return IntVec2( tileIndex % m_dimensions.x, tileIndex / m_dimensions.x ); }
+	bool IsInBounds( const IntVec2& tileCoords ) const;
+	bool IsOpaque( int tileX, int tileY ) const;
+	void ApplySlotToFaction( int slot, EntityFaction faction, int delta );
+	void ComputeFieldOfView( const IntVec2& originCoords, uint64_t* out_windowRows ) const;
+	void CastLightInOctant( const IntVec2& originCoords, int row, float startSlope, float endSlope,
+		int xx, int xy, int yx, int yy, uint64_t* out_windowRows ) const;
+};
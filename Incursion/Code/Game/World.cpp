@@ -3,32 +3,84 @@
 #include "Game/Game.hpp"
 #include "Game/Tile.hpp"
 #include "Game/WormDefinition.hpp"
+#include "Game/MapGenerationParams.hpp"
+#include "Game/RenderSnapshot.hpp"
+#include "Engine/Core/EngineCommon.hpp"
+#include "Engine/Core/NamedStrings.hpp"
+#include "Engine/Core/StringUtils.hpp"
+#include "Engine/Core/ErrorWarningAssert.hpp"
+#include "Engine/Math/RandomNumberGenerator.hpp"
+
+//a level with a map file set in GameConfig loads its tiles from it instead of generating them
+//configured files are kept like cached ones, in case one points into the map cache
+static bool LoadConfiguredMapFile( Map* map, int levelNumber, std::vector<std::string>& out_keptFilePaths )
+{
+	std::string mapFilePath = g_gameConfigBlackboard->GetValue( Stringf( "level%dMapFile", levelNumber ), "" );
+	if( mapFilePath.empty() )
+		return false;
+	if( !map->LoadMapFile( mapFilePath ) )
+		ERROR_AND_DIE( Stringf( "Failed to load map file %s for level %d", mapFilePath.c_str(), levelNumber ) );
+	out_keptFilePaths.push_back( mapFilePath );
+	return true;
+}
 
 World::World(Game* game)
 	:m_game(game)
 {
+	//a mapSeed in GameConfig wins, otherwise the seed saved by an earlier launch, otherwise a new one that is saved for the next launches
+	//a kept seed keeps the parameter hashes, so repeat launches load every level from the map cache
+	int mapSeed = g_gameConfigBlackboard->GetValue( "mapSeed", -1 );
+	if( mapSeed < 0 )
+	{
+		uint32_t savedSeed = 0;
+		if( ReadSavedMapSeed( savedSeed ) )
+		{
+			mapSeed = (int)(savedSeed & 0x7FFFFFFF);
+		}
+		else
+		{
+			mapSeed = m_game->m_RNG->RollRandomIntLessThan( 0x7FFFFFFF );
+			SaveMapSeed( (uint32_t)mapSeed );
+		}
+	}
+	DebuggerPrintf( "Map seed %d\n", mapSeed );
+	std::vector<std::string> keptMapFilePaths;
+
 	Map* tempMap = nullptr;
 	//map 1
-	tempMap = new Map( m_game, this, IntVec2( 20, 30 ) );
-	std::vector<WormDefinition> worms;
-	worms.push_back( WormDefinition( TILE_TYPE_STONE, 30, 6 ) );
-	worms.push_back( WormDefinition( TILE_TYPE_MUD, 20, 7 ) );
-	tempMap->GenerateMap( TILE_TYPE_GRASS, TILE_TYPE_STONE, TILE_TYPE_GROUND, TILE_TYPE_GROUND, worms );
+	MapGenerationParams params( (uint32_t)mapSeed, IntVec2( 20, 30 ), TILE_TYPE_GRASS, TILE_TYPE_STONE, TILE_TYPE_GROUND, TILE_TYPE_GROUND );
+	params.m_wormDefs.push_back( WormDefinition( TILE_TYPE_STONE, 30, 6 ) );
+	params.m_wormDefs.push_back( WormDefinition( TILE_TYPE_MUD, 20, 7 ) );
+	tempMap = new Map( m_game, this, params.m_size );
+	if( !LoadConfiguredMapFile( tempMap, 1, keptMapFilePaths ) )
+	{
+		tempMap->LoadOrGenerateMap( params );
+		keptMapFilePaths.push_back( params.GetCacheFilePath() );
+	}
 	m_maps.push_back( tempMap );
 	//map 2
-	tempMap = new Map( m_game, this, IntVec2( 30, 20 ) );
-	worms.clear();
-	worms.push_back( WormDefinition( TILE_TYPE_BRICK, 45, 5 ) );
-	worms.push_back( WormDefinition( TILE_TYPE_SAND, 20, 7 ) );
-	tempMap->GenerateMap( TILE_TYPE_DIRT, TILE_TYPE_BRICK, TILE_TYPE_GROUND, TILE_TYPE_GROUND, worms );
+	params = MapGenerationParams( (uint32_t)mapSeed, IntVec2( 30, 20 ), TILE_TYPE_DIRT, TILE_TYPE_BRICK, TILE_TYPE_GROUND, TILE_TYPE_GROUND );
+	params.m_wormDefs.push_back( WormDefinition( TILE_TYPE_BRICK, 45, 5 ) );
+	params.m_wormDefs.push_back( WormDefinition( TILE_TYPE_SAND, 20, 7 ) );
+	tempMap = new Map( m_game, this, params.m_size );
+	if( !LoadConfiguredMapFile( tempMap, 2, keptMapFilePaths ) )
+	{
+		tempMap->LoadOrGenerateMap( params );
+		keptMapFilePaths.push_back( params.GetCacheFilePath() );
+	}
 	m_maps.push_back( tempMap );
 	//map 3
-	tempMap = new Map( m_game, this, IntVec2( 30, 20 ) );
-	worms.clear();
-	worms.push_back( WormDefinition( TILE_TYPE_STEEL, 65, 5 ) );
-	worms.push_back( WormDefinition( TILE_TYPE_WATER, 30, 7 ) );
-	tempMap->GenerateMap( TILE_TYPE_QUARTZ, TILE_TYPE_STEEL, TILE_TYPE_GROUND, TILE_TYPE_GROUND, worms );
+	params = MapGenerationParams( (uint32_t)mapSeed, IntVec2( 30, 20 ), TILE_TYPE_QUARTZ, TILE_TYPE_STEEL, TILE_TYPE_GROUND, TILE_TYPE_GROUND );
+	params.m_wormDefs.push_back( WormDefinition( TILE_TYPE_STEEL, 65, 5 ) );
+	params.m_wormDefs.push_back( WormDefinition( TILE_TYPE_WATER, 30, 7 ) );
+	tempMap = new Map( m_game, this, params.m_size );
+	if( !LoadConfiguredMapFile( tempMap, 3, keptMapFilePaths ) )
+	{
+		tempMap->LoadOrGenerateMap( params );
+		keptMapFilePaths.push_back( params.GetCacheFilePath() );
+	}
 	m_maps.push_back( tempMap );
+	PruneMapCache( keptMapFilePaths );
 }
 
 World::~World()
@@ -52,7 +104,9 @@ void World::StartLevel()
 	//current
 	m_currentMap = m_maps[0];
 	m_currentMap->StartUp( 5, 5, 30 );//first level setup
-	m_game->m_playerRespawnChances = PLAYER_RESPAWN_TIMES;
+	m_playerRespawnChances = PLAYER_RESPAWN_TIMES;
+	m_hasPlayerWon = false;
+	m_hasPlayerLost = false;
 	m_currentMap->SpawnPlayer( FACTION_GOOD, Vec2( 1.5f, 1.5f ) );
 }
 
@@ -60,7 +114,7 @@ void World::LoadNextLevel()
 {
 	Entity* prevPlayer = nullptr;
 	prevPlayer = m_currentMap->GetPlayerAlive();
-	m_currentMap->m_entityListsByType[ENTITY_TYPE_PLAYER].clear();
+	m_currentMap->DetachPlayer();
 	for( int mapID = 0; mapID < (int)m_maps.size(); mapID++ )
 	{
 		if( m_maps[mapID] == m_currentMap )
@@ -79,7 +133,7 @@ void World::LoadNextLevel()
 			}
 			else//all map is finished, win
 			{
-				m_game->ProgressToState( GAME_STATE_WIN );
+				m_hasPlayerWon = true;
 				return;
 			}
 		}
@@ -94,7 +148,10 @@ void World::Update( float deltaSeconds )
 	m_currentMap->Update( deltaSeconds );
 }
 
-void World::Render() const
+void World::FillRenderSnapshot( RenderSnapshot& snapshot )
 {
-	m_currentMap->Render();
+	snapshot.m_playerRespawnChances = m_playerRespawnChances;
+	snapshot.m_hasPlayerWon = m_hasPlayerWon;
+	snapshot.m_hasPlayerLost = m_hasPlayerLost;
+	m_currentMap->FillRenderSnapshot( snapshot );
 }
@@ -1,9 +1,11 @@
 #pragma once
 
 #include <vector>
+#include "Game/GameCommon.hpp"
 
 class Map;
 class Game;
+struct RenderSnapshot;
 
 class World
 {
@@ -15,9 +17,14 @@ public:
 	void LoadNextLevel();
 
 	void Update( float deltaSeconds );
-	void Render()const;
+	void FillRenderSnapshot( RenderSnapshot& snapshot );
 
 	Map* GetCurrentMap()const { return m_currentMap; }
+
+	//owned by the simulation, the main thread reads them from the render snapshot
+	int  m_playerRespawnChances = PLAYER_RESPAWN_TIMES;
+	bool m_hasPlayerWon = false;
+	bool m_hasPlayerLost = false;
 	
 private:
 	Map* m_currentMap = nullptr;
@@ -0,0 +1,292 @@
+#include "Game/WorldRenderer.hpp"
+#include "Game/GameCommon.hpp"
+#include "Game/RenderSnapshot.hpp"
+#include "Game/TileDefinition.hpp"
+#include "Game/FrameArena.hpp"
+#include "Engine/Renderer/RenderContext.hpp"
+#include "Engine/Math/MathUtils.hpp"
+#include "Engine/Math/AABB2.hpp"
+
+//////////////////////////////////////////////////////////////////////////
+//texture of one entity layer, shared by every entity of one type and faction
+static Texture* GetEntityTexture( EntityType type, EntityFaction faction, bool isTopLayer )
+{
+	switch( type )
+	{
+		case ENTITY_TYPE_PLAYER:
+		{
+			return g_theRenderer->CreateOrGetTextureFromFile( isTopLayer ? "Data/Images/PlayerTankTop.png" : "Data/Images/PlayerTankBase.png" );
+		}
+		case ENTITY_TYPE_NPC_TANK:
+		{
+			if( faction == FACTION_EVIL )	return g_theRenderer->CreateOrGetTextureFromFile( "Data/Images/EnemyTank4.png" );
+			if( faction == FACTION_GOOD )	return g_theRenderer->CreateOrGetTextureFromFile( "Data/Images/FriendlyTank4.png" );
+			break;
+		}
+		case ENTITY_TYPE_NPC_TURRET:
+		{
+			if( faction == FACTION_EVIL )
+				return g_theRenderer->CreateOrGetTextureFromFile( isTopLayer ? "Data/Images/EnemyTurretTop.png" : "Data/Images/EnemyTurretBase.png" );
+			if( faction == FACTION_GOOD )
+				return g_theRenderer->CreateOrGetTextureFromFile( isTopLayer ? "Data/Images/FriendlyTurretTop.png" : "Data/Images/FriendlyTurretBase.png" );
+			break;
+		}
+		case ENTITY_TYPE_GOOD_BULLET:
+		case ENTITY_TYPE_EVIL_BULLET:
+		{
+			if( faction == FACTION_EVIL )	return g_theRenderer->CreateOrGetTextureFromFile( "Data/Images/EnemyBullet.png" );
+			if( faction == FACTION_GOOD )	return g_theRenderer->CreateOrGetTextureFromFile( "Data/Images/FriendlyBullet.png" );
+			break;
+		}
+		case ENTITY_TYPE_BOULDER:
+		case ENTITY_TYPE_BOMB:
+		case ENTITY_TYPE_PICKUP:	return g_theRenderer->CreateOrGetTextureFromFile( "Data/Images/Extras_4x4.png" );
+		case ENTITY_TYPE_EXPLOSION:	return g_theRenderer->CreateOrGetTextureFromFile( "Data/Images/Explosion_5x5.png" );
+	}
+	return nullptr;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void WorldRenderer::Render( const RenderSnapshot& snapshot )
+{
+	UpdateTileMesh( snapshot );
+	RenderTiles();
+	UpdateTileFogMesh( snapshot );
+	RenderTileFog();
+	RenderEntities( snapshot );
+	if( g_isDebugDrawing )
+		DebugRender( snapshot );
+}
+
+//////////////////////////////////////////////////////////////////////////
+void WorldRenderer::UpdateTileMesh( const RenderSnapshot& snapshot )
+{
+	if( snapshot.m_tileMeshVersion == m_tileMeshVersion )
+		return;
+
+	//keep the tile types alive as long as the mesh built from them
+	m_tileMeshVersion = snapshot.m_tileMeshVersion;
+	m_tileTypes = snapshot.m_tileTypes;
+	for( int tileTypeID = 0; tileTypeID < NUM_TILE_TYPE; tileTypeID++ )
+	{
+		m_tileVertsByType[tileTypeID].clear();
+	}
+	if( m_tileTypes == nullptr )
+		return;
+
+	const std::vector<TileType>& tileTypes = *m_tileTypes;
+	for( int tID = 0; tID < (int)tileTypes.size(); tID++ )
+	{
+		Tile tile( snapshot.m_tileWindowMins.x + tID % snapshot.m_tileWindowSize.x, snapshot.m_tileWindowMins.y + tID / snapshot.m_tileWindowSize.x );
+		tile.m_type = tileTypes[tID];
+		tile.AppendVerts( m_tileVertsByType[tile.m_type] );
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+void WorldRenderer::RenderTiles() const
+{
+	for( int tileTypeID = 0; tileTypeID < NUM_TILE_TYPE; tileTypeID++ )
+	{
+		const std::vector<Vertex_PCU>& tileVerts = m_tileVertsByType[tileTypeID];
+		if( tileVerts.empty() )
+			continue;
+
+		const Texture& thisTexture = TileDefinition::s_definitions[tileTypeID].m_texture;
+		g_theRenderer->BindDiffuseTexture( &thisTexture );
+		g_theRenderer->DrawVertexArray( tileVerts );
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+void WorldRenderer::UpdateTileFogMesh( const RenderSnapshot& snapshot )
+{
+	if( snapshot.m_tileFogVersion == m_tileFogVersion )
+		return;
+
+	m_tileFogVersion = snapshot.m_tileFogVersion;
+	m_tileFogVerts.clear();
+	if( snapshot.m_tileFogLevels == nullptr )
+		return;
+
+	const std::vector<TileFogLevel>& fogLevels = *snapshot.m_tileFogLevels;
+	const IntVec2& windowSize = snapshot.m_tileWindowSize;
+	for( int localY = 0; localY < windowSize.y; localY++ )
+	{
+		const TileFogLevel* rowLevels = fogLevels.data() + (size_t)localY * (size_t)windowSize.x;
+		int runStartX = 0;
+		for( int localX = 1; localX <= windowSize.x; localX++ )
+		{
+			if( localX < windowSize.x && rowLevels[localX] == rowLevels[runStartX] )
+				continue;
+			if( rowLevels[runStartX] != TILE_FOG_VISIBLE )
+			{
+				Vec2 runMins( (float)(snapshot.m_tileWindowMins.x + runStartX), (float)(snapshot.m_tileWindowMins.y + localY) );
+				Vec2 runMaxs( (float)(snapshot.m_tileWindowMins.x + localX), runMins.y + 1.f );
+				unsigned char alpha = rowLevels[runStartX] == TILE_FOG_EXPLORED ? FOG_EXPLORED_ALPHA : FOG_UNEXPLORED_ALPHA;
+				AppendVertsForAABB2D( m_tileFogVerts, AABB2( runMins, runMaxs ), Vec2( 0.f, 0.f ), Vec2( 1.f, 1.f ), Rgba8( 0, 0, 0, alpha ) );
+			}
+			runStartX = localX;
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+void WorldRenderer::RenderTileFog() const
+{
+	if( m_tileFogVerts.empty() )
+		return;
+	g_theRenderer->BindDiffuseTexture( (Texture*)nullptr );
+	g_theRenderer->DrawVertexArray( m_tileFogVerts );
+}
+
+//////////////////////////////////////////////////////////////////////////
+void WorldRenderer::RenderEntities( const RenderSnapshot& snapshot )
+{
+	for( int entityTypeID = 0; entityTypeID < (int)NUM_ENTITY_TYPES; entityTypeID++ )
+	{
+		EntityType type = (EntityType)entityTypeID;
+		if( entityTypeID == (int)NUM_ENTITY_TYPES - 1 )
+			g_theRenderer->SetBlendMode( eBlendMode::BLEND_ADDITIVE );
+		if( IsEntityTypeBatched( type ) )
+		{
+			RenderEntityTypeBatched( snapshot, type );
+		}
+		else
+		{
+			const EntityRenderState* states = snapshot.GetFirstEntityOfType( type );
+			for( int sID = 0; sID < snapshot.GetNumEntitiesOfType( type ); sID++ )
+			{
+				RenderEntity( states[sID] );
+			}
+		}
+		if( entityTypeID == (int)NUM_ENTITY_TYPES - 1 )
+			g_theRenderer->SetBlendMode( eBlendMode::BLEND_ALPHA );
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool WorldRenderer::IsEntityTypeBatched( EntityType type ) const
+{
+	//types whose quads only differ in position and orientation
+	return type == ENTITY_TYPE_NPC_TANK || type == ENTITY_TYPE_NPC_TURRET || type == ENTITY_TYPE_BOULDER
+		|| type == ENTITY_TYPE_GOOD_BULLET || type == ENTITY_TYPE_EVIL_BULLET;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void WorldRenderer::RenderEntityTypeBatched( const RenderSnapshot& snapshot, EntityType type )
+{
+	for( int factionID = 0; factionID < (int)NUM_FACTIONS; factionID++ )
+	{
+		RenderEntityBatchForFaction( snapshot, type, (EntityFaction)factionID, false );
+	}
+	if( type != ENTITY_TYPE_NPC_TANK && type != ENTITY_TYPE_NPC_TURRET )
+		return;
+
+	const EntityRenderState* states = snapshot.GetFirstEntityOfType( type );
+	int numStates = snapshot.GetNumEntitiesOfType( type );
+	if( type == ENTITY_TYPE_NPC_TURRET )
+	{
+		//lasers go between turret base and turret top
+		g_theRenderer->BindDiffuseTexture( (Texture*)nullptr );
+		for( int sID = 0; sID < numStates; sID++ )
+		{
+			if( states[sID].m_hasLaser )
+				g_theRenderer->DrawLine2D( states[sID].m_position, states[sID].m_laserEnd, LINE_THICKNESS, Rgba8( 255, 0, 0 ) );
+		}
+		for( int factionID = 0; factionID < (int)NUM_FACTIONS; factionID++ )
+		{
+			RenderEntityBatchForFaction( snapshot, type, (EntityFaction)factionID, true );
+		}
+	}
+	for( int sID = 0; sID < numStates; sID++ )
+	{
+		RenderHealthBar( states[sID] );
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+void WorldRenderer::RenderEntityBatchForFaction( const RenderSnapshot& snapshot, EntityType type, EntityFaction faction, bool isTopLayer )
+{
+	m_entityBatch.Clear();
+	const EntityRenderState* quadState = nullptr;
+	const EntityRenderState* states = snapshot.GetFirstEntityOfType( type );
+	for( int sID = 0; sID < snapshot.GetNumEntitiesOfType( type ); sID++ )
+	{
+		const EntityRenderState& state = states[sID];
+		if( state.m_faction != faction || state.m_numVerts == 0 )
+			continue;
+		if( quadState == nullptr )
+			quadState = &state;
+		float orientation = isTopLayer ? state.m_topOrientationDegrees : state.m_orientationDegrees;
+		m_entityBatch.AddInstance( state.m_position, orientation, 1.f, state.m_verts[0].m_color );
+	}
+	if( quadState == nullptr )
+		return;
+
+	//every entity of the same type shares the same quad
+	VertexSpan batchVerts = m_entityBatch.GetTransformedVerts( quadState->m_numVerts, quadState->m_verts );
+	g_theRenderer->BindDiffuseTexture( GetEntityTexture( type, faction, isTopLayer ) );
+	g_theRenderer->DrawVertexArray( batchVerts.m_size, batchVerts.m_verts );
+}
+
+//////////////////////////////////////////////////////////////////////////
+void WorldRenderer::RenderEntity( const EntityRenderState& state ) const
+{
+	RenderEntityLayer( state, state.m_orientationDegrees, GetEntityTexture( state.m_type, state.m_faction, false ) );
+	if( state.m_hasTopLayer )
+		RenderEntityLayer( state, state.m_topOrientationDegrees, GetEntityTexture( state.m_type, state.m_faction, true ) );
+	RenderHealthBar( state );
+}
+
+//////////////////////////////////////////////////////////////////////////
+void WorldRenderer::RenderEntityLayer( const EntityRenderState& state, float orientationDegrees, Texture* texture ) const
+{
+	if( state.m_numVerts == 0 )
+		return;
+
+	VertexSpan drawVerts = AllocateFrameVerts( state.m_numVerts );
+	for( int vID = 0; vID < state.m_numVerts; vID++ )
+	{
+		drawVerts.PushBack( state.m_verts[vID] );
+	}
+	TransformVertexArray( drawVerts.m_size, drawVerts.m_verts, 1.f, orientationDegrees, state.m_position );
+	g_theRenderer->BindDiffuseTexture( texture );
+	g_theRenderer->DrawVertexArray( drawVerts.m_size, drawVerts.m_verts );
+}
+
+//////////////////////////////////////////////////////////////////////////
+void WorldRenderer::RenderHealthBar( const EntityRenderState& state ) const
+{
+	if( !state.m_hasHealthBar )
+		return;
+
+	g_theRenderer->BindDiffuseTexture( (Texture*)nullptr );
+	Vec2 healthBarLeft = state.m_position + Vec2( -HEALTH_BAR_LENGTH * .5f, state.m_cosmeticRadius );
+	g_theRenderer->DrawLine2D( healthBarLeft, healthBarLeft + Vec2( HEALTH_BAR_LENGTH * state.m_healthFraction, 0.f ), 5 * LINE_THICKNESS, Rgba8( 255, 0, 0 ) );
+}
+
+//////////////////////////////////////////////////////////////////////////
+void WorldRenderer::DebugRender( const RenderSnapshot& snapshot ) const
+{
+	g_theRenderer->BindDiffuseTexture( (Texture*)nullptr );
+	Rgba8 cyan = Rgba8( 0, 255, 255 );
+	Rgba8 magenta = Rgba8( 255, 0, 255 );
+	Rgba8 yello = Rgba8( 255, 255, 0 );
+	for( const EntityRenderState& state : snapshot.m_entities )
+	{
+		g_theRenderer->DrawRing2D( state.m_position, state.m_physicsRadius, LINE_THICKNESS, cyan );
+		g_theRenderer->DrawRing2D( state.m_position, state.m_cosmeticRadius, LINE_THICKNESS, magenta );
+		g_theRenderer->DrawLine2D( state.m_position, state.m_position + state.m_velocity, LINE_THICKNESS, yello );
+
+		if( state.m_hasDebugGoal )
+		{
+			g_theRenderer->DrawLine2D( state.m_position, state.m_debugGoalPos, LINE_THICKNESS, Rgba8( 255, 0, 0 ) );
+			g_theRenderer->DrawDisc2D( state.m_debugGoalPos, .2f, Rgba8( 255, 0, 0 ) );
+		}
+		for( int lineID = 0; lineID < state.m_numDebugLines; lineID++ )
+		{
+			g_theRenderer->DrawLine2D( state.m_debugLineStarts[lineID], state.m_debugLineEnds[lineID], LINE_THICKNESS, state.m_debugLineColors[lineID] );
+		}
+	}
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include "Game/Entity.hpp"
+#include "Game/Tile.hpp"
+#include "Game/QuadBatch.hpp"
+#include "Engine/Core/Vertex_PCU.hpp"
+
+struct RenderSnapshot;
+struct EntityRenderState;
+class Texture;
+
+//////////////////////////////////////////////////////////////////////////
+//draws the world from render snapshots only, so it never reads state the simulation thread is writing
+class WorldRenderer
+{
+public:
+	WorldRenderer() = default;
+	~WorldRenderer() = default;
+
+	void Render( const RenderSnapshot& snapshot );
+
+private:
+	//tile mesh is rebuilt only when the snapshot carries a new tile mesh version
+	int m_tileMeshVersion = 0;
+	std::shared_ptr<const std::vector<TileType>> m_tileTypes;
+	std::vector<Vertex_PCU> m_tileVertsByType[NUM_TILE_TYPE];
+	//one dark quad per run of equally fogged tiles in a row, rebuilt with the fog version
+	int m_tileFogVersion = 0;
+	std::vector<Vertex_PCU> m_tileFogVerts;
+	QuadBatch m_entityBatch;
+
+	void UpdateTileMesh( const RenderSnapshot& snapshot );
+	void RenderTiles() const;
+	void UpdateTileFogMesh( const RenderSnapshot& snapshot );
+	void RenderTileFog() const;
+	void RenderEntities( const RenderSnapshot& snapshot );
+	void RenderEntityTypeBatched( const RenderSnapshot& snapshot, EntityType type );
+	void RenderEntityBatchForFaction( const RenderSnapshot& snapshot, EntityType type, EntityFaction faction, bool isTopLayer );
+	void RenderEntity( const EntityRenderState& state ) const;
+	void RenderEntityLayer( const EntityRenderState& state, float orientationDegrees, Texture* texture ) const;
+	void RenderHealthBar( const EntityRenderState& state ) const;
+	void DebugRender( const RenderSnapshot& snapshot ) const;
+	bool IsEntityTypeBatched( EntityType type ) const;
+};